@@ -0,0 +1,74 @@
+#include "AtomicSnapshot.h"
+#include "ThreadSafe.h"
+
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+// Thread 0 publishes a new snapshot every iteration, all other threads read. This mimics the I/O thread
+// publishing maps while planner threads look at them.
+
+namespace
+{
+  using Value = std::shared_ptr<const int>;
+
+  Bot::ThreadSafe<Value> threadSafeValue(std::make_shared<const int>(0));
+  Bot::AtomicSnapshot<int> atomicSnapshot(std::make_shared<const int>(0));
+
+  void BM_ThreadSafeReadWhilePublishing(benchmark::State& state)
+  {
+    const auto next = std::make_shared<const int>(state.thread_index());
+    for(auto _: state)
+    {
+      if(state.thread_index() == 0)
+      {
+        threadSafeValue.Lock() = next;
+      }
+      else
+      {
+        benchmark::DoNotOptimize(*threadSafeValue.Get());
+      }
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  void BM_AtomicSnapshotReadWhilePublishing(benchmark::State& state)
+  {
+    const auto next = std::make_shared<const int>(state.thread_index());
+    for(auto _: state)
+    {
+      if(state.thread_index() == 0)
+      {
+        atomicSnapshot.Set(next);
+      }
+      else
+      {
+        benchmark::DoNotOptimize(*atomicSnapshot.Get());
+      }
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  void BM_ThreadSafeRead(benchmark::State& state)
+  {
+    for(auto _: state)
+    {
+      benchmark::DoNotOptimize(*threadSafeValue.Get());
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  void BM_AtomicSnapshotRead(benchmark::State& state)
+  {
+    for(auto _: state)
+    {
+      benchmark::DoNotOptimize(*atomicSnapshot.Get());
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+} // namespace
+
+BENCHMARK(BM_ThreadSafeReadWhilePublishing)->ThreadRange(2, 16)->UseRealTime();
+BENCHMARK(BM_AtomicSnapshotReadWhilePublishing)->ThreadRange(2, 16)->UseRealTime();
+BENCHMARK(BM_ThreadSafeRead)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_AtomicSnapshotRead)->ThreadRange(1, 16)->UseRealTime();
@@ -0,0 +1,71 @@
+#include "ForwardModel.h"
+
+#include <array>
+
+#include <benchmark/benchmark.h>
+
+// Rollout throughput: random walks through a room with a few enemies, boulders and a door behind a pressure plate.
+
+namespace
+{
+  using Bot::ForwardModel;
+  using Swoq::Interface::DirectedAction;
+  using Swoq::Interface::GameStatus;
+  using Swoq::Interface::Tile;
+
+  ForwardModel CreateModel()
+  {
+    constexpr int Size = 31;
+    Vector2d<Tile> map(Size, Size, Tile::TILE_EMPTY);
+    for(int i = 0; i < Size; ++i)
+    {
+      map[Offset{i, 0}] = map[Offset{i, Size - 1}] = map[Offset{0, i}] = map[Offset{Size - 1, i}] = Tile::TILE_WALL;
+    }
+    for(int i = 3; i < Size - 3; i += 4)
+    {
+      map[Offset{i, 5}] = Tile::TILE_BOULDER;
+    }
+    map[Offset{25, 25}] = Tile::TILE_ENEMY;
+    map[Offset{5, 25}] = Tile::TILE_ENEMY;
+    map[Offset{15, 15}] = Tile::TILE_PRESSURE_PLATE_RED;
+    map[Offset{28, 28}] = Tile::TILE_DOOR_RED;
+    map[Offset{29, 29}] = Tile::TILE_EXIT;
+
+    const std::array players{ForwardModel::PlayerStart{{2, 2}}};
+    return ForwardModel::Create(map, players, 5).value();
+  }
+
+  void BM_ForwardModelStep(benchmark::State& state)
+  {
+    const auto model = CreateModel();
+    auto simulated = model.Initial();
+    std::uint32_t random = 12345;
+    for(auto _: state)
+    {
+      random = random * 1664525u + 1013904223u;
+      const auto action = static_cast<DirectedAction>(1 + (random >> 24) % 8);
+      model.Step(simulated, action);
+      if(simulated.status != GameStatus::GAME_STATUS_ACTIVE)
+      {
+        simulated = model.Initial();
+      }
+    }
+    benchmark::DoNotOptimize(simulated);
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  void BM_ForwardModelClone(benchmark::State& state)
+  {
+    const auto model = CreateModel();
+    const auto& initial = model.Initial();
+    for(auto _: state)
+    {
+      auto clone = initial.Clone();
+      benchmark::DoNotOptimize(clone);
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+} // namespace
+
+BENCHMARK(BM_ForwardModelStep);
+BENCHMARK(BM_ForwardModelClone);
@@ -0,0 +1,293 @@
+#include "Dijkstra.h"
+#include "DungeonGenerator.h"
+#include "DungeonMap.h"
+#include "Map.h"
+#include "PlayerMap.h"
+#include "ThreadSafe.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+// The searches and map operations of every tick, on random square maps. The first argument is the width of the map, the
+// second the percentage of cells that is a wall. The names of the runs contain both, so the JSON output of two builds can
+// be compared run by run, e.g. with compare.py from Google Benchmark. The Dungeon benchmarks use the generated dungeons
+// instead, the first argument is the DungeonStyle.
+
+namespace
+{
+  using namespace Bot;
+  using Swoq::Interface::Tile;
+
+  constexpr int Visibility = 4;
+
+  void MapSizesAndDensities(benchmark::internal::Benchmark* benchmark)
+  {
+    benchmark->ArgsProduct({{16, 32, 64, 128}, {0, 20, 40}})->ArgNames({"size", "density"});
+  }
+
+  void MapSizes(benchmark::internal::Benchmark* benchmark) { benchmark->RangeMultiplier(2)->Range(16, 128)->ArgName("size"); }
+
+  void DungeonStylesAndSizes(benchmark::internal::Benchmark* benchmark)
+  {
+    benchmark->ArgsProduct({benchmark::CreateDenseRange(0, static_cast<int>(DungeonStyleNames.size()) - 1, 1), {63, 255}})
+      ->ArgNames({"style", "size"});
+  }
+
+  GeneratedDungeon Dungeon(const benchmark::State& state)
+  {
+    const int size = static_cast<int>(state.range(1));
+    return GenerateDungeon(static_cast<DungeonStyle>(state.range(0)), Offset{size, size}, 1);
+  }
+
+  class Random
+  {
+  public:
+    explicit Random(std::uint32_t seed)
+      : m_state(seed)
+    {
+    }
+
+    int Percentage()
+    {
+      m_state = m_state * 1664525u + 1013904223u;
+      return static_cast<int>((m_state >> 16) % 100);
+    }
+
+  private:
+    std::uint32_t m_state;
+  };
+
+  Offset Center(const Vector2dBase& map) { return Offset{map.Width() / 2, map.Height() / 2}; }
+
+  // Walls along the border and with the given density inside, a few boulders, and an empty center
+  std::shared_ptr<PlayerMap> RandomMap(int size, int density)
+  {
+    auto map = std::make_shared<PlayerMap>(Offset{size, size});
+    Random random(static_cast<std::uint32_t>(size * 100 + density));
+    for(const auto offset: OffsetsInRectangle(map->Size()))
+    {
+      const bool border = offset.x == 0 || offset.y == 0 || offset.x == size - 1 || offset.y == size - 1;
+      const int roll = random.Percentage();
+      (*map)[offset] = border || roll < density ? Tile::TILE_WALL : roll < density + 2 ? Tile::TILE_BOULDER : Tile::TILE_EMPTY;
+    }
+    (*map)[Center(*map)] = Tile::TILE_EMPTY;
+    return map;
+  }
+
+  Vector2d<int> Weights(const PlayerMap& map) { return WeightMap(0, map, map.enemies, map.NavigationParameters()); }
+
+  // What a player at position sees of the map
+  Vector2d<Tile> ViewAt(const Vector2d<Tile>& map, Offset position)
+  {
+    Vector2d<Tile> view(2 * Visibility + 1, 2 * Visibility + 1, Tile::TILE_UNKNOWN);
+    const MapViewCoordinateConverter convert(position, Visibility, view);
+    for(const auto p: OffsetsInRectangle(view.Size()))
+    {
+      if(map.IsInRange(convert.ToMap(p)))
+        view[p] = map[convert.ToMap(p)];
+    }
+    return view;
+  }
+
+  void SetMapCounters(benchmark::State& state, const Vector2dBase& map)
+  {
+    state.SetItemsProcessed(state.iterations() * map.Width() * map.Height());
+    state.counters["cells"] = map.Width() * map.Height();
+  }
+
+  void BM_WeightMap(benchmark::State& state)
+  {
+    const auto map = RandomMap(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    for(auto _: state)
+    {
+      benchmark::DoNotOptimize(Weights(*map));
+    }
+    SetMapCounters(state, *map);
+  }
+
+  void BM_DistanceMap(benchmark::State& state)
+  {
+    const auto map = RandomMap(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    const auto weights = Weights(*map);
+    for(auto _: state)
+    {
+      benchmark::DoNotOptimize(DistanceMap(weights, Center(*map)));
+    }
+    SetMapCounters(state, *map);
+  }
+
+  // From the center to the corner, or everything reachable when the walls are in the way
+  void BM_ReversedPath(benchmark::State& state)
+  {
+    const auto map = RandomMap(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    const auto weights = Weights(*map);
+    const Offset corner{1, 1};
+    for(auto _: state)
+    {
+      benchmark::DoNotOptimize(ReversedPath(weights, Center(*map), [corner](Offset p) { return p == corner; }));
+    }
+    SetMapCounters(state, *map);
+  }
+
+  // The view adds nothing new, so Update only compares
+  void BM_PlayerMapCompare(benchmark::State& state)
+  {
+    const auto map = RandomMap(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    const auto view = ViewAt(*map, Center(*map));
+    for(auto _: state)
+    {
+      benchmark::DoNotOptimize(map->Update(0, Center(*map), Visibility, view));
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  // The view is all new, so Update compares, copies the map and writes the view
+  void BM_PlayerMapUpdate(benchmark::State& state)
+  {
+    const auto truth = RandomMap(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    const auto view = ViewAt(*truth, Center(*truth));
+    const auto unexplored = std::make_shared<const PlayerMap>(truth->Size());
+    for(auto _: state)
+    {
+      benchmark::DoNotOptimize(unexplored->Update(0, Center(*truth), Visibility, view));
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  void BM_DungeonMapUpdate(benchmark::State& state)
+  {
+    const auto truth = RandomMap(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    const auto view = ViewAt(*truth, Center(*truth));
+    const auto unexplored = DungeonMap::Create(truth->Size());
+    for(auto _: state)
+    {
+      benchmark::DoNotOptimize(unexplored->Update(Center(*truth), Visibility, view));
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  // Growing the map when the view reaches beyond it
+  void BM_NewMapData(benchmark::State& state)
+  {
+    const auto map = RandomMap(static_cast<int>(state.range(0)), 20);
+    const auto newSize = map->Size() + Offset{Visibility, Visibility};
+    for(auto _: state)
+    {
+      benchmark::DoNotOptimize(NewMapData(*map, newSize));
+    }
+    SetMapCounters(state, *map);
+  }
+
+  void BM_IsGoodBoulder(benchmark::State& state)
+  {
+    const auto map = RandomMap(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    std::vector<Offset> positions;
+    for(const auto offset: OffsetsInRectangle(map->Size()))
+      positions.push_back(offset);
+
+    for(auto _: state)
+    {
+      int good = 0;
+      for(const auto position: positions)
+        good += map->IsGoodBoulder(position) ? 1 : 0;
+      benchmark::DoNotOptimize(good);
+    }
+    SetMapCounters(state, *map);
+  }
+
+  // The walls of a map, like the boulders and door locations the commands keep
+  void BM_OffsetSet(benchmark::State& state)
+  {
+    const auto map = RandomMap(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    std::vector<Offset> walls;
+    for(const auto offset: OffsetsInRectangle(map->Size()))
+    {
+      if((*map)[offset] == Tile::TILE_WALL)
+        walls.push_back(offset);
+    }
+
+    for(auto _: state)
+    {
+      OffsetSet set(walls.begin(), walls.end());
+      int found = 0;
+      for(const auto offset: OffsetsInRectangle(map->Size()))
+        found += set.contains(offset) ? 1 : 0;
+      for(const auto wall: walls)
+        set.erase(wall);
+      benchmark::DoNotOptimize(found);
+    }
+    SetMapCounters(state, *map);
+  }
+
+  // From the start of a generated dungeon, to everything reachable
+  void BM_DungeonDistanceMap(benchmark::State& state)
+  {
+    const auto dungeon = Dungeon(state);
+    auto map = std::make_shared<PlayerMap>(dungeon.tiles.Size());
+    for(const auto offset: OffsetsInRectangle(map->Size()))
+      (*map)[offset] = dungeon.tiles[offset];
+    const auto weights = Weights(*map);
+    for(auto _: state)
+    {
+      benchmark::DoNotOptimize(DistanceMap(weights, dungeon.start));
+    }
+    state.SetLabel(DungeonStyleNames[static_cast<std::size_t>(state.range(0))]);
+    SetMapCounters(state, *map);
+  }
+
+  // Exploring a generated dungeon: the views of a walk, one Update per step, starting from an unknown map
+  void BM_DungeonExploration(benchmark::State& state)
+  {
+    constexpr std::size_t Steps = 500;
+    const auto dungeon = Dungeon(state);
+    const auto walk = GenerateWalk(dungeon, Visibility, Steps, 1);
+    const auto unexplored = std::make_shared<const PlayerMap>(dungeon.tiles.Size());
+    for(auto _: state)
+    {
+      PlayerMap::Ptr map = unexplored;
+      for(const auto& [position, view]: walk)
+        map = map->Update(0, position, Visibility, view);
+      benchmark::DoNotOptimize(map);
+    }
+    state.SetLabel(DungeonStyleNames[static_cast<std::size_t>(state.range(0))]);
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(walk.size()));
+  }
+
+  Bot::ThreadSafe<Offset> threadSafeOffset(Offset{0, 0});
+
+  void BM_ThreadSafeGet(benchmark::State& state)
+  {
+    for(auto _: state)
+    {
+      benchmark::DoNotOptimize(threadSafeOffset.Get());
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  void BM_ThreadSafeLock(benchmark::State& state)
+  {
+    int i = 0;
+    for(auto _: state)
+    {
+      threadSafeOffset.Lock() = Offset{++i, 0};
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+} // namespace
+
+BENCHMARK(BM_WeightMap)->Apply(MapSizesAndDensities);
+BENCHMARK(BM_DistanceMap)->Apply(MapSizesAndDensities);
+BENCHMARK(BM_ReversedPath)->Apply(MapSizesAndDensities);
+BENCHMARK(BM_PlayerMapCompare)->Apply(MapSizesAndDensities);
+BENCHMARK(BM_PlayerMapUpdate)->Apply(MapSizesAndDensities);
+BENCHMARK(BM_DungeonMapUpdate)->Apply(MapSizesAndDensities);
+BENCHMARK(BM_NewMapData)->Apply(MapSizes);
+BENCHMARK(BM_IsGoodBoulder)->Apply(MapSizesAndDensities);
+BENCHMARK(BM_OffsetSet)->Apply(MapSizesAndDensities);
+BENCHMARK(BM_DungeonDistanceMap)->Apply(DungeonStylesAndSizes);
+BENCHMARK(BM_DungeonExploration)->Apply(DungeonStylesAndSizes);
+BENCHMARK(BM_ThreadSafeGet)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_ThreadSafeLock)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <iterator>
+#include <map>
+#include <print>
+#include <set>
+#include <vector>
+
+#include "Dotenv.hpp"
+#include "DungeonMap.h"
+#include "Game.h"
+#include "Player.h"
+#include "PlayerMap.h"
+#include "Replay.hpp"
+#include "TaskPool.h"
+
+// Feeds every tick of the replays in SWOQ_REPLAYS_FOLDER through the map update and planning code, and reports per level
+// how long each phase took. The planning phases search for the nearest unexplored tile, like Explore does.
+
+namespace
+{
+  using namespace Bot;
+  using Clock = std::chrono::steady_clock;
+  namespace fs = std::filesystem;
+
+  enum class Phase : std::uint8_t
+  {
+    UpdateMap,
+    WeightMap,
+    ReversedPath,
+    Assess,
+  };
+
+  constexpr std::array PhaseNames{"UpdateMap", "WeightMap", "ReversedPath", "Assess"};
+  constexpr std::size_t PhaseCount = PhaseNames.size();
+
+  using Samples = std::array<std::vector<Clock::duration>, PhaseCount>;
+
+  class Timer
+  {
+  public:
+    Timer(Samples& samples, Phase phase)
+      : m_samples(samples[static_cast<std::size_t>(phase)])
+    {
+    }
+    ~Timer() { m_samples.push_back(Clock::now() - m_start); }
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+  private:
+    std::vector<Clock::duration>& m_samples;
+    Clock::time_point m_start = Clock::now();
+  };
+
+  class LevelReplayer
+  {
+  public:
+    LevelReplayer(TaskPool& taskPool, Offset mapSize, int visibility)
+      : m_taskPool(taskPool)
+      , m_mapSize(mapSize)
+      , m_visibility(visibility)
+    {
+      Reset();
+    }
+
+    void Tick(const Swoq::Interface::State& state, Samples& samples)
+    {
+      if(state.level() != m_level)
+      {
+        m_level = state.level();
+        Reset();
+      }
+
+      UpdateMap(state, samples);
+
+      for(auto& player: m_players)
+      {
+        if(!player.active)
+          continue;
+
+        std::set tiles{Tile::TILE_UNKNOWN, Tile::TILE_HEALTH};
+        if(!player.hasSword)
+          tiles.insert(Tile::TILE_SWORD);
+        auto isTarget = [&map = *m_map, &tiles](Offset p) { return tiles.contains(map[p]); };
+
+        std::optional<Vector2d<int>> weights;
+        {
+          Timer timer(samples, Phase::WeightMap);
+          weights = WeightMap(player.playerId, *m_map, m_map->enemies, m_map->NavigationParameters(), isTarget);
+        }
+        {
+          Timer timer(samples, Phase::ReversedPath);
+          player.reversedPath = ReversedPath(*weights, player.position, isTarget);
+        }
+      }
+
+      {
+        Timer timer(samples, Phase::Assess);
+        Assess(m_taskPool, *m_map, *m_dungeonMap, m_players);
+      }
+    }
+
+  private:
+    void Reset()
+    {
+      m_dungeonMap = DungeonMap::Create(m_mapSize);
+      m_map = std::make_shared<PlayerMap>(m_mapSize);
+      m_players = {};
+      m_players[0].playerId = 0;
+      m_players[1].playerId = 1;
+    }
+
+    void UpdateMap(const Swoq::Interface::State& state, Samples& samples)
+    {
+      Timer timer(samples, Phase::UpdateMap);
+      const PlayerViews views(state, m_visibility);
+      m_dungeonMap = views.Apply(m_dungeonMap);
+      m_map = views.Apply(m_map);
+      views.Apply(m_players);
+    }
+
+    TaskPool& m_taskPool;
+    Offset m_mapSize;
+    int m_visibility;
+    int m_level = 0;
+    DungeonMap::Ptr m_dungeonMap;
+    PlayerMap::Ptr m_map;
+    PlayerStateArray m_players;
+  };
+
+  double Percentile(std::vector<Clock::duration>& samples, int percentile)
+  {
+    const auto index = std::min(samples.size() - 1, samples.size() * static_cast<std::size_t>(percentile) / 100);
+    std::ranges::nth_element(samples, samples.begin() + static_cast<std::ptrdiff_t>(index));
+    return std::chrono::duration<double, std::micro>(samples[index]).count();
+  }
+
+  // Only replays that can be read to the end count, so a corrupt or cut off one doesn't skew the numbers
+  bool Replay(const fs::path& path, TaskPool& taskPool, std::map<int, Samples>& samplesPerLevel)
+  {
+    auto reader = Swoq::ReplayReader::open(path);
+    if(!reader)
+    {
+      std::println("Skipping {}: {}", path.string(), reader.error());
+      return false;
+    }
+
+    std::map<int, Samples> samples;
+    const auto& start = (*reader)->start_response();
+    LevelReplayer replayer(taskPool, {start.mapwidth(), start.mapheight()}, start.visibilityrange());
+    replayer.Tick(start.state(), samples[start.state().level()]);
+
+    Swoq::Interface::ActRequest request;
+    Swoq::Interface::ActResponse response;
+    std::size_t acts = 0;
+    while(true)
+    {
+      auto next = (*reader)->next(request, response);
+      if(!next)
+      {
+        std::println("Skipping {}: {}", path.string(), next.error());
+        return false;
+      }
+      if(!*next)
+        break;
+
+      ++acts;
+      if(response.result() == Swoq::Interface::ActResult::ACT_RESULT_OK)
+      {
+        replayer.Tick(response.state(), samples[response.state().level()]);
+      }
+    }
+    if((*reader)->truncated())
+    {
+      std::println("Skipping {}: truncated after {} acts", path.string(), acts);
+      return false;
+    }
+
+    for(auto& [level, levelSamples]: samples)
+    {
+      for(std::size_t phase = 0; phase < PhaseCount; ++phase)
+      {
+        std::ranges::move(levelSamples[phase], std::back_inserter(samplesPerLevel[level][phase]));
+      }
+    }
+    return true;
+  }
+} // namespace
+
+int main(int /*argc*/, char** /*argv*/)
+{
+  load_dotenv();
+  auto folder = require_env_str("SWOQ_REPLAYS_FOLDER");
+
+  TaskPool taskPool;
+  std::map<int, Samples> samplesPerLevel;
+  std::size_t replays = 0;
+  std::size_t skipped = 0;
+  for(const auto& entry: fs::recursive_directory_iterator(folder))
+  {
+    if(entry.is_regular_file() && entry.path().extension() == ".swoq")
+    {
+      ++(Replay(entry.path(), taskPool, samplesPerLevel) ? replays : skipped);
+    }
+  }
+
+  std::println("{} replays from {}, {} skipped", replays, folder, skipped);
+  std::println("{:>5} {:<12} {:>8} {:>10} {:>10} {:>10}", "level", "phase", "samples", "p50 (us)", "p95 (us)", "p99 (us)");
+  for(auto& [level, samples]: samplesPerLevel)
+  {
+    for(std::size_t phase = 0; phase < PhaseCount; ++phase)
+    {
+      auto& durations = samples[phase];
+      if(durations.empty())
+        continue;
+
+      std::println(
+        "{:>5} {:<12} {:>8} {:>10.1f} {:>10.1f} {:>10.1f}",
+        level,
+        PhaseNames[phase],
+        durations.size(),
+        Percentile(durations, 50),
+        Percentile(durations, 95),
+        Percentile(durations, 99));
+    }
+  }
+
+  return replays > 0 ? 0 : -1;
+}
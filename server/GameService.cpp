@@ -0,0 +1,106 @@
+#include "GameService.h"
+
+#include <format>
+#include <random>
+
+namespace Server
+{
+  GameService::GameService(ServerOptions options)
+    : m_options(options)
+  {
+  }
+
+  grpc::Status GameService::Start(
+    grpc::ServerContext* /*context*/,
+    const Swoq::Interface::StartRequest* request,
+    Swoq::Interface::StartResponse* response)
+  {
+    if(request->has_level() && (request->level() < 0 || request->level() > MaxLevel))
+    {
+      response->set_result(Swoq::Interface::StartResult::START_RESULT_INVALID_LEVEL);
+      return grpc::Status::OK;
+    }
+
+    // Seeds are reported back as int32; the casts round-trip, and random seeds are kept non-negative
+    const auto seed = request->has_seed() ? static_cast<std::uint32_t>(request->seed()) : std::random_device{}() & 0x7fffffffu;
+    const auto level = request->has_level() ? std::make_optional(request->level()) : std::nullopt;
+    auto session = std::make_shared<Session>(Quest(level, seed, m_options.mapSize, m_options.visibility));
+    auto gameId = std::format("local-{}", m_nextGameId++);
+
+    response->set_result(Swoq::Interface::StartResult::START_RESULT_OK);
+    response->set_gameid(gameId);
+    response->set_mapwidth(m_options.mapSize.x);
+    response->set_mapheight(m_options.mapSize.y);
+    response->set_visibilityrange(m_options.visibility);
+    response->set_seed(static_cast<std::int32_t>(seed));
+    session->quest.Fill(*response->mutable_state());
+
+    std::scoped_lock lock(m_mutex);
+    m_sessions.emplace(std::move(gameId), std::move(session));
+    return grpc::Status::OK;
+  }
+
+  grpc::Status GameService::Act(
+    grpc::ServerContext* /*context*/,
+    const Swoq::Interface::ActRequest* request,
+    Swoq::Interface::ActResponse* response)
+  {
+    auto session = Find(request->gameid());
+    if(!session)
+    {
+      response->set_result(
+        IsFinished(request->gameid()) ? Swoq::Interface::ActResult::ACT_RESULT_GAME_FINISHED
+                                      : Swoq::Interface::ActResult::ACT_RESULT_UNKNOWN_GAME_ID);
+      return grpc::Status::OK;
+    }
+
+    bool finished = false;
+    {
+      std::scoped_lock lock(session->mutex);
+      const auto action = request->has_action() ? std::make_optional(request->action()) : std::nullopt;
+      const auto action2 = request->has_action2() ? std::make_optional(request->action2()) : std::nullopt;
+      response->set_result(session->quest.Act(action, action2));
+      session->quest.Fill(*response->mutable_state());
+      finished = session->quest.Status() != GameStatus::GAME_STATUS_ACTIVE;
+    }
+
+    // Long sweeps start many games; forget the ones that are over
+    if(finished)
+    {
+      Forget(request->gameid());
+    }
+    return grpc::Status::OK;
+  }
+
+  std::shared_ptr<GameService::Session> GameService::Find(const std::string& gameId)
+  {
+    std::scoped_lock lock(m_mutex);
+    auto it = m_sessions.find(gameId);
+    return it == m_sessions.end() ? nullptr : it->second;
+  }
+
+  bool GameService::IsFinished(const std::string& gameId)
+  {
+    std::scoped_lock lock(m_mutex);
+    return m_finished.contains(gameId);
+  }
+
+  void GameService::Forget(const std::string& gameId)
+  {
+    std::scoped_lock lock(m_mutex);
+    if(m_sessions.erase(gameId) == 0)
+    {
+      // Another Act on the same game already did this
+      return;
+    }
+
+    m_finished.insert(gameId);
+    m_finishedOrder.push_back(gameId);
+    if(m_finishedOrder.size() > MaxFinishedGames)
+    {
+      m_finished.erase(m_finishedOrder.front());
+      m_finishedOrder.pop_front();
+    }
+  }
+
+} // namespace Server
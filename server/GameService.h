@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "GameState.h"
+#include "Swoq.grpc.pb.h"
+
+namespace Server
+{
+  struct ServerOptions
+  {
+    Offset mapSize{31, 31};
+    int visibility = 4;
+  };
+
+  // Stand-in for the real SWOQ server, so the bot can be run and stress tested without a network connection.
+  // A requested seed is used as its unsigned 32-bit pattern, so negative seeds are valid and reported back unchanged.
+  class GameService final : public Swoq::Interface::GameService::Service
+  {
+  public:
+    explicit GameService(ServerOptions options = {});
+
+    grpc::Status Start(
+      grpc::ServerContext* context,
+      const Swoq::Interface::StartRequest* request,
+      Swoq::Interface::StartResponse* response) override;
+    grpc::Status
+      Act(grpc::ServerContext* context, const Swoq::Interface::ActRequest* request, Swoq::Interface::ActResponse* response)
+        override;
+
+  private:
+    struct Session
+    {
+      explicit Session(Quest quest_)
+        : quest(std::move(quest_))
+      {
+      }
+
+      std::mutex mutex;
+      Quest quest;
+    };
+
+    // Finished games are forgotten, but the most recent ids are remembered so late actions get GAME_FINISHED
+    static constexpr std::size_t MaxFinishedGames = 1024;
+
+    std::shared_ptr<Session> Find(const std::string& gameId);
+    bool IsFinished(const std::string& gameId);
+    void Forget(const std::string& gameId);
+
+    ServerOptions m_options;
+    std::atomic<std::uint64_t> m_nextGameId{0};
+    std::mutex m_mutex;
+    std::map<std::string, std::shared_ptr<Session>> m_sessions;
+    std::set<std::string> m_finished;
+    std::deque<std::string> m_finishedOrder;
+  };
+
+} // namespace Server
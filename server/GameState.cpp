@@ -0,0 +1,616 @@
+#include "GameState.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+
+#include "LineOfSight.h"
+
+namespace Server
+{
+  namespace
+  {
+    std::optional<std::size_t> ColorIndex(Tile tile)
+    {
+      switch(tile)
+      {
+      case Tile::TILE_DOOR_RED:
+      case Tile::TILE_KEY_RED:
+      case Tile::TILE_PRESSURE_PLATE_RED:
+        return 0;
+      case Tile::TILE_DOOR_GREEN:
+      case Tile::TILE_KEY_GREEN:
+      case Tile::TILE_PRESSURE_PLATE_GREEN:
+        return 1;
+      case Tile::TILE_DOOR_BLUE:
+      case Tile::TILE_KEY_BLUE:
+      case Tile::TILE_PRESSURE_PLATE_BLUE:
+        return 2;
+      default:
+        return std::nullopt;
+      }
+    }
+
+    constexpr bool IsDoor(Tile tile)
+    {
+      return tile == Tile::TILE_DOOR_RED || tile == Tile::TILE_DOOR_GREEN || tile == Tile::TILE_DOOR_BLUE;
+    }
+
+    constexpr bool IsKey(Tile tile)
+    {
+      return tile == Tile::TILE_KEY_RED || tile == Tile::TILE_KEY_GREEN || tile == Tile::TILE_KEY_BLUE;
+    }
+
+    constexpr bool IsPlate(Tile tile)
+    {
+      return tile == Tile::TILE_PRESSURE_PLATE_RED || tile == Tile::TILE_PRESSURE_PLATE_GREEN
+          || tile == Tile::TILE_PRESSURE_PLATE_BLUE;
+    }
+
+    Inventory InventoryFromKey(Tile key)
+    {
+      switch(key)
+      {
+      case Tile::TILE_KEY_RED:
+        return Inventory::INVENTORY_KEY_RED;
+      case Tile::TILE_KEY_GREEN:
+        return Inventory::INVENTORY_KEY_GREEN;
+      case Tile::TILE_KEY_BLUE:
+        return Inventory::INVENTORY_KEY_BLUE;
+      default:
+        return Inventory::INVENTORY_NONE;
+      }
+    }
+
+    std::optional<std::size_t> KeyColorIndex(Inventory inventory)
+    {
+      switch(inventory)
+      {
+      case Inventory::INVENTORY_KEY_RED:
+        return 0;
+      case Inventory::INVENTORY_KEY_GREEN:
+        return 1;
+      case Inventory::INVENTORY_KEY_BLUE:
+        return 2;
+      default:
+        return std::nullopt;
+      }
+    }
+
+    std::optional<Offset> DirectionOf(DirectedAction action)
+    {
+      using enum Swoq::Interface::DirectedAction;
+      switch(action)
+      {
+      case DIRECTED_ACTION_MOVE_NORTH:
+      case DIRECTED_ACTION_USE_NORTH:
+        return North;
+      case DIRECTED_ACTION_MOVE_EAST:
+      case DIRECTED_ACTION_USE_EAST:
+        return East;
+      case DIRECTED_ACTION_MOVE_SOUTH:
+      case DIRECTED_ACTION_USE_SOUTH:
+        return South;
+      case DIRECTED_ACTION_MOVE_WEST:
+      case DIRECTED_ACTION_USE_WEST:
+        return West;
+      default:
+        return std::nullopt;
+      }
+    }
+
+    constexpr bool IsUse(DirectedAction action)
+    {
+      using enum Swoq::Interface::DirectedAction;
+      return action == DIRECTED_ACTION_USE_NORTH || action == DIRECTED_ACTION_USE_EAST || action == DIRECTED_ACTION_USE_SOUTH
+          || action == DIRECTED_ACTION_USE_WEST;
+    }
+
+    int Distance(Offset a, Offset b) { return std::abs(a.x - b.x) + std::abs(a.y - b.y); }
+  } // namespace
+
+  GameState::GameState(Level level, int visibility)
+    : m_level(std::move(level))
+    , m_visibility(visibility)
+    , m_plates(m_level.tiles.Width(), m_level.tiles.Height(), Tile::TILE_EMPTY)
+    , m_seen(m_level.tiles.Width(), m_level.tiles.Height(), 0)
+  {
+    // Plates stay under whatever is put on top of them
+    for(std::size_t i = 0; i < m_level.tiles.Data().size(); ++i)
+    {
+      const Tile tile = m_level.tiles[i];
+      if(IsPlate(tile))
+      {
+        m_plates[i] = tile;
+        m_level.tiles[i] = Tile::TILE_EMPTY;
+      }
+      else if(IsDoor(tile))
+      {
+        m_doors.push_back(m_level.tiles.ToOffset(i));
+      }
+    }
+
+    for(const auto& position: m_level.players)
+    {
+      m_players.push_back({position});
+    }
+    for(const auto& spawn: m_level.enemies)
+    {
+      m_enemies.push_back({spawn.position, spawn.key});
+    }
+
+    Look();
+    m_lastProgress = 0;
+  }
+
+  ActResult GameState::Act(std::optional<DirectedAction> action, std::optional<DirectedAction> action2)
+  {
+    if(m_status != GameStatus::GAME_STATUS_ACTIVE || Completed())
+    {
+      return ActResult::ACT_RESULT_GAME_FINISHED;
+    }
+
+    GameState next = *this;
+    const ActResult result = next.Apply(action, action2);
+    if(result == ActResult::ACT_RESULT_OK)
+    {
+      *this = std::move(next);
+    }
+    return result;
+  }
+
+  ActResult GameState::Apply(std::optional<DirectedAction> action, std::optional<DirectedAction> action2)
+  {
+    const std::array actions{action, action2};
+    for(std::size_t i = 0; i < actions.size(); ++i)
+    {
+      if(!actions[i] || *actions[i] == DirectedAction::DIRECTED_ACTION_NONE)
+        continue;
+
+      if(i >= m_players.size() || !m_players[i].present)
+      {
+        return i == 0 ? ActResult::ACT_RESULT_PLAYER_NOT_PRESENT : ActResult::ACT_RESULT_PLAYER2_NOT_PRESENT;
+      }
+
+      const auto direction = DirectionOf(*actions[i]);
+      if(!direction)
+      {
+        return ActResult::ACT_RESULT_UNKNOWN_ACTION;
+      }
+
+      auto& player = m_players[i];
+      const Offset target = player.position + *direction;
+      const ActResult result = IsUse(*actions[i]) ? Use(player, target) : Move(player, target);
+      if(result != ActResult::ACT_RESULT_OK)
+      {
+        return result;
+      }
+    }
+
+    ++m_ticks;
+    UpdateDoors();
+    if(m_ticks % 2 == 0)
+    {
+      MoveEnemies();
+      UpdateDoors();
+    }
+    Look();
+    UpdateStatus();
+    return ActResult::ACT_RESULT_OK;
+  }
+
+  ActResult GameState::Move(Player& player, Offset target)
+  {
+    if(!IsWalkableForPlayer(target))
+    {
+      return ActResult::ACT_RESULT_MOVE_NOT_ALLOWED;
+    }
+
+    player.position = target;
+    Tile& tile = m_level.tiles[target];
+    if(tile == Tile::TILE_EXIT)
+    {
+      player.present = false;
+      m_lastProgress = m_ticks;
+    }
+    else if(IsKey(tile) && player.inventory == Inventory::INVENTORY_NONE)
+    {
+      player.inventory = InventoryFromKey(tile);
+      tile = Tile::TILE_EMPTY;
+      m_lastProgress = m_ticks;
+    }
+    else if(tile == Tile::TILE_SWORD)
+    {
+      player.hasSword = true;
+      tile = Tile::TILE_EMPTY;
+      m_lastProgress = m_ticks;
+    }
+    else if(tile == Tile::TILE_HEALTH)
+    {
+      ++player.health;
+      tile = Tile::TILE_EMPTY;
+      m_lastProgress = m_ticks;
+    }
+    return ActResult::ACT_RESULT_OK;
+  }
+
+  ActResult GameState::Use(Player& player, Offset target)
+  {
+    if(!m_level.tiles.IsInRange(target))
+    {
+      return ActResult::ACT_RESULT_USE_NOT_ALLOWED;
+    }
+
+    if(auto* enemy = EnemyAt(target))
+    {
+      if(!player.hasSword)
+        return ActResult::ACT_RESULT_NO_SWORD;
+      Kill(*enemy);
+      m_lastProgress = m_ticks;
+      return ActResult::ACT_RESULT_OK;
+    }
+
+    Tile& tile = m_level.tiles[target];
+    if(IsDoor(tile) && !IsDoorOpen(tile))
+    {
+      if(player.inventory == Inventory::INVENTORY_NONE)
+        return ActResult::ACT_RESULT_INVENTORY_EMPTY;
+      if(KeyColorIndex(player.inventory) != ColorIndex(tile))
+        return ActResult::ACT_RESULT_USE_NOT_ALLOWED;
+
+      m_unlocked[*ColorIndex(tile)] = true;
+      player.inventory = Inventory::INVENTORY_NONE;
+      m_lastProgress = m_ticks;
+      return ActResult::ACT_RESULT_OK;
+    }
+
+    if(tile == Tile::TILE_BOULDER)
+    {
+      if(player.inventory != Inventory::INVENTORY_NONE)
+        return ActResult::ACT_RESULT_INVENTORY_FULL;
+
+      player.inventory = Inventory::INVENTORY_BOULDER;
+      tile = Tile::TILE_EMPTY;
+      m_lastProgress = m_ticks;
+      return ActResult::ACT_RESULT_OK;
+    }
+
+    if(tile == Tile::TILE_EMPTY && !HasPlayer(target))
+    {
+      if(player.inventory == Inventory::INVENTORY_NONE)
+        return ActResult::ACT_RESULT_INVENTORY_EMPTY;
+      if(player.inventory != Inventory::INVENTORY_BOULDER)
+        return ActResult::ACT_RESULT_USE_NOT_ALLOWED;
+
+      player.inventory = Inventory::INVENTORY_NONE;
+      tile = Tile::TILE_BOULDER;
+      m_lastProgress = m_ticks;
+      return ActResult::ACT_RESULT_OK;
+    }
+
+    return ActResult::ACT_RESULT_USE_NOT_ALLOWED;
+  }
+
+  void GameState::MoveEnemies()
+  {
+    for(auto& enemy: m_enemies)
+    {
+      if(!enemy.alive)
+        continue;
+
+      std::optional<Offset> target;
+      bool attacked = false;
+      for(auto& player: m_players)
+      {
+        if(!player.present)
+          continue;
+        if(Distance(enemy.position, player.position) == 1)
+        {
+          --player.health;
+          attacked = true;
+          break;
+        }
+        if(CanSee(enemy.position, player.position)
+           && (!target || Distance(enemy.position, player.position) < Distance(enemy.position, *target)))
+        {
+          target = player.position;
+        }
+      }
+
+      if(attacked || !target)
+        continue;
+
+      if(auto step = StepToward(enemy.position, *target))
+      {
+        enemy.position = *step;
+      }
+    }
+  }
+
+  void GameState::UpdateDoors()
+  {
+    std::array<bool, 3> pressed{};
+    for(std::size_t i = 0; i < m_plates.Data().size(); ++i)
+    {
+      const auto color = ColorIndex(m_plates[i]);
+      const Offset position = m_plates.ToOffset(i);
+      if(color && (m_level.tiles[i] == Tile::TILE_BOULDER || HasPlayer(position) || EnemyAt(position)))
+      {
+        pressed[*color] = true;
+      }
+    }
+
+    for(const auto& door: m_doors)
+    {
+      const auto color = *ColorIndex(m_level.tiles[door]);
+      if(!m_pressed[color] || pressed[color] || m_unlocked[color])
+        continue;
+
+      // A closing door crushes an enemy, but won't close on a player
+      if(HasPlayer(door))
+      {
+        pressed[color] = true;
+      }
+      else if(auto* enemy = EnemyAt(door))
+      {
+        Kill(*enemy);
+        m_lastProgress = m_ticks;
+      }
+    }
+
+    m_pressed = pressed;
+  }
+
+  void GameState::UpdateStatus()
+  {
+    for(std::size_t i = 0; i < m_players.size(); ++i)
+    {
+      if(m_players[i].health <= 0)
+      {
+        m_status = i == 0 ? GameStatus::GAME_STATUS_FINISHED_PLAYER_DIED : GameStatus::GAME_STATUS_FINISHED_PLAYER2_DIED;
+        return;
+      }
+    }
+
+    if(Completed())
+      return;
+
+    if(m_ticks >= MaxTicksPerLevel)
+    {
+      m_status = GameStatus::GAME_STATUS_FINISHED_TIMEOUT;
+    }
+    else if(m_ticks - m_lastProgress >= MaxTicksWithoutProgress)
+    {
+      m_status = GameStatus::GAME_STATUS_FINISHED_NO_PROGRESS;
+    }
+  }
+
+  void GameState::Kill(Enemy& enemy)
+  {
+    enemy.alive = false;
+    if(!enemy.key)
+      return;
+
+    // The key drops where the enemy died, or next to it when that is a door
+    std::vector<Offset> candidates{enemy.position};
+    for(auto direction: Directions)
+    {
+      candidates.push_back(enemy.position + direction);
+    }
+    for(const auto& position: candidates)
+    {
+      if(m_level.tiles.IsInRange(position) && m_level.tiles[position] == Tile::TILE_EMPTY && !HasPlayer(position))
+      {
+        m_level.tiles[position] = *enemy.key;
+        break;
+      }
+    }
+    enemy.key.reset();
+  }
+
+  // Discovering new parts of the map counts as progress
+  void GameState::Look()
+  {
+    for(const auto& player: m_players)
+    {
+      if(!player.present)
+        continue;
+
+      for(int dy = -m_visibility; dy <= m_visibility; ++dy)
+      {
+        for(int dx = -m_visibility; dx <= m_visibility; ++dx)
+        {
+          const Offset position = player.position + Offset{dx, dy};
+          if(m_seen.IsInRange(position) && m_seen[position] == 0 && CanSee(player.position, position))
+          {
+            m_seen[position] = 1;
+            m_lastProgress = m_ticks;
+          }
+        }
+      }
+    }
+  }
+
+  void GameState::Fill(Swoq::Interface::State& state) const
+  {
+    state.set_level(m_level.number);
+    state.set_status(m_status);
+
+    for(std::size_t i = 0; i < m_players.size(); ++i)
+    {
+      const auto& player = m_players[i];
+      if(!player.present)
+        continue;
+
+      auto& playerState = i == 0 ? *state.mutable_playerstate() : *state.mutable_player2state();
+      playerState.mutable_position()->set_x(player.position.x);
+      playerState.mutable_position()->set_y(player.position.y);
+      for(int dy = -m_visibility; dy <= m_visibility; ++dy)
+      {
+        for(int dx = -m_visibility; dx <= m_visibility; ++dx)
+        {
+          const Offset position = player.position + Offset{dx, dy};
+          playerState.add_surroundings(CanSee(player.position, position) ? TileAt(position) : Tile::TILE_UNKNOWN);
+        }
+      }
+
+      if(m_level.number >= 2)
+        playerState.set_inventory(player.inventory);
+      if(m_level.number >= 8)
+        playerState.set_health(player.health);
+      if(m_level.number >= 10)
+        playerState.set_hassword(player.hasSword);
+    }
+  }
+
+  bool GameState::Completed() const
+  {
+    return std::ranges::none_of(m_players, &Player::present);
+  }
+
+  std::optional<Offset> GameState::PlayerPosition(std::size_t player) const
+  {
+    if(player >= m_players.size() || !m_players[player].present)
+      return std::nullopt;
+    return m_players[player].position;
+  }
+
+  Tile GameState::TileAt(Offset position) const
+  {
+    if(!m_level.tiles.IsInRange(position))
+      return Tile::TILE_UNKNOWN;
+    if(HasPlayer(position))
+      return Tile::TILE_PLAYER;
+    if(EnemyAt(position))
+      return Tile::TILE_ENEMY;
+
+    const Tile tile = m_level.tiles[position];
+    if(IsDoor(tile) && IsDoorOpen(tile))
+      return Tile::TILE_EMPTY;
+    if(tile == Tile::TILE_EMPTY)
+      return m_plates[position];
+    return tile;
+  }
+
+  bool GameState::IsDoorOpen(Tile door) const
+  {
+    const auto color = *ColorIndex(door);
+    return m_unlocked[color] || m_pressed[color];
+  }
+
+  bool GameState::IsOpaque(Offset position) const
+  {
+    const Tile tile = m_level.tiles[position];
+    return tile == Tile::TILE_WALL || (IsDoor(tile) && !IsDoorOpen(tile));
+  }
+
+  bool GameState::CanSee(Offset from, Offset to) const
+  {
+    return m_level.tiles.IsInRange(to)
+        && Bot::CanSee(from, to, m_visibility, [this](Offset position) { return IsOpaque(position); });
+  }
+
+  bool GameState::IsWalkableForPlayer(Offset position) const
+  {
+    if(!m_level.tiles.IsInRange(position) || HasPlayer(position) || EnemyAt(position))
+      return false;
+
+    const Tile tile = m_level.tiles[position];
+    if(IsDoor(tile))
+      return IsDoorOpen(tile);
+    return tile != Tile::TILE_WALL && tile != Tile::TILE_BOULDER;
+  }
+
+  bool GameState::IsWalkableForEnemy(Offset position) const
+  {
+    if(!m_level.tiles.IsInRange(position) || HasPlayer(position) || EnemyAt(position))
+      return false;
+
+    const Tile tile = m_level.tiles[position];
+    if(IsDoor(tile))
+      return IsDoorOpen(tile);
+    return tile != Tile::TILE_WALL && tile != Tile::TILE_BOULDER && tile != Tile::TILE_EXIT;
+  }
+
+  bool GameState::HasPlayer(Offset position) const
+  {
+    return std::ranges::any_of(m_players, [&](const Player& player) { return player.present && player.position == position; });
+  }
+
+  GameState::Enemy* GameState::EnemyAt(Offset position)
+  {
+    auto it = std::ranges::find_if(m_enemies, [&](const Enemy& enemy) { return enemy.alive && enemy.position == position; });
+    return it == m_enemies.end() ? nullptr : &*it;
+  }
+
+  const GameState::Enemy* GameState::EnemyAt(Offset position) const
+  {
+    auto it = std::ranges::find_if(m_enemies, [&](const Enemy& enemy) { return enemy.alive && enemy.position == position; });
+    return it == m_enemies.end() ? nullptr : &*it;
+  }
+
+  // First step of a shortest path for an enemy, searching backwards from the player it chases
+  std::optional<Offset> GameState::StepToward(Offset from, Offset to) const
+  {
+    Vector2d<int> distances(m_level.tiles.Width(), m_level.tiles.Height(), -1);
+    std::deque<Offset> queue{to};
+    distances[to] = 0;
+    while(!queue.empty())
+    {
+      const Offset current = queue.front();
+      queue.pop_front();
+      for(auto direction: Directions)
+      {
+        const Offset next = current + direction;
+        if(next == from)
+        {
+          return current == to ? std::nullopt : std::make_optional(current);
+        }
+        if(!IsWalkableForEnemy(next) || distances[next] >= 0)
+          continue;
+        distances[next] = distances[current] + 1;
+        queue.push_back(next);
+      }
+    }
+    return std::nullopt;
+  }
+
+  Quest::Quest(std::optional<int> level, std::uint32_t seed, Offset mapSize, int visibility)
+    : m_training(level.has_value())
+    , m_seed(seed)
+    , m_mapSize(mapSize)
+    , m_visibility(visibility)
+    , m_state(GenerateLevel(level.value_or(0), seed, mapSize), visibility)
+  {
+  }
+
+  ActResult Quest::Act(std::optional<DirectedAction> action, std::optional<DirectedAction> action2)
+  {
+    const ActResult result = m_state.Act(action, action2);
+    if(result != ActResult::ACT_RESULT_OK)
+    {
+      return result;
+    }
+
+    ++m_tick;
+    if(m_state.Completed())
+    {
+      if(m_training || m_state.LevelNumber() == MaxLevel)
+      {
+        m_state.Finish(GameStatus::GAME_STATUS_FINISHED_SUCCESS);
+      }
+      else
+      {
+        m_state = GameState(GenerateLevel(m_state.LevelNumber() + 1, m_seed, m_mapSize), m_visibility);
+      }
+    }
+    return result;
+  }
+
+  void Quest::Fill(Swoq::Interface::State& state) const
+  {
+    state.set_tick(m_tick);
+    m_state.Fill(state);
+  }
+
+} // namespace Server
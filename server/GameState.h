@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "LevelGenerator.h"
+
+namespace Server
+{
+  using Swoq::Interface::ActResult;
+  using Swoq::Interface::DirectedAction;
+  using Swoq::Interface::GameStatus;
+  using Swoq::Interface::Inventory;
+
+  constexpr int MaxTicksPerLevel = 10000;
+  constexpr int MaxTicksWithoutProgress = 2000;
+
+  // The rules of a single level
+  class GameState
+  {
+  public:
+    GameState(Level level, int visibility);
+
+    // Either both actions are applied, or none
+    ActResult Act(std::optional<DirectedAction> action, std::optional<DirectedAction> action2);
+    void Finish(GameStatus status) { m_status = status; }
+    void Fill(Swoq::Interface::State& state) const;
+
+    [[nodiscard]] int LevelNumber() const { return m_level.number; }
+    [[nodiscard]] GameStatus Status() const { return m_status; }
+    [[nodiscard]] bool Completed() const;
+    [[nodiscard]] std::optional<Offset> PlayerPosition(std::size_t player) const;
+    [[nodiscard]] Tile TileAt(Offset position) const;
+
+  private:
+    struct Player
+    {
+      Offset position;
+      bool present = true;
+      int health = 5;
+      bool hasSword = false;
+      Inventory inventory = Inventory::INVENTORY_NONE;
+    };
+
+    struct Enemy
+    {
+      Offset position;
+      std::optional<Tile> key;
+      bool alive = true;
+    };
+
+    ActResult Apply(std::optional<DirectedAction> action, std::optional<DirectedAction> action2);
+    ActResult Move(Player& player, Offset target);
+    ActResult Use(Player& player, Offset target);
+    void MoveEnemies();
+    void UpdateDoors();
+    void UpdateStatus();
+    void Kill(Enemy& enemy);
+    void Look();
+
+    [[nodiscard]] bool IsDoorOpen(Tile door) const;
+    [[nodiscard]] bool IsOpaque(Offset position) const;
+    [[nodiscard]] bool CanSee(Offset from, Offset to) const;
+    [[nodiscard]] bool IsWalkableForPlayer(Offset position) const;
+    [[nodiscard]] bool IsWalkableForEnemy(Offset position) const;
+    [[nodiscard]] bool HasPlayer(Offset position) const;
+    [[nodiscard]] Enemy* EnemyAt(Offset position);
+    [[nodiscard]] const Enemy* EnemyAt(Offset position) const;
+    [[nodiscard]] std::optional<Offset> StepToward(Offset from, Offset to) const;
+
+    Level m_level;
+    int m_visibility;
+    Vector2d<Tile> m_plates;
+    std::vector<Offset> m_doors;
+    std::vector<Player> m_players;
+    std::vector<Enemy> m_enemies;
+    std::array<bool, 3> m_unlocked{};
+    std::array<bool, 3> m_pressed{};
+    Vector2d<int> m_seen;
+    GameStatus m_status = GameStatus::GAME_STATUS_ACTIVE;
+    int m_ticks = 0;
+    int m_lastProgress = 0;
+  };
+
+  // A game as started by a client: a single level when training, otherwise all levels in sequence
+  class Quest
+  {
+  public:
+    Quest(std::optional<int> level, std::uint32_t seed, Offset mapSize, int visibility);
+
+    ActResult Act(std::optional<DirectedAction> action, std::optional<DirectedAction> action2);
+    void Fill(Swoq::Interface::State& state) const;
+
+    [[nodiscard]] GameStatus Status() const { return m_state.Status(); }
+    [[nodiscard]] int LevelNumber() const { return m_state.LevelNumber(); }
+    [[nodiscard]] const GameState& State() const { return m_state; }
+
+  private:
+    bool m_training;
+    std::uint32_t m_seed;
+    Offset m_mapSize;
+    int m_visibility;
+    int m_tick = 0;
+    GameState m_state;
+  };
+
+} // namespace Server
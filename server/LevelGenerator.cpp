@@ -0,0 +1,296 @@
+#include "LevelGenerator.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "MazeGeneration.h"
+
+namespace Server
+{
+  namespace
+  {
+    using namespace Bot::Generation;
+
+    struct Branch
+    {
+      Offset inside;
+      Offset door;
+      Offset outside;
+    };
+
+    class Generator
+    {
+    public:
+      Generator(int level, std::uint32_t seed, Offset size)
+        : m_random((std::uint64_t{seed} << 8) ^ static_cast<std::uint64_t>(level))
+      {
+        m_level.number = level;
+        m_level.tiles = Vector2d<Tile>(size.x, size.y, Tile::TILE_WALL);
+      }
+
+      Level Generate()
+      {
+        const int level = m_level.number;
+        if(level == 0)
+        {
+          CarveRoom(m_level.tiles);
+        }
+        else
+        {
+          // Loops give the player a chance to run from the enemy. Levels with doors need a perfect maze, so that a door
+          // on the path to the exit can't be bypassed.
+          CarveMaze(m_level.tiles, m_random, level == 8);
+        }
+
+        m_start = m_random.Pick(OpenCells(m_level.tiles));
+        m_reserved.insert(m_start);
+        m_level.players.push_back(m_start);
+
+        const auto fromStart = Distances(m_level.tiles, m_start);
+        const Offset exit = Farthest(fromStart);
+        Place(exit, Tile::TILE_EXIT);
+        m_path = Path(fromStart, exit);
+
+        switch(level)
+        {
+        case 2:
+        case 3:
+        case 4:
+        case 5:
+          DoorChain(level == 2 ? 1 : level == 3 ? 2 : 3, level == 5);
+          break;
+        case 6:
+          BoulderInFrontOfExit();
+          break;
+        case 7:
+          PressurePlate();
+          break;
+        case 8:
+          Chaser();
+          break;
+        case 9:
+          DoorOnEnemy();
+          break;
+        case 10:
+          Sword();
+          break;
+        case 11:
+          TwoEnemies();
+          break;
+        case 12:
+          Colleague();
+          break;
+        default:
+          break;
+        }
+
+        return std::move(m_level);
+      }
+
+    private:
+      [[nodiscard]] bool IsFree(Offset position) const
+      {
+        return m_level.tiles.IsInRange(position) && m_level.tiles[position] == Tile::TILE_EMPTY && !m_reserved.contains(position);
+      }
+
+      [[nodiscard]] bool IsOnPath(Offset position) const { return std::ranges::contains(m_path, position); }
+
+      // Cells reachable from the start with 'blocked' closed, but not with 'inner' closed as well
+      [[nodiscard]] std::vector<Offset> Region(const std::vector<Offset>& blocked, const std::vector<Offset>& inner = {}) const
+      {
+        return Bot::Generation::Region(m_level.tiles, m_start, blocked, inner);
+      }
+
+      void Place(Offset position, Tile tile)
+      {
+        m_level.tiles[position] = tile;
+        m_reserved.insert(position);
+      }
+
+      [[nodiscard]] std::optional<Offset> PickFree(const std::vector<Offset>& region, int minimumDistance = 0)
+      {
+        const auto fromStart = Distances(m_level.tiles, m_start);
+        auto candidates = [&](bool offPath)
+        {
+          std::vector<Offset> result;
+          for(const auto& position: region)
+          {
+            if(IsFree(position) && fromStart[position] >= minimumDistance && (!offPath || !IsOnPath(position)))
+              result.push_back(position);
+          }
+          return result;
+        };
+
+        for(bool offPath: {true, false})
+        {
+          if(auto result = candidates(offPath); !result.empty())
+            return m_random.Pick(result);
+        }
+        return std::nullopt;
+      }
+
+      void PlaceInRegion(const std::vector<Offset>& region, Tile tile, int count = 1)
+      {
+        for(int i = 0; i < count; ++i)
+        {
+          if(auto position = PickFree(region))
+            Place(*position, tile);
+        }
+      }
+
+      void PlaceEnemy(const std::vector<Offset>& region, std::optional<Tile> key)
+      {
+        // Keep the enemy out of reach of the first few moves
+        auto position = PickFree(region, 6);
+        if(!position)
+          position = PickFree(region, 2);
+        if(!position)
+          return;
+
+        m_reserved.insert(*position);
+        m_level.enemies.push_back({*position, key});
+      }
+
+      std::vector<Offset> PlaceDoorsOnPath(const std::vector<Tile>& doors)
+      {
+        const auto result = DoorsOnPath(m_path, doors.size());
+        for(std::size_t i = 0; i < result.size(); ++i)
+        {
+          Place(result[i], doors[i]);
+        }
+        return result;
+      }
+
+      // A dead end off the path to the exit, with a corridor long enough to lock it with a door
+      [[nodiscard]] std::optional<Branch> FindBranch(const std::vector<Offset>& region)
+      {
+        const auto fromStart = Distances(m_level.tiles, m_start);
+        std::vector<Branch> candidates;
+        for(const auto& inside: region)
+        {
+          if(!IsDeadEnd(m_level.tiles, inside) || !IsFree(inside) || fromStart[inside] < 4)
+            continue;
+
+          const Offset corridor = StepBack(fromStart, inside);
+          const Offset door = StepBack(fromStart, corridor);
+          const Offset outside = StepBack(fromStart, door);
+          if(IsFree(corridor) && IsFree(door) && IsFree(outside) && !IsOnPath(corridor) && !IsOnPath(door))
+            candidates.push_back({inside, door, outside});
+        }
+
+        if(candidates.empty())
+          return std::nullopt;
+        return m_random.Pick(candidates);
+      }
+
+      void DoorChain(std::size_t count, bool secondKeyEarly)
+      {
+        const auto doors = PlaceDoorsOnPath({DoorTiles.begin(), DoorTiles.begin() + static_cast<std::ptrdiff_t>(count)});
+        for(std::size_t i = 0; i < doors.size(); ++i)
+        {
+          PlaceInRegion(KeyRegion(m_level.tiles, m_start, doors, secondKeyEarly && i == 1 ? 0 : i), KeyTiles[i]);
+        }
+      }
+
+      void BoulderInFrontOfExit()
+      {
+        if(m_path.size() >= 3)
+          Place(m_path[m_path.size() - 2], Tile::TILE_BOULDER);
+        PlaceInRegion(Region({}), Tile::TILE_BOULDER, 2);
+      }
+
+      void PressurePlate()
+      {
+        const auto doors = PlaceDoorsOnPath({Tile::TILE_DOOR_RED});
+        const auto region = Region(doors);
+        PlaceInRegion(region, Tile::TILE_PRESSURE_PLATE_RED);
+        PlaceInRegion(region, Tile::TILE_BOULDER, 6);
+      }
+
+      void Chaser()
+      {
+        const auto region = Region({});
+        PlaceEnemy(region, std::nullopt);
+        PlaceInRegion(region, Tile::TILE_BOULDER, 4);
+      }
+
+      void DoorOnEnemy()
+      {
+        const auto doors = PlaceDoorsOnPath({Tile::TILE_DOOR_GREEN});
+        const auto region = Region(doors);
+        if(auto branch = FindBranch(region))
+        {
+          Place(branch->door, Tile::TILE_DOOR_RED);
+          Place(branch->outside, Tile::TILE_PRESSURE_PLATE_RED);
+          m_reserved.insert(branch->inside);
+          m_level.enemies.push_back({branch->inside, Tile::TILE_KEY_GREEN});
+        }
+        else
+        {
+          PlaceEnemy(region, Tile::TILE_KEY_GREEN);
+        }
+      }
+
+      void Sword()
+      {
+        const auto doors = PlaceDoorsOnPath({Tile::TILE_DOOR_GREEN});
+        const auto region = Region(doors);
+        PlaceInRegion(region, Tile::TILE_SWORD);
+        PlaceInRegion(region, Tile::TILE_HEALTH, 2);
+        PlaceEnemy(region, Tile::TILE_KEY_GREEN);
+      }
+
+      void TwoEnemies()
+      {
+        const auto doors = PlaceDoorsOnPath({Tile::TILE_DOOR_RED, Tile::TILE_DOOR_GREEN});
+        const auto outer = Region(doors);
+        PlaceInRegion(outer, Tile::TILE_SWORD);
+        PlaceInRegion(outer, Tile::TILE_HEALTH, 2);
+        PlaceEnemy(outer, Tile::TILE_KEY_RED);
+        if(doors.size() == 2)
+        {
+          const auto inner = Region({doors[1]}, doors);
+          PlaceInRegion(inner, Tile::TILE_HEALTH);
+          PlaceEnemy(inner, Tile::TILE_KEY_GREEN);
+        }
+      }
+
+      void Colleague()
+      {
+        const auto region = Region({});
+        if(auto branch = FindBranch(region))
+        {
+          Place(branch->door, Tile::TILE_DOOR_BLUE);
+          m_reserved.insert(branch->inside);
+          m_level.players.push_back(branch->inside);
+          const auto outside = Region({branch->door});
+          PlaceEnemy(outside, Tile::TILE_KEY_BLUE);
+          PlaceInRegion(outside, Tile::TILE_SWORD);
+          PlaceInRegion(outside, Tile::TILE_HEALTH, 3);
+        }
+        else if(auto position = PickFree(region, 2))
+        {
+          m_reserved.insert(*position);
+          m_level.players.push_back(*position);
+          PlaceEnemy(region, std::nullopt);
+          PlaceInRegion(region, Tile::TILE_SWORD);
+          PlaceInRegion(region, Tile::TILE_HEALTH, 3);
+        }
+      }
+
+      Random m_random;
+      Level m_level;
+      OffsetSet m_reserved;
+      Offset m_start{0, 0};
+      std::vector<Offset> m_path;
+    };
+  } // namespace
+
+  Level GenerateLevel(int level, std::uint32_t seed, Offset size)
+  {
+    assert(level >= 0 && level <= MaxLevel);
+    assert(size.x >= 5 && size.y >= 5);
+    return Generator(level, seed, size).Generate();
+  }
+
+} // namespace Server
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Offset.h"
+#include "Swoq.pb.h"
+#include "Vector2d.h"
+
+namespace Server
+{
+  using Swoq::Interface::Tile;
+
+  constexpr int MaxLevel = 12;
+
+  struct EnemySpawn
+  {
+    Offset position;
+    std::optional<Tile> key;
+  };
+
+  struct Level
+  {
+    int number = 0;
+    // Everything that doesn't move by itself: walls, doors, keys, boulders, pressure plates, items and the exit
+    Vector2d<Tile> tiles;
+    std::vector<Offset> players;
+    std::vector<EnemySpawn> enemies;
+  };
+
+  // Deterministic for a given level, seed and size. The features per level follow the level list in DESIGN.md.
+  Level GenerateLevel(int level, std::uint32_t seed, Offset size);
+
+} // namespace Server
@@ -0,0 +1,35 @@
+#include <print>
+
+#include <grpcpp/grpcpp.h>
+
+#include "Dotenv.hpp"
+#include "GameService.h"
+
+int main(int /*argc*/, char** /*argv*/)
+{
+  load_dotenv();
+
+  auto address = get_env_str("SWOQ_SERVER_ADDRESS").value_or("localhost:5009");
+
+  Server::ServerOptions options;
+  options.mapSize.x = get_env_int("SWOQ_SERVER_MAP_WIDTH").value_or(options.mapSize.x);
+  options.mapSize.y = get_env_int("SWOQ_SERVER_MAP_HEIGHT").value_or(options.mapSize.y);
+  options.visibility = get_env_int("SWOQ_SERVER_VISIBILITY").value_or(options.visibility);
+
+  Server::GameService service(options);
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort(address, grpc::InsecureServerCredentials());
+  builder.RegisterService(&service);
+
+  auto server = builder.BuildAndStart();
+  if(!server)
+  {
+    std::println("Server: Failed to listen on {}", address);
+    return -1;
+  }
+
+  std::println(
+    "Server: Listening on {} ({}x{} maps, visibility {})", address, options.mapSize.x, options.mapSize.y, options.visibility);
+  server->Wait();
+  return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Tags the work of each thread with the phase of the tick it belongs to, so a program that replaces operator new can
+// count the allocations per phase (see tests/AllocationHarness.cpp). Without such a program, nobody reads the tag.
+// Tasks submitted to a TaskPool run in the phase of the thread that submitted them.
+namespace Bot::Allocations
+{
+  enum class Phase : std::uint8_t
+  {
+    Other,
+    ViewDecoding,
+    UpdateMap,
+    WeightMap,
+    Dijkstra,
+    Commands,
+    Protobuf,
+  };
+
+  constexpr std::array PhaseNames{"other", "view", "map", "weights", "dijkstra", "commands", "protobuf"};
+  constexpr std::size_t PhaseCount = PhaseNames.size();
+
+  namespace Detail
+  {
+    inline thread_local Phase current = Phase::Other;
+  } // namespace Detail
+
+  inline Phase Current() { return Detail::current; }
+
+  // The innermost scope wins, so a search started by a command counts as Dijkstra
+  class Scope
+  {
+  public:
+    explicit Scope(Phase phase)
+      : m_previous(std::exchange(Detail::current, phase))
+    {
+    }
+    ~Scope() { Detail::current = m_previous; }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    Phase m_previous;
+  };
+
+} // namespace Bot::Allocations
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace Bot
+{
+  // Holds the current version of an immutable value. Readers don't wait for writers to finish their update; writers
+  // publish a new version with compare-and-swap. Not wait-free: libstdc++ guards std::atomic<std::shared_ptr> with a
+  // short internal lock on every load and store. Use this instead of ThreadSafe when all you need is to swap a shared_ptr.
+  template <typename T>
+  class AtomicSnapshot
+  {
+  public:
+    using Ptr = std::shared_ptr<const T>;
+
+    AtomicSnapshot(Ptr initial = Ptr())
+      : m_value(std::move(initial))
+    {
+    }
+
+    AtomicSnapshot(const AtomicSnapshot&) = delete;
+    AtomicSnapshot& operator=(const AtomicSnapshot&) = delete;
+
+    [[nodiscard]] Ptr Get() const { return m_value.load(std::memory_order_acquire); }
+
+    void Set(Ptr value) { m_value.store(std::move(value), std::memory_order_release); }
+
+    AtomicSnapshot& operator=(Ptr value)
+    {
+      Set(std::move(value));
+      return *this;
+    }
+
+    // On failure, expected is updated to the currently published version
+    bool CompareAndSwap(Ptr& expected, Ptr desired)
+    {
+      return m_value.compare_exchange_strong(expected, std::move(desired), std::memory_order_acq_rel, std::memory_order_acquire);
+    }
+
+    // Derives a new version from the current one and publishes it. When another writer got there first,
+    // callable is invoked again on the newer version, so it must not have side effects beyond its result.
+    template <typename Callable>
+      requires std::is_invocable_r_v<Ptr, Callable, const Ptr&>
+    Ptr Update(Callable&& callable)
+    {
+      Ptr current = Get();
+      while(true)
+      {
+        Ptr next = std::invoke(callable, std::as_const(current));
+        if(next == current || CompareAndSwap(current, next))
+        {
+          return next;
+        }
+      }
+    }
+
+  private:
+    std::atomic<Ptr> m_value;
+  };
+
+} // namespace Bot
@@ -0,0 +1,72 @@
+#include "CommandChannel.h"
+
+namespace Bot
+{
+  void CommandChannel::Replace(Commands commands) { Post({Mode::Replace, std::move(commands)}); }
+
+  void CommandChannel::Prepend(Commands commands) { Post({Mode::Prepend, std::move(commands)}); }
+
+  void CommandChannel::Post(Message message)
+  {
+    if(m_overflowed.load(std::memory_order_acquire) == 0 && m_ring.TryPush(std::move(message)))
+      return;
+
+    std::lock_guard lock(m_overflowMutex);
+    m_overflow.push_back(std::move(message));
+    m_overflowed.store(m_overflow.size(), std::memory_order_release);
+    m_overflowPosted.fetch_add(1, std::memory_order_release);
+  }
+
+  void CommandChannel::Apply(Message& message, Commands& commands)
+  {
+    switch(message.mode)
+    {
+    case Mode::Replace:
+      commands.swap(message.commands);
+      break;
+    case Mode::Prepend:
+      while(!commands.empty())
+      {
+        message.commands.push(std::move(commands.front()));
+        commands.pop();
+      }
+      commands.swap(message.commands);
+      break;
+    }
+  }
+
+  bool CommandChannel::Drain(Commands& commands)
+  {
+    bool applied = false;
+    while(auto message = m_ring.TryPop())
+    {
+      applied = true;
+      Apply(*message, commands);
+    }
+
+    if(m_overflowed.load(std::memory_order_acquire) != 0)
+    {
+      // While anything is in the overflow, the producer doesn't use the ring, so the ring holds only older messages
+      std::lock_guard lock(m_overflowMutex);
+      while(auto message = m_ring.TryPop())
+        Apply(*message, commands);
+      for(auto& message: m_overflow)
+        Apply(message, commands);
+      applied = applied || !m_overflow.empty();
+      m_overflow.clear();
+      m_overflowed.store(0, std::memory_order_release);
+    }
+    return applied;
+  }
+
+  void CommandChannel::Discard()
+  {
+    std::lock_guard lock(m_overflowMutex);
+    while(m_ring.TryPop())
+    {
+    }
+    m_overflow.clear();
+    m_overflowed.store(0, std::memory_order_release);
+  }
+
+} // namespace Bot
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "Commands.h"
+#include "SpscRing.h"
+
+namespace Bot
+{
+  // Carries commands from the strategy (Game) to the executor (Player) for one player. The producer never
+  // waits for a search in progress: it posts a message, and the consumer applies all posted messages to its
+  // own queue before it picks the next command. Messages that don't fit in the ring go to a locked overflow
+  // list, so posting never blocks, also when the producer and consumer are the same thread.
+  class CommandChannel
+  {
+  public:
+    static constexpr std::size_t Capacity = 16;
+
+    enum class Mode : std::uint8_t
+    {
+      Replace,
+      Prepend,
+    };
+
+    // Producer side
+    void Replace(Commands commands);
+    void Prepend(Commands commands);
+
+    // Consumer side. Returns whether any message was applied.
+    bool Drain(Commands& commands);
+    void Discard();
+
+    [[nodiscard]] bool HasPending() const
+    {
+      return !m_ring.Empty() || m_overflowed.load(std::memory_order_acquire) != 0;
+    }
+    [[nodiscard]] std::uint64_t Sequence() const
+    {
+      return m_ring.Published() + m_overflowPosted.load(std::memory_order_acquire);
+    }
+
+  private:
+    struct Message
+    {
+      Mode mode = Mode::Replace;
+      Commands commands;
+    };
+
+    void Post(Message message);
+    static void Apply(Message& message, Commands& commands);
+
+    SpscRing<Message, Capacity> m_ring;
+    // Once a message overflowed, later ones follow it there until the consumer drained the overflow
+    std::mutex m_overflowMutex;
+    std::vector<Message> m_overflow;
+    std::atomic<std::size_t> m_overflowed{0};
+    std::atomic<std::uint64_t> m_overflowPosted{0};
+  };
+
+} // namespace Bot
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <format>
 #include <initializer_list>
 #include <queue>
 #include <set>
+#include <string_view>
+#include <type_traits>
 #include <variant>
 
 #include "Offset.h"
@@ -36,6 +40,8 @@ namespace Bot
 
   struct HuntEnemies
   {
+    static constexpr std::string_view Name = "HuntEnemies";
+
     constexpr explicit HuntEnemies(OffsetSet originalLocations)
       : remainingToCheck{std::move(originalLocations)}
     {
@@ -46,22 +52,28 @@ namespace Bot
 
   constexpr struct Explore_t
   {
+    static constexpr std::string_view Name = "Explore";
   } Explore;
 
   constexpr struct Terminate_t
   {
+    static constexpr std::string_view Name = "Terminate";
   } Terminate;
 
   constexpr struct Attack_t
   {
+    static constexpr std::string_view Name = "Attack";
   } Attack;
 
   constexpr struct DropBoulder_t : public MoveThenUse
   {
+    static constexpr std::string_view Name = "DropBoulder";
   } DropBoulder;
 
   struct VisitTiles
   {
+    static constexpr std::string_view Name = "VisitTiles";
+
     constexpr explicit VisitTiles(Tile tile)
       : tiles{tile}
     {
@@ -76,6 +88,8 @@ namespace Bot
 
   struct Visit
   {
+    static constexpr std::string_view Name = "Visit";
+
     constexpr explicit Visit(Offset position_)
       : position{position_}
     {
@@ -86,6 +100,8 @@ namespace Bot
 
   struct OpenDoor : public MoveToGoalThenUse
   {
+    static constexpr std::string_view Name = "OpenDoor";
+
     constexpr OpenDoor(OffsetSet doorPosition, DoorColor color_)
       : MoveToGoalThenUse(doorPosition)
       , color{color_}
@@ -97,6 +113,8 @@ namespace Bot
 
   struct PlaceBoulderOnPressurePlate : public MoveToGoalThenUse
   {
+    static constexpr std::string_view Name = "PlaceBoulderOnPressurePlate";
+
     constexpr PlaceBoulderOnPressurePlate(Offset pressurePlatePosition, DoorColor color_)
       : MoveToGoalThenUse(pressurePlatePosition)
       , color{color_}
@@ -108,6 +126,8 @@ namespace Bot
 
   struct FetchKey
   {
+    static constexpr std::string_view Name = "FetchKey";
+
     constexpr FetchKey(Offset keyPosition)
       : position{keyPosition}
     {
@@ -118,24 +138,32 @@ namespace Bot
 
   struct FetchBoulder : public MoveToGoalThenUse
   {
+    static constexpr std::string_view Name = "FetchBoulder";
+
     using MoveToGoalThenUse::MoveToGoalThenUse;
   };
 
   constexpr struct ReconsiderUncheckedBoulders_t
   {
+    static constexpr std::string_view Name = "ReconsiderUncheckedBoulders";
   } ReconsiderUncheckedBoulders;
 
   constexpr struct Wait_t
   {
+    static constexpr std::string_view Name = "Wait";
   } Wait;
 
   constexpr struct LeaveSquare_t
   {
+    static constexpr std::string_view Name = "LeaveSquare";
+
     std::optional<Offset> originalSquare;
   } LeaveSquare;
 
   struct DropDoorOnEnemy
   {
+    static constexpr std::string_view Name = "DropDoorOnEnemy";
+
     OffsetSet doorLocations;
     bool waiting = true;
 
@@ -147,6 +175,8 @@ namespace Bot
 
   struct PeekUnderEnemies
   {
+    static constexpr std::string_view Name = "PeekUnderEnemies";
+
     OffsetSet tileLocations;
 
     PeekUnderEnemies(OffsetSet tileLocations_)
@@ -174,6 +204,24 @@ namespace Bot
     HuntEnemies>;
   using Commands = std::queue<Command>;
 
+  // Every command names itself, so the names can't get out of step with the alternatives of Command
+  namespace Detail
+  {
+    template <typename... Alternatives>
+    consteval bool NamesAreUnique(std::type_identity<std::variant<Alternatives...>>)
+    {
+      std::array<std::string_view, sizeof...(Alternatives)> names{Alternatives::Name...};
+      std::ranges::sort(names);
+      return std::ranges::adjacent_find(names) == names.end();
+    }
+  } // namespace Detail
+  static_assert(Detail::NamesAreUnique(std::type_identity<Command>{}), "A command inherits the Name of another");
+
+  inline std::string_view CommandName(const Command& command)
+  {
+    return std::visit([](const auto& alternative) { return std::remove_cvref_t<decltype(alternative)>::Name; }, command);
+  }
+
 } // namespace Bot
 
 template <typename... Callable>
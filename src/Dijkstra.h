@@ -3,7 +3,6 @@
 #include <algorithm>
 #include <cassert>
 #include <optional>
-#include <print>
 #include <queue>
 #include <ranges>
 #include <tuple>
@@ -11,8 +10,13 @@
 
 #include <LoggingAndDebugging.h>
 
+#include "Allocations.h"
 #include "Formatters.h"
+#include "Logging.h"
+#include "Metrics.h"
 #include "Offset.h"
+#include "Profiling.h"
+#include "SearchStats.h"
 #include "Vector2d.h"
 
 namespace Bot
@@ -40,26 +44,38 @@ namespace Bot
 
   constexpr int Infinity(const Vector2dBase& v) { return 2 * v.Width() * v.Height() * 100; }
 
+  // With caller.stats, the effort of the search is counted for caller.name
   template <typename Callable>
     requires std::is_invocable_v<Callable, Offset>
-  std::tuple<Vector2d<int>, std::optional<Offset>> DistanceMap(const Vector2d<int>& weights, Offset start, Callable&& c)
+  std::tuple<Vector2d<int>, std::optional<Offset>>
+    DistanceMap(const Vector2d<int>& weights, Offset start, Callable&& c, SearchStats::Caller caller = {})
   {
     assert(weights.IsInRange(start));
+    Allocations::Scope scope(Allocations::Phase::Dijkstra);
 
     std::optional<Offset> destination;
     Vector2d<int>         dist(weights.Width(), weights.Height(), Infinity(weights));
     dist[start] = 0;
     std::priority_queue<Detail::QueueEntry> pq;
     pq.emplace(0, start);
+    Metrics::CountDistanceMap();
+    [[maybe_unused]] SearchStats::Search search;
     while(!pq.empty())
     {
       auto [d, p] = pq.top();
       pq.pop();
       assert(dist[p] == d);
+      if constexpr(Profiling::Enabled)
+      {
+        ++search.popped;
+        if(caller.stats && caller.stats->HeatmapEnabled())
+          search.expanded.push_back(p);
+      }
 
       if(std::invoke(std::forward<Callable>(c), p))
       {
         destination = p;
+        search.exit = SearchStats::Exit::Destination;
         break;
       }
 
@@ -75,12 +91,22 @@ namespace Bot
         {
           dist[np] = nd;
           pq.emplace(nd, np);
+          if constexpr(Profiling::Enabled)
+          {
+            ++search.relaxations;
+            search.queueHighWater = std::max(search.queueHighWater, pq.size());
+          }
         }
       }
     }
+    if constexpr(Profiling::Enabled)
+    {
+      if(caller.stats)
+        caller.stats->Record(caller.name, search, weights.Size());
+    }
     if constexpr(Debugging::PrintDistanceMap)
     {
-      std::println("Distance map:");
+      Log::Logger<Log::Category::Path>().Info("Distance map:");
       Print(dist);
     }
     return {dist, destination};
@@ -93,10 +119,10 @@ namespace Bot
 
   template <typename Callable>
     requires std::is_invocable_v<Callable, Offset>
-  std::vector<Offset> ReversedPath(const Vector2d<int>& weights, Offset start, Callable&& c)
+  std::vector<Offset> ReversedPath(const Vector2d<int>& weights, Offset start, Callable&& c, SearchStats::Caller caller = {})
   {
 
-    auto [dist, destination] = DistanceMap(weights, start, std::forward<Callable>(c));
+    auto [dist, destination] = DistanceMap(weights, start, std::forward<Callable>(c), caller);
     std::vector<Offset> path;
     if(destination)
     {
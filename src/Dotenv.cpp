@@ -3,9 +3,15 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include <print>
 #include <ranges>
 
+#include "Logging.h"
+
+namespace
+{
+  constexpr Bot::Log::Logger<Bot::Log::Category::Config> logger;
+} // namespace
+
 void load_dotenv()
 {
   std::ifstream env_file(".env");
@@ -51,7 +57,7 @@ void load_dotenv()
     if(setenv(std::string{key}.c_str(), std::string{value}.c_str(), 1) != 0)
     {
       // Just log and continue
-      std::println("Warning: Failed to set environment variable: {}", key);
+      logger.Warning("Failed to set environment variable: {}", key);
     }
   }
 }
@@ -68,7 +74,7 @@ std::optional<int> get_env_int(std::string_view name)
   }
   catch(const std::exception& ex)
   {
-    std::println("Invalid integer value for {}: {}", name, ex.what());
+    logger.Error("Invalid integer value for {}: {}", name, ex.what());
     return std::nullopt;
   }
 }
@@ -87,7 +93,8 @@ std::string require_env_str(std::string_view name)
   auto value = get_env_str(name);
   if(!value)
   {
-    std::println("Environment variable {} not set", name);
+    logger.Error("Environment variable {} not set", name);
+    Bot::Log::Flush();
     std::exit(-1);
   }
   return *value;
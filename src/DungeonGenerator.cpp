@@ -0,0 +1,290 @@
+#include "DungeonGenerator.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "LineOfSight.h"
+#include "MazeGeneration.h"
+#include "TileProperties.h"
+
+namespace Bot
+{
+  namespace
+  {
+    using namespace Generation;
+
+    // Rooms are split while both halves can be at least this wide
+    constexpr int MinimumRoomSize = 3;
+    constexpr int EnemyDistance = 6;
+
+    // Walls and closed doors block the line of sight. All doors are closed.
+    bool IsOpaque(Tile tile) { return tile == Tile::TILE_WALL || IsDoor(tile); }
+
+    bool IsWalkable(Tile tile) { return !IsOpaque(tile) && tile != Tile::TILE_BOULDER && tile != Tile::TILE_ENEMY; }
+
+    Vector2d<Tile> ViewAt(const Vector2d<Tile>& tiles, Offset position, int visibility)
+    {
+      Vector2d<Tile> view(2 * visibility + 1, 2 * visibility + 1, Tile::TILE_UNKNOWN);
+      const Offset corner = position - Offset{visibility, visibility};
+      for(std::size_t i = 0; i < view.Data().size(); ++i)
+      {
+        const Offset target = corner + view.ToOffset(i);
+        if(tiles.IsInRange(target) && CanSee(position, target, visibility, [&](Offset p) { return IsOpaque(tiles[p]); }))
+          view[i] = tiles[target];
+      }
+      view[Offset{visibility, visibility}] = Tile::TILE_PLAYER;
+      return view;
+    }
+
+    class Generator
+    {
+    public:
+      Generator(Offset size, std::uint64_t seed)
+        : m_random(seed)
+        , m_tiles(size.x, size.y, Tile::TILE_WALL)
+      {
+      }
+
+      GeneratedDungeon Generate(DungeonStyle style)
+      {
+        switch(style)
+        {
+        case DungeonStyle::OpenRooms:
+        case DungeonStyle::BoulderField:
+          CarveRooms();
+          break;
+        case DungeonStyle::PerfectMaze:
+        case DungeonStyle::DoorChain:
+          CarveMaze(m_tiles, m_random, false);
+          break;
+        case DungeonStyle::BraidedMaze:
+        case DungeonStyle::Enemies:
+          CarveMaze(m_tiles, m_random, true);
+          break;
+        }
+
+        m_start = m_random.Pick(OpenCells(m_tiles));
+        const auto fromStart = Distances(m_tiles, m_start);
+        m_exit = Farthest(fromStart);
+        m_tiles[m_exit] = Tile::TILE_EXIT;
+        m_path = Path(fromStart, m_exit);
+
+        switch(style)
+        {
+        case DungeonStyle::DoorChain:
+          DoorChain();
+          break;
+        case DungeonStyle::BoulderField:
+          BoulderField();
+          break;
+        case DungeonStyle::Enemies:
+          PlaceEnemies(fromStart);
+          break;
+        case DungeonStyle::OpenRooms:
+        case DungeonStyle::PerfectMaze:
+        case DungeonStyle::BraidedMaze:
+          break;
+        }
+
+        return {std::move(m_tiles), m_start, m_exit};
+      }
+
+    private:
+      [[nodiscard]] bool IsFree(Offset position) const
+      {
+        return m_tiles.IsInRange(position) && m_tiles[position] == Tile::TILE_EMPTY && position != m_start;
+      }
+
+      // The free cells of a region, off the path to the exit if possible
+      [[nodiscard]] std::vector<Offset> FreeCells(const std::vector<Offset>& region) const
+      {
+        std::vector<Offset> result;
+        std::vector<Offset> onPath;
+        for(const auto& position: region)
+        {
+          if(IsFree(position))
+            (std::ranges::contains(m_path, position) ? onPath : result).push_back(position);
+        }
+        return result.empty() ? onPath : result;
+      }
+
+      void PlaceInRegion(const std::vector<Offset>& region, Tile tile)
+      {
+        if(!region.empty())
+          m_tiles[m_random.Pick(region)] = tile;
+      }
+
+      // Doors split the path to the exit in equal parts
+      std::vector<Offset> PlaceDoorsOnPath(std::size_t count)
+      {
+        const auto doors = DoorsOnPath(m_path, count);
+        for(std::size_t i = 0; i < doors.size(); ++i)
+        {
+          m_tiles[doors[i]] = DoorTiles[i];
+        }
+        return doors;
+      }
+
+      // Recursive division: every wall gets one gap. Walls are on even coordinates and gaps on odd ones, so a wall never
+      // closes the gap of an earlier one.
+      void CarveRooms()
+      {
+        struct Area
+        {
+          Offset min;
+          Offset max;
+        };
+
+        CarveRoom(m_tiles);
+
+        auto walls = [](int min, int max)
+        {
+          std::vector<int> result;
+          for(int i = min + MinimumRoomSize; i <= max - MinimumRoomSize; ++i)
+          {
+            if(i % 2 == 0)
+              result.push_back(i);
+          }
+          return result;
+        };
+
+        auto gaps = [](int min, int max)
+        {
+          std::vector<int> result;
+          for(int i = min; i <= max; ++i)
+          {
+            if(i % 2 == 1)
+              result.push_back(i);
+          }
+          return result;
+        };
+
+        std::vector<Area> areas{{Offset{1, 1}, m_tiles.Size() - Offset{2, 2}}};
+        while(!areas.empty())
+        {
+          const Area area = areas.back();
+          areas.pop_back();
+
+          const auto columns = walls(area.min.x, area.max.x);
+          const auto rows = walls(area.min.y, area.max.y);
+          if(columns.empty() && rows.empty())
+            continue;
+
+          const Offset size = area.max - area.min;
+          const bool vertical = rows.empty() || (!columns.empty() && (size.x != size.y ? size.x > size.y : m_random.Below(2) == 0));
+          if(vertical)
+          {
+            const int x = m_random.Pick(columns);
+            for(int y = area.min.y; y <= area.max.y; ++y)
+              m_tiles[Offset{x, y}] = Tile::TILE_WALL;
+            m_tiles[Offset{x, m_random.Pick(gaps(area.min.y, area.max.y))}] = Tile::TILE_EMPTY;
+            areas.push_back({area.min, Offset{x - 1, area.max.y}});
+            areas.push_back({Offset{x + 1, area.min.y}, area.max});
+          }
+          else
+          {
+            const int y = m_random.Pick(rows);
+            for(int x = area.min.x; x <= area.max.x; ++x)
+              m_tiles[Offset{x, y}] = Tile::TILE_WALL;
+            m_tiles[Offset{m_random.Pick(gaps(area.min.x, area.max.x)), y}] = Tile::TILE_EMPTY;
+            areas.push_back({area.min, Offset{area.max.x, y - 1}});
+            areas.push_back({Offset{area.min.x, y + 1}, area.max});
+          }
+        }
+      }
+
+      // The key of each door lies behind the door before it
+      void DoorChain()
+      {
+        const auto doors = PlaceDoorsOnPath(DoorTiles.size());
+        for(std::size_t i = 0; i < doors.size(); ++i)
+        {
+          PlaceInRegion(FreeCells(KeyRegion(m_tiles, m_start, doors, i)), KeyTiles[i]);
+        }
+      }
+
+      // One boulder in front of the door for the plate, like the server's pressure plate level, and one boulder in twenty
+      // free cells off the path to the exit
+      void BoulderField()
+      {
+        const auto doors = PlaceDoorsOnPath(1);
+        const auto inFront = Region(m_tiles, m_start, doors);
+        PlaceInRegion(FreeCells(inFront), Tile::TILE_PRESSURE_PLATE_RED);
+        PlaceInRegion(FreeCells(inFront), Tile::TILE_BOULDER);
+
+        for(const auto& position: FreeCells(Region(m_tiles, m_start, {})))
+        {
+          if(std::ranges::find(m_path, position) == m_path.end() && m_random.Below(20) == 0)
+            m_tiles[position] = Tile::TILE_BOULDER;
+        }
+      }
+
+      // One enemy per 150 open cells
+      void PlaceEnemies(const Vector2d<int>& fromStart)
+      {
+        std::vector<Offset> candidates;
+        for(const auto& position: OpenCells(m_tiles))
+        {
+          if(IsFree(position) && fromStart[position] >= EnemyDistance)
+            candidates.push_back(position);
+        }
+
+        std::size_t count = std::max<std::size_t>(OpenCells(m_tiles).size() / 150, 1);
+        while(count-- > 0 && !candidates.empty())
+        {
+          const auto index = m_random.Below(candidates.size());
+          m_tiles[candidates[index]] = Tile::TILE_ENEMY;
+          candidates.erase(candidates.begin() + static_cast<std::ptrdiff_t>(index));
+        }
+      }
+
+      Random m_random;
+      Vector2d<Tile> m_tiles;
+      Offset m_start{0, 0};
+      Offset m_exit{0, 0};
+      std::vector<Offset> m_path;
+    };
+  } // namespace
+
+  GeneratedDungeon GenerateDungeon(DungeonStyle style, Offset size, std::uint64_t seed)
+  {
+    assert(size.x >= 5 && size.y >= 5);
+    return Generator(size, seed ^ (std::uint64_t{static_cast<std::uint8_t>(style)} << 56)).Generate(style);
+  }
+
+  std::vector<WalkStep> GenerateWalk(const GeneratedDungeon& dungeon, int visibility, std::size_t steps, std::uint64_t seed)
+  {
+    Random random(seed);
+    const auto& tiles = dungeon.tiles;
+    Vector2d<int> visited(tiles.Width(), tiles.Height(), 0);
+    std::vector<Offset> stack{dungeon.start};
+    visited[dungeon.start] = 1;
+
+    std::vector<WalkStep> walk;
+    while(walk.size() < steps && !stack.empty())
+    {
+      const Offset position = stack.back();
+      walk.push_back({position, ViewAt(tiles, position, visibility)});
+
+      std::vector<Offset> options;
+      for(auto direction: Directions)
+      {
+        const Offset next = position + direction;
+        if(tiles.IsInRange(next) && IsWalkable(tiles[next]) && visited[next] == 0)
+          options.push_back(next);
+      }
+
+      if(options.empty())
+      {
+        stack.pop_back();
+        continue;
+      }
+
+      const Offset next = random.Pick(options);
+      visited[next] = 1;
+      stack.push_back(next);
+    }
+    return walk;
+  }
+
+} // namespace Bot
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Offset.h"
+#include "Swoq.pb.h"
+#include "Vector2d.h"
+
+namespace Bot
+{
+  using Swoq::Interface::Tile;
+
+  // Maps for benchmarks and tests, of any size. Deterministic for a given style, size and seed, on every platform.
+  enum class DungeonStyle : std::uint8_t
+  {
+    // Rooms connected by doorways
+    OpenRooms,
+    // Exactly one path between any two cells
+    PerfectMaze,
+    // A maze with half of the dead ends opened up, so there are loops
+    BraidedMaze,
+    // A perfect maze with red, green and blue doors on the path to the exit, each with its key before it
+    DoorChain,
+    // Rooms with boulders, and a pressure plate for the red door on the path to the exit
+    BoulderField,
+    // A braided maze with enemies, away from the start
+    Enemies,
+  };
+
+  inline constexpr std::array DungeonStyleNames{"OpenRooms", "PerfectMaze", "BraidedMaze", "DoorChain", "BoulderField", "Enemies"};
+
+  struct GeneratedDungeon
+  {
+    // Enemies are tiles too, they don't move
+    Vector2d<Tile> tiles;
+    Offset start;
+    // The farthest cell from the start
+    Offset exit;
+  };
+
+  // The size must be at least 5 by 5
+  GeneratedDungeon GenerateDungeon(DungeonStyle style, Offset size, std::uint64_t seed);
+
+  struct WalkStep
+  {
+    Offset position;
+    // Like the view of ViewFromState: centered on the player, unknown where walls and doors block the line of sight
+    Vector2d<Tile> view;
+  };
+
+  // A depth first exploration from the start, stepping back along the way it came at dead ends. Stops after the given
+  // number of steps, or when everything reachable has been visited.
+  std::vector<WalkStep> GenerateWalk(const GeneratedDungeon& dungeon, int visibility, std::size_t steps, std::uint64_t seed);
+
+} // namespace Bot
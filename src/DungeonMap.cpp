@@ -2,8 +2,8 @@
 
 #include <algorithm>
 #include <cassert>
-#include <print>
 
+#include "Logging.h"
 #include "LoggingAndDebugging.h"
 #include "Swoq.hpp"
 #include "TileProperties.h"
@@ -12,6 +12,8 @@ namespace Bot
 {
   namespace
   {
+    constexpr Log::Logger<Log::Category::Map> logger;
+
     bool AreTilesConsistent(Tile viewTile, Tile destinationTile)
     {
       bool const result = viewTile == Tile::TILE_UNKNOWN || destinationTile == Tile::TILE_UNKNOWN || viewTile == destinationTile
@@ -19,7 +21,7 @@ namespace Bot
                        || CanMove(destinationTile) || IsDoor(destinationTile);
 
       if(!result)
-        std::println("DungeonMap: Tiles are not consistent: view {}, destination {}", viewTile, destinationTile);
+        logger.Warning("DungeonMap: Tiles are not consistent: view {}, destination {}", viewTile, destinationTile);
 
       return result;
     }
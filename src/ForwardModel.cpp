@@ -0,0 +1,548 @@
+#include "ForwardModel.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <format>
+
+#include "LineOfSight.h"
+#include "TileProperties.h"
+
+namespace Bot
+{
+  namespace
+  {
+    using Cell = ForwardModel::Cell;
+    using Object = ForwardModel::Object;
+    using State = ForwardModel::State;
+
+    constexpr std::uint8_t NoColor = 0xff;
+
+    constexpr std::uint8_t DoorIndex(Cell cell)
+    {
+      switch(cell)
+      {
+      case Cell::DoorRed:
+        return 0;
+      case Cell::DoorGreen:
+        return 1;
+      case Cell::DoorBlue:
+        return 2;
+      default:
+        return NoColor;
+      }
+    }
+
+    constexpr std::uint8_t PlateIndex(Cell cell)
+    {
+      switch(cell)
+      {
+      case Cell::PlateRed:
+        return 0;
+      case Cell::PlateGreen:
+        return 1;
+      case Cell::PlateBlue:
+        return 2;
+      default:
+        return NoColor;
+      }
+    }
+
+    constexpr std::uint8_t KeyIndex(Inventory inventory)
+    {
+      switch(inventory)
+      {
+      case Inventory::INVENTORY_KEY_RED:
+        return 0;
+      case Inventory::INVENTORY_KEY_GREEN:
+        return 1;
+      case Inventory::INVENTORY_KEY_BLUE:
+        return 2;
+      default:
+        return NoColor;
+      }
+    }
+
+    constexpr Inventory InventoryFromKey(Tile key)
+    {
+      switch(key)
+      {
+      case Tile::TILE_KEY_RED:
+        return Inventory::INVENTORY_KEY_RED;
+      case Tile::TILE_KEY_GREEN:
+        return Inventory::INVENTORY_KEY_GREEN;
+      case Tile::TILE_KEY_BLUE:
+        return Inventory::INVENTORY_KEY_BLUE;
+      default:
+        return Inventory::INVENTORY_NONE;
+      }
+    }
+
+    constexpr Cell CellFromTile(Tile tile)
+    {
+      switch(tile)
+      {
+      case Tile::TILE_UNKNOWN:
+      case Tile::TILE_WALL:
+        return Cell::Wall;
+      case Tile::TILE_EXIT:
+        return Cell::Exit;
+      case Tile::TILE_DOOR_RED:
+        return Cell::DoorRed;
+      case Tile::TILE_DOOR_GREEN:
+        return Cell::DoorGreen;
+      case Tile::TILE_DOOR_BLUE:
+        return Cell::DoorBlue;
+      case Tile::TILE_PRESSURE_PLATE_RED:
+        return Cell::PlateRed;
+      case Tile::TILE_PRESSURE_PLATE_GREEN:
+        return Cell::PlateGreen;
+      case Tile::TILE_PRESSURE_PLATE_BLUE:
+        return Cell::PlateBlue;
+      default:
+        return Cell::Floor;
+      }
+    }
+
+    constexpr Tile TileFromCell(Cell cell)
+    {
+      switch(cell)
+      {
+      case Cell::Wall:
+        return Tile::TILE_WALL;
+      case Cell::Exit:
+        return Tile::TILE_EXIT;
+      case Cell::DoorRed:
+        return Tile::TILE_DOOR_RED;
+      case Cell::DoorGreen:
+        return Tile::TILE_DOOR_GREEN;
+      case Cell::DoorBlue:
+        return Tile::TILE_DOOR_BLUE;
+      case Cell::PlateRed:
+        return Tile::TILE_PRESSURE_PLATE_RED;
+      case Cell::PlateGreen:
+        return Tile::TILE_PRESSURE_PLATE_GREEN;
+      case Cell::PlateBlue:
+        return Tile::TILE_PRESSURE_PLATE_BLUE;
+      case Cell::Floor:
+        break;
+      }
+      return Tile::TILE_EMPTY;
+    }
+
+    constexpr Offset DirectionOf(DirectedAction action)
+    {
+      using enum Swoq::Interface::DirectedAction;
+      switch(action)
+      {
+      case DIRECTED_ACTION_MOVE_NORTH:
+      case DIRECTED_ACTION_USE_NORTH:
+        return North;
+      case DIRECTED_ACTION_MOVE_EAST:
+      case DIRECTED_ACTION_USE_EAST:
+        return East;
+      case DIRECTED_ACTION_MOVE_SOUTH:
+      case DIRECTED_ACTION_USE_SOUTH:
+        return South;
+      case DIRECTED_ACTION_MOVE_WEST:
+      case DIRECTED_ACTION_USE_WEST:
+        return West;
+      default:
+        return Offset{0, 0};
+      }
+    }
+
+    constexpr bool IsUse(DirectedAction action)
+    {
+      using enum Swoq::Interface::DirectedAction;
+      return action == DIRECTED_ACTION_USE_NORTH || action == DIRECTED_ACTION_USE_EAST || action == DIRECTED_ACTION_USE_SOUTH
+          || action == DIRECTED_ACTION_USE_WEST;
+    }
+
+    int Distance(Offset a, Offset b) { return std::abs(a.x - b.x) + std::abs(a.y - b.y); }
+
+    Object* FindObject(State& state, Offset position)
+    {
+      for(std::size_t i = 0; i < state.objectCount; ++i)
+      {
+        if(state.objects[i].position == position)
+          return &state.objects[i];
+      }
+      return nullptr;
+    }
+
+    const Object* FindObject(const State& state, Offset position)
+    {
+      for(std::size_t i = 0; i < state.objectCount; ++i)
+      {
+        if(state.objects[i].position == position)
+          return &state.objects[i];
+      }
+      return nullptr;
+    }
+
+    void RemoveObject(State& state, Object& object)
+    {
+      object = state.objects[--state.objectCount];
+    }
+
+    bool AddObject(State& state, Offset position, Tile tile)
+    {
+      if(state.objectCount == ForwardModel::MaxObjects)
+        return false;
+      state.objects[state.objectCount++] = {position, tile};
+      return true;
+    }
+
+    bool HasPlayer(const State& state, Offset position)
+    {
+      return std::ranges::any_of(
+        state.players, [&](const auto& player) { return player.present && player.position == position; });
+    }
+
+    ForwardModel::Enemy* FindEnemy(State& state, Offset position)
+    {
+      for(std::size_t i = 0; i < state.enemyCount; ++i)
+      {
+        if(state.enemies[i].alive && state.enemies[i].position == position)
+          return &state.enemies[i];
+      }
+      return nullptr;
+    }
+
+    bool HasEnemy(const State& state, Offset position)
+    {
+      for(std::size_t i = 0; i < state.enemyCount; ++i)
+      {
+        if(state.enemies[i].alive && state.enemies[i].position == position)
+          return true;
+      }
+      return false;
+    }
+  } // namespace
+
+  ForwardModel::ForwardModel(const Vector2d<Tile>& map, int visibility)
+    : m_cells(map.Width(), map.Height(), Cell::Wall)
+    , m_visibility(visibility)
+  {
+    for(std::size_t i = 0; i < map.Data().size(); ++i)
+    {
+      m_cells[i] = CellFromTile(map[i]);
+      if(DoorIndex(m_cells[i]) != NoColor)
+        m_doors.push_back(map.ToOffset(i));
+      else if(PlateIndex(m_cells[i]) != NoColor)
+        m_plates.push_back(map.ToOffset(i));
+    }
+  }
+
+  std::expected<ForwardModel, std::string>
+    ForwardModel::Create(const Vector2d<Tile>& map, std::span<const PlayerStart> players, int visibility)
+  {
+    ForwardModel model(map, visibility);
+    auto& initial = model.m_initial;
+    if(players.size() > initial.players.size())
+      return std::unexpected(std::format("{} players, at most {} are supported", players.size(), initial.players.size()));
+
+    for(std::size_t i = 0; i < map.Data().size(); ++i)
+    {
+      const Tile tile = map[i];
+      const Offset position = map.ToOffset(i);
+      if(tile == Tile::TILE_ENEMY)
+      {
+        if(initial.enemyCount == MaxEnemies)
+          return std::unexpected(std::format("More than {} enemies", MaxEnemies));
+        initial.enemies[initial.enemyCount++] = {position, true};
+      }
+      else if(IsKey(tile) || tile == Tile::TILE_BOULDER || tile == Tile::TILE_SWORD || tile == Tile::TILE_HEALTH)
+      {
+        if(!AddObject(initial, position, tile))
+          return std::unexpected(std::format("More than {} objects", MaxObjects));
+      }
+    }
+
+    for(std::size_t i = 0; i < players.size(); ++i)
+    {
+      const auto& start = players[i];
+      initial.players[i] = {start.position, static_cast<std::int16_t>(start.health), start.inventory, start.hasSword, true};
+    }
+    initial.pressed = model.Pressed(initial);
+    return model;
+  }
+
+  ActResult ForwardModel::Step(State& state, DirectedAction action, DirectedAction action2) const
+  {
+    if(state.status != GameStatus::GAME_STATUS_ACTIVE)
+      return ActResult::ACT_RESULT_GAME_FINISHED;
+
+    if(action2 == DirectedAction::DIRECTED_ACTION_NONE)
+    {
+      if(auto result = Perform(state, 0, action); result != ActResult::ACT_RESULT_OK)
+        return result;
+    }
+    else
+    {
+      // Only the second action can fail after the first one changed the state
+      const State before = state;
+      if(auto result = Perform(state, 0, action); result != ActResult::ACT_RESULT_OK)
+        return result;
+      if(auto result = Perform(state, 1, action2); result != ActResult::ACT_RESULT_OK)
+      {
+        state = before;
+        return result;
+      }
+    }
+
+    ++state.tick;
+    UpdateDoors(state);
+    if(state.tick % 2 == 0)
+    {
+      MoveEnemies(state);
+      UpdateDoors(state);
+    }
+    UpdateStatus(state);
+    return ActResult::ACT_RESULT_OK;
+  }
+
+  Tile ForwardModel::TileAt(const State& state, Offset position) const
+  {
+    if(!m_cells.IsInRange(position))
+      return Tile::TILE_UNKNOWN;
+    if(HasPlayer(state, position))
+      return Tile::TILE_PLAYER;
+    if(HasEnemy(state, position))
+      return Tile::TILE_ENEMY;
+    if(const auto* object = FindObject(state, position))
+      return object->tile;
+
+    const Cell cell = m_cells[position];
+    if(DoorIndex(cell) != NoColor && IsDoorOpen(state, cell))
+      return Tile::TILE_EMPTY;
+    return TileFromCell(cell);
+  }
+
+  ActResult ForwardModel::Perform(State& state, std::size_t playerId, DirectedAction action) const
+  {
+    if(action == DirectedAction::DIRECTED_ACTION_NONE)
+      return ActResult::ACT_RESULT_OK;
+
+    auto& player = state.players[playerId];
+    if(!player.present)
+      return playerId == 0 ? ActResult::ACT_RESULT_PLAYER_NOT_PRESENT : ActResult::ACT_RESULT_PLAYER2_NOT_PRESENT;
+
+    const Offset direction = DirectionOf(action);
+    if(direction == Offset{0, 0})
+      return ActResult::ACT_RESULT_UNKNOWN_ACTION;
+
+    const Offset target = player.position + direction;
+    return IsUse(action) ? Use(state, player, target) : Move(state, player, target);
+  }
+
+  ActResult ForwardModel::Move(State& state, Player& player, Offset target) const
+  {
+    if(!IsWalkable(state, target, false))
+      return ActResult::ACT_RESULT_MOVE_NOT_ALLOWED;
+
+    player.position = target;
+    if(m_cells[target] == Cell::Exit)
+    {
+      player.present = false;
+      return ActResult::ACT_RESULT_OK;
+    }
+
+    auto* object = FindObject(state, target);
+    if(!object)
+      return ActResult::ACT_RESULT_OK;
+
+    if(IsKey(object->tile) && player.inventory == Inventory::INVENTORY_NONE)
+    {
+      player.inventory = InventoryFromKey(object->tile);
+      RemoveObject(state, *object);
+    }
+    else if(object->tile == Tile::TILE_SWORD)
+    {
+      player.hasSword = true;
+      RemoveObject(state, *object);
+    }
+    else if(object->tile == Tile::TILE_HEALTH)
+    {
+      ++player.health;
+      RemoveObject(state, *object);
+    }
+    return ActResult::ACT_RESULT_OK;
+  }
+
+  ActResult ForwardModel::Use(State& state, Player& player, Offset target) const
+  {
+    if(!m_cells.IsInRange(target))
+      return ActResult::ACT_RESULT_USE_NOT_ALLOWED;
+
+    if(auto* enemy = FindEnemy(state, target))
+    {
+      if(!player.hasSword)
+        return ActResult::ACT_RESULT_NO_SWORD;
+      enemy->alive = false;
+      return ActResult::ACT_RESULT_OK;
+    }
+
+    const Cell cell = m_cells[target];
+    if(const auto color = DoorIndex(cell); color != NoColor && !IsDoorOpen(state, cell))
+    {
+      if(player.inventory == Inventory::INVENTORY_NONE)
+        return ActResult::ACT_RESULT_INVENTORY_EMPTY;
+      if(KeyIndex(player.inventory) != color)
+        return ActResult::ACT_RESULT_USE_NOT_ALLOWED;
+
+      state.unlocked = static_cast<std::uint8_t>(state.unlocked | (1u << color));
+      player.inventory = Inventory::INVENTORY_NONE;
+      return ActResult::ACT_RESULT_OK;
+    }
+
+    auto* object = FindObject(state, target);
+    if(object && object->tile == Tile::TILE_BOULDER)
+    {
+      if(player.inventory != Inventory::INVENTORY_NONE)
+        return ActResult::ACT_RESULT_INVENTORY_FULL;
+
+      player.inventory = Inventory::INVENTORY_BOULDER;
+      RemoveObject(state, *object);
+      return ActResult::ACT_RESULT_OK;
+    }
+
+    const bool isFloor = cell == Cell::Floor || PlateIndex(cell) != NoColor;
+    if(isFloor && !object && !HasPlayer(state, target))
+    {
+      if(player.inventory == Inventory::INVENTORY_NONE)
+        return ActResult::ACT_RESULT_INVENTORY_EMPTY;
+      if(player.inventory != Inventory::INVENTORY_BOULDER || !AddObject(state, target, Tile::TILE_BOULDER))
+        return ActResult::ACT_RESULT_USE_NOT_ALLOWED;
+
+      player.inventory = Inventory::INVENTORY_NONE;
+      return ActResult::ACT_RESULT_OK;
+    }
+
+    return ActResult::ACT_RESULT_USE_NOT_ALLOWED;
+  }
+
+  void ForwardModel::UpdateDoors(State& state) const
+  {
+    std::uint8_t pressed = Pressed(state);
+    const std::uint8_t closing = static_cast<std::uint8_t>(state.pressed & ~pressed & ~state.unlocked);
+    if(closing != 0)
+    {
+      for(const auto& door: m_doors)
+      {
+        const auto color = DoorIndex(m_cells[door]);
+        if((closing & (1u << color)) == 0)
+          continue;
+
+        // A closing door crushes an enemy, but won't close on a player
+        if(HasPlayer(state, door))
+          pressed = static_cast<std::uint8_t>(pressed | (1u << color));
+        else if(auto* enemy = FindEnemy(state, door))
+          enemy->alive = false;
+      }
+    }
+    state.pressed = pressed;
+  }
+
+  void ForwardModel::MoveEnemies(State& state) const
+  {
+    for(std::size_t i = 0; i < state.enemyCount; ++i)
+    {
+      auto& enemy = state.enemies[i];
+      if(!enemy.alive)
+        continue;
+
+      const Offset* target = nullptr;
+      bool attacked = false;
+      for(auto& player: state.players)
+      {
+        if(!player.present)
+          continue;
+        if(Distance(enemy.position, player.position) == 1)
+        {
+          --player.health;
+          attacked = true;
+          break;
+        }
+        if(CanSee(state, enemy.position, player.position)
+           && (!target || Distance(enemy.position, player.position) < Distance(enemy.position, *target)))
+        {
+          target = &player.position;
+        }
+      }
+      if(attacked || !target)
+        continue;
+
+      // Greedy instead of the server's shortest path, to stay allocation free. The two agree unless a boulder, door or
+      // other enemy is in the way; then this enemy waits where the server's walks around.
+      int best = Distance(enemy.position, *target);
+      Offset next = enemy.position;
+      for(auto direction: Directions)
+      {
+        const Offset candidate = enemy.position + direction;
+        if(Distance(candidate, *target) < best && IsWalkable(state, candidate, true))
+        {
+          best = Distance(candidate, *target);
+          next = candidate;
+        }
+      }
+      enemy.position = next;
+    }
+  }
+
+  void ForwardModel::UpdateStatus(State& state) const
+  {
+    if(state.players[0].present && state.players[0].health <= 0)
+      state.status = GameStatus::GAME_STATUS_FINISHED_PLAYER_DIED;
+    else if(state.players[1].present && state.players[1].health <= 0)
+      state.status = GameStatus::GAME_STATUS_FINISHED_PLAYER2_DIED;
+    else if(std::ranges::none_of(state.players, &Player::present))
+      state.status = GameStatus::GAME_STATUS_FINISHED_SUCCESS;
+  }
+
+  std::uint8_t ForwardModel::Pressed(const State& state) const
+  {
+    std::uint8_t pressed = 0;
+    for(const auto& plate: m_plates)
+    {
+      const auto* object = FindObject(state, plate);
+      if((object && object->tile == Tile::TILE_BOULDER) || HasPlayer(state, plate) || HasEnemy(state, plate))
+        pressed = static_cast<std::uint8_t>(pressed | (1u << PlateIndex(m_cells[plate])));
+    }
+    return pressed;
+  }
+
+  bool ForwardModel::IsDoorOpen(const State& state, Cell cell) const
+  {
+    return ((state.unlocked | state.pressed) & (1u << DoorIndex(cell))) != 0;
+  }
+
+  bool ForwardModel::IsOpaque(const State& state, Offset position) const
+  {
+    const Cell cell = m_cells[position];
+    return cell == Cell::Wall || (DoorIndex(cell) != NoColor && !IsDoorOpen(state, cell));
+  }
+
+  bool ForwardModel::CanSee(const State& state, Offset from, Offset to) const
+  {
+    return Bot::CanSee(from, to, m_visibility, [&](Offset position) { return IsOpaque(state, position); });
+  }
+
+  bool ForwardModel::IsWalkable(const State& state, Offset position, bool forEnemy) const
+  {
+    if(!m_cells.IsInRange(position))
+      return false;
+
+    const Cell cell = m_cells[position];
+    if(cell == Cell::Wall || (forEnemy && cell == Cell::Exit))
+      return false;
+    if(DoorIndex(cell) != NoColor && !IsDoorOpen(state, cell))
+      return false;
+    if(HasPlayer(state, position) || HasEnemy(state, position))
+      return false;
+
+    const auto* object = FindObject(state, position);
+    return !object || object->tile != Tile::TILE_BOULDER;
+  }
+
+} // namespace Bot
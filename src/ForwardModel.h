@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Swoq.pb.h"
+#include "Vector2d.h"
+
+namespace Bot
+{
+  using Swoq::Interface::ActResult;
+  using Swoq::Interface::DirectedAction;
+  using Swoq::Interface::GameStatus;
+  using Swoq::Interface::Inventory;
+  using Swoq::Interface::Tile;
+
+  // Simulates game ticks on a snapshot of the map, for rollouts while planning. Walls, doors, pressure plates and the
+  // exit are shared by all states. A State only holds what can change, so cloning is a plain copy and Step doesn't
+  // allocate. Unknown tiles are treated as walls.
+  //
+  // Where it differs from the server (server/GameState.cpp):
+  // - Enemies step greedily towards the player they see, instead of along a shortest path.
+  // - The bot can't see which enemy carries a key, so a killed enemy never drops one.
+  class ForwardModel
+  {
+  public:
+    static constexpr std::size_t MaxEnemies = 4;
+    static constexpr std::size_t MaxObjects = 64;
+    static constexpr int DefaultHealth = 5;
+
+    enum class Cell : std::uint8_t
+    {
+      Floor,
+      Wall,
+      Exit,
+      DoorRed,
+      DoorGreen,
+      DoorBlue,
+      PlateRed,
+      PlateGreen,
+      PlateBlue,
+    };
+
+    struct Player
+    {
+      Offset position{0, 0};
+      std::int16_t health = DefaultHealth;
+      Inventory inventory = Inventory::INVENTORY_NONE;
+      bool hasSword = false;
+      bool present = false;
+    };
+
+    struct Enemy
+    {
+      Offset position{0, 0};
+      bool alive = false;
+    };
+
+    // Boulders, keys, swords and health
+    struct Object
+    {
+      Offset position{0, 0};
+      Tile tile = Tile::TILE_UNKNOWN;
+    };
+
+    struct State
+    {
+      std::array<Player, 2> players{};
+      std::array<Enemy, MaxEnemies> enemies{};
+      std::array<Object, MaxObjects> objects{};
+      std::uint8_t enemyCount = 0;
+      std::uint8_t objectCount = 0;
+      std::uint8_t unlocked = 0;
+      std::uint8_t pressed = 0;
+      int tick = 0;
+      GameStatus status = GameStatus::GAME_STATUS_ACTIVE;
+
+      [[nodiscard]] State Clone() const { return *this; }
+    };
+
+    struct PlayerStart
+    {
+      Offset position;
+      Inventory inventory = Inventory::INVENTORY_NONE;
+      int health = DefaultHealth;
+      bool hasSword = false;
+    };
+
+    // Fails when there are more players, enemies or objects than a State has room for
+    static std::expected<ForwardModel, std::string>
+      Create(const Vector2d<Tile>& map, std::span<const PlayerStart> players, int visibility);
+
+    [[nodiscard]] const State& Initial() const { return m_initial; }
+
+    // Like the server, a rejected action leaves the state as it was
+    ActResult Step(State& state, DirectedAction action, DirectedAction action2 = DirectedAction::DIRECTED_ACTION_NONE) const;
+
+    [[nodiscard]] Tile TileAt(const State& state, Offset position) const;
+
+  private:
+    ForwardModel(const Vector2d<Tile>& map, int visibility);
+
+    ActResult Perform(State& state, std::size_t playerId, DirectedAction action) const;
+    ActResult Move(State& state, Player& player, Offset target) const;
+    ActResult Use(State& state, Player& player, Offset target) const;
+    void UpdateDoors(State& state) const;
+    void MoveEnemies(State& state) const;
+    void UpdateStatus(State& state) const;
+
+    [[nodiscard]] std::uint8_t Pressed(const State& state) const;
+    [[nodiscard]] bool IsDoorOpen(const State& state, Cell cell) const;
+    [[nodiscard]] bool IsOpaque(const State& state, Offset position) const;
+    [[nodiscard]] bool CanSee(const State& state, Offset from, Offset to) const;
+    [[nodiscard]] bool IsWalkable(const State& state, Offset position, bool forEnemy) const;
+
+    Vector2d<Cell> m_cells;
+    std::vector<Offset> m_doors;
+    std::vector<Offset> m_plates;
+    int m_visibility;
+    State m_initial;
+  };
+
+  static_assert(std::is_trivially_copyable_v<ForwardModel::State>);
+
+} // namespace Bot
@@ -1,40 +1,141 @@
 #include "Game.h"
 
-#include <print>
+#include <algorithm>
 #include <ranges>
 
 #include <sys/stat.h>
 
 #include "Dijkstra.h"
+#include "Logging.h"
 #include "LoggingAndDebugging.h"
+#include "SearchStats.h"
+#include "TaskPool.h"
 
 namespace Bot
 {
   namespace
   {
+    constexpr Log::Logger<Log::Category::Game> logger;
+
     constexpr bool IsEngagingEnemy(Game::PlayerState playerState)
     {
       return playerState == Game::PlayerState::PeekingBelowEnemy || playerState == Game::PlayerState::AttackingEnemy
           || playerState == Game::PlayerState::DroppingDoorOnEnemy;
     }
+
+    Options WithTaskPool(Options options)
+    {
+      if(!options.taskPool)
+      {
+        options.taskPool = TaskPool::Shared();
+      }
+      return options;
+    }
+
+    OffsetSet OriginalEnemyLocations(const DungeonMap& map)
+    {
+      OffsetSet enemyLocations;
+      for(const auto offset: OffsetsInRectangle(map.Size()))
+      {
+        if(map[offset] == Tile::TILE_ENEMY)
+        {
+          enemyLocations.insert(offset);
+        }
+      }
+      return enemyLocations;
+    }
+
+    std::optional<DoorColor> DoorToOpen(const PlayerMap& map)
+    {
+      for(auto color: DoorColors)
+      {
+        auto doorData = map.DoorData().at(color);
+        if(
+          !doorData.doorPosition.empty() && doorData.keyPosition && map.NavigationParameters().doorParameters.at(color).avoidDoor)
+        {
+          return color;
+        }
+      }
+
+      return std::nullopt;
+    }
+
+    std::optional<DoorColor> PressurePlateToActivate(const PlayerMap& map)
+    {
+      for(auto color: DoorColors)
+      {
+        auto doorData = map.DoorData().at(color);
+        if(
+          !doorData.doorPosition.empty() && doorData.pressurePlatePosition
+          && map.NavigationParameters().doorParameters.at(color).avoidDoor)
+        {
+          return color;
+        }
+      }
+
+      return std::nullopt;
+    }
+
+    bool ExitIsReachable(
+      TaskPool& taskPool, const PlayerMap& map, const PlayerStateArray& players, SearchStats::Stats* searchStats)
+    {
+      if(!map.Exit())
+        return false;
+
+      Offset exit = *map.Exit();
+
+      auto reachable = ParallelTransform(
+        taskPool,
+        players,
+        [&](const Bot::PlayerState& state)
+        {
+          if(!state.active)
+            return true;
+
+          auto weights = WeightMap(state.playerId, map, map.enemies, map.NavigationParameters(), exit);
+          auto isExit = [&](Offset p) { return p == exit; };
+          return !ReversedPath(weights, state.position, isExit, {searchStats, "ExitIsReachable"}).empty();
+        });
+
+      return std::ranges::all_of(reachable, std::identity{});
+    }
   } // namespace
 
+  Assessment Assess(
+    TaskPool& taskPool,
+    const PlayerMap& map,
+    const DungeonMap& dungeonMap,
+    const PlayerStateArray& players,
+    SearchStats::Stats* searchStats)
+  {
+    Assessment assessment;
+    assessment.doorToOpen = DoorToOpen(map);
+    assessment.pressurePlateToActivate = PressurePlateToActivate(map);
+    assessment.bouldersToMove = map.uncheckedBoulders;
+    std::tie(assessment.exitIsReachable, assessment.originalEnemyLocations) = ParallelInvoke(
+      taskPool,
+      [&] { return ExitIsReachable(taskPool, map, players, searchStats); },
+      [&] { return OriginalEnemyLocations(dungeonMap); });
+    return assessment;
+  }
 
-  Game::Game(const Swoq::GameConnection& gameConnection, std::unique_ptr<Swoq::Game> game, std::optional<int> expectedLevel)
-    : m_gameConnection(gameConnection)
+  Game::Game(std::unique_ptr<Swoq::Game> game, std::optional<int> expectedLevel, const Options& options)
+    : m_options(WithTaskPool(options))
     , m_seed(game->seed())
     , m_level(0)
     , m_mapSize(game->map_width(), game->map_height())
     , m_dungeonMap(DungeonMap::Create(m_mapSize))
     , m_playerMap(std::make_shared<PlayerMap>(m_mapSize))
-    , m_player(*this, std::move(game), m_dungeonMap, m_playerMap)
+    , m_player(*this, std::move(game), m_dungeonMap, m_playerMap, m_options)
     , m_expectedLevel(expectedLevel)
   {
+    m_tracedStates.fill({PlayerState::Idle, Tracing::Clock::now()});
   }
 
   std::expected<void, std::string> Game::Run()
   {
     auto result = m_player.Run();
+    TraceStates(true);
     if(result && m_expectedLevel && *m_expectedLevel != m_level)
     {
       return std::unexpected(std::format("Expected level {}, but reached {}", *m_expectedLevel, m_level));
@@ -46,10 +147,10 @@ namespace Bot
   {
     PrintDungeonMap();
 
-    std::print("Game: Reached level {}!\n", level);
+    logger.Info("Game: Reached level {}!", level);
     m_level = level;
-    m_playerMap.Lock() = std::make_shared<PlayerMap>(m_mapSize);
-    m_dungeonMap.Lock() = DungeonMap::Create(m_mapSize);
+    m_playerMap.Set(std::make_shared<PlayerMap>(m_mapSize));
+    m_dungeonMap.Set(DungeonMap::Create(m_mapSize));
   }
 
   void Game::MapUpdated(size_t playerId)
@@ -68,7 +169,7 @@ namespace Bot
 
       if(state.hasSword && state.health >= 6 && !enemiesInSight.empty())
       {
-        std::println("Game: Player {}: Enemies in sight at {}. Attacking", playerId, enemiesInSight);
+        logger.Info("Game: Player {}: Enemies in sight at {}. Attacking", playerId, enemiesInSight);
         m_player.SetCommand(playerId, Attack);
 
         playerState = PlayerState::AttackingEnemy;
@@ -78,7 +179,7 @@ namespace Bot
                                   | std::ranges::to<OffsetSet>();
               !unknownSquares.empty())
       {
-        std::println("Game: Player {}: Enemies are obscuring {}. Luring them away", playerId, unknownSquares);
+        logger.Info("Game: Player {}: Enemies are obscuring {}. Luring them away", playerId, unknownSquares);
         m_player.SetCommand(playerId, PeekUnderEnemies(unknownSquares));
 
         playerState = PlayerState::PeekingBelowEnemy;
@@ -90,7 +191,7 @@ namespace Bot
   {
     m_leadPlayerId = OtherPlayer();
     std::swap(m_leadPlayerState, m_otherPlayerState);
-    std::println("Game: Swapped players. New lead player is {}", m_leadPlayerId);
+    logger.Info("Game: Swapped players. New lead player is {}", m_leadPlayerId);
   }
 
   void Game::CheckPlayerPresence()
@@ -101,13 +202,13 @@ namespace Bot
 
     if(state[leadPlayer].active != (m_leadPlayerState != PlayerState::Inactive))
     {
-      std::println(
+      logger.Info(
         "Game: Lead player {} changed active state from {} to {}", leadPlayer, m_leadPlayerState, state[leadPlayer].active);
       m_leadPlayerState = state[leadPlayer].active ? PlayerState::Idle : PlayerState::Inactive;
     }
     if(state[otherPlayer].active != (m_otherPlayerState != PlayerState::Inactive))
     {
-      std::println(
+      logger.Info(
         "Game: Other player {} changed active state from {} to {}", otherPlayer, m_otherPlayerState, state[otherPlayer].active);
       m_otherPlayerState = state[otherPlayer].active ? PlayerState::Idle : PlayerState::Inactive;
     }
@@ -118,26 +219,13 @@ namespace Bot
     }
   }
 
-  OffsetSet Game::OriginalEnemyLocations()
-  {
-    auto map = m_dungeonMap.Get();
-    OffsetSet enemyLocations;
-    for(const auto offset: OffsetsInRectangle(map->Size()))
-    {
-      if((*map)[offset] == Tile::TILE_ENEMY)
-      {
-        enemyLocations.insert(offset);
-      }
-    }
-    return enemyLocations;
-  }
-
   void Game::MapUpdated()
   {
     CheckPlayerPresence();
-    std::println("Game: Player updated the map while doing {}, {}", m_leadPlayerState, m_otherPlayerState);
+    logger.Debug("Game: Player updated the map while doing {}, {}", m_leadPlayerState, m_otherPlayerState);
     MapUpdated(LeadPlayer());
     MapUpdated(OtherPlayer());
+    TraceStates(false);
   }
 
   void Game::PrintDungeonMap()
@@ -145,9 +233,8 @@ namespace Bot
     if constexpr(Debugging::PrintDungeonMaps)
     {
       auto characterMap = m_dungeonMap.Get()->Vector2d::Map([](Tile t) { return CharFromTile(t); });
-      std::println("Dungeon map:");
+      logger.Info("Dungeon map:");
       Print(characterMap);
-      std::println();
     }
   }
 
@@ -156,16 +243,17 @@ namespace Bot
     CheckPlayerPresence();
     if(!IsAvailable(playerId))
     {
-      std::println("Game: Player {} is inactive, ignoring finished callback", playerId);
+      logger.Info("Game: Player {} is inactive, ignoring finished callback", playerId);
+      TraceStates(false);
       return;
     }
 
     PlayerState& playerState = GetPlayerState(playerId);
-    std::println("Game: Player {} finished task {}", playerId, playerState);
+    logger.Info("Game: Player {} finished task {}", playerId, playerState);
 
     if(playerId == LeadPlayer() && playerState != PlayerState::Exploring && m_otherPlayerState == PlayerState::Idle)
     {
-      std::println("Game: Player {} resumes exploring", OtherPlayer());
+      logger.Info("Game: Player {} resumes exploring", OtherPlayer());
       m_player.SetCommand(OtherPlayer(), Explore);
       m_otherPlayerState = PlayerState::Exploring;
     }
@@ -173,14 +261,11 @@ namespace Bot
     if(playerId == LeadPlayer())
     {
       auto map = m_playerMap.Get();
-      std::optional<DoorColor> doorToOpen = DoorToOpen(map, playerId);
-      std::optional<DoorColor> pressurePlateToActivate = PressurePlateToActivate(map, playerId);
-      OffsetSet bouldersToMove = BouldersToMove(map, playerId);
-      bool exitIsReachable = ExitIsReachable(*map);
-      OffsetSet originalEnemyLocations = OriginalEnemyLocations();
+      auto [doorToOpen, pressurePlateToActivate, bouldersToMove, exitIsReachable, originalEnemyLocations] =
+        Assess(*m_options.taskPool, *map, *m_dungeonMap.Get(), m_player.State(), m_player.SearchStatistics());
       size_t enemiesAlive = originalEnemyLocations.size() - map->enemies.killed;
 
-      std::println(
+      logger.Info(
         "Game: Player {}: Playerstate: {}, exit: {} (reachable: {}), door to open: {}, pressureplate to activate: {}, boulders to check: {}, enemies alive: {}",
         playerId,
         playerState,
@@ -200,7 +285,7 @@ namespace Bot
         if(!bouldersToMove.empty())
         {
           auto destination = ClosestUncheckedBoulder(*map, playerId);
-          std::println("Game: Player {}: Planning move boulder at {}", playerId, destination);
+          logger.Info("Game: Player {}: Planning move boulder at {}", playerId, destination);
           Commands commands;
           commands.emplace(FetchBoulder(destination));
           commands.emplace(DropBoulder);
@@ -218,7 +303,7 @@ namespace Bot
       {
         if(playerState != PlayerState::Exploring)
         {
-          std::println("Game: Player {}: Resume exploration", playerId);
+          logger.Info("Game: Player {}: Resume exploration", playerId);
           m_player.SetCommand(playerId, Explore);
           playerState = PlayerState::Exploring;
         }
@@ -226,7 +311,7 @@ namespace Bot
         {
           if(!bouldersToMove.empty())
           {
-            std::println("Game: Player {}: Reconsidering unchecked boulders", playerId);
+            logger.Info("Game: Player {}: Reconsidering unchecked boulders", playerId);
             m_player.SetCommand(playerId, ReconsiderUncheckedBoulders);
 
             playerState = PlayerState::ReconsideringUncheckedBoulders;
@@ -234,7 +319,7 @@ namespace Bot
           else if(doorToOpen)
           {
             auto doorData = map->DoorData().at(*doorToOpen);
-            std::println(
+            logger.Info(
               "Game: Player {}: Planning to open {} door. Key is at {}, door is at {}",
               playerId,
               *doorToOpen,
@@ -254,7 +339,7 @@ namespace Bot
             auto boulder = ClosestUnusedBoulder(*map, pressurePlatePosition, playerId);
             if(boulder)
             {
-              std::println(
+              logger.Info(
                 "Game: Player {}: Planning to move boulder at {} to {} pressureplate at {}",
                 playerId,
                 *boulder,
@@ -269,7 +354,7 @@ namespace Bot
             }
             else
             {
-              std::println(
+              logger.Info(
                 "Game: Player {}: No boulder found to put on {} pressureplate at {}. Going there myself",
                 playerId,
                 *pressurePlateToActivate,
@@ -283,7 +368,7 @@ namespace Bot
           }
           else if(map->Exit() && exitIsReachable)
           {
-            std::println("Game: Going to the exit");
+            logger.Info("Game: Going to the exit");
             auto stateArray = m_player.State();
             if(!stateArray[LeadPlayer()].active)
             {
@@ -303,14 +388,14 @@ namespace Bot
           }
           else if(enemiesAlive > 0)
           {
-            std::println("Game: Player {}: {} enemies still alive. Hunting them down", playerId, enemiesAlive);
+            logger.Info("Game: Player {}: {} enemies still alive. Hunting them down", playerId, enemiesAlive);
             m_player.SetCommand(playerId, HuntEnemies(originalEnemyLocations));
 
             playerState = PlayerState::HuntingEnemies;
           }
           else
           {
-            std::println("Game: Terminating player {}", playerId);
+            logger.Info("Game: Terminating player {}", playerId);
             m_player.SetCommand(playerId, Terminate);
             playerState = PlayerState::Terminating;
           }
@@ -319,48 +404,36 @@ namespace Bot
     }
     else
     {
-      std::println("Game: Player {}: Waiting for other to make progress", playerId);
+      logger.Info("Game: Player {}: Waiting for other to make progress", playerId);
       m_player.SetCommand(playerId, Wait);
       playerState = PlayerState::Idle;
     }
+    TraceStates(false);
   }
 
-  size_t Game::LeadPlayer() const { return m_leadPlayerId; }
-  size_t Game::OtherPlayer() const { return 1 - m_leadPlayerId; }
-  Game::PlayerState& Game::GetPlayerState(size_t id) { return id == LeadPlayer() ? m_leadPlayerState : m_otherPlayerState; }
-  bool Game::IsAvailable(size_t playerId) { return m_player.State()[playerId].active; }
-
-  std::optional<DoorColor> Game::DoorToOpen(const std::shared_ptr<const PlayerMap>& map, int)
+  void Game::TraceStates(bool gameOver)
   {
-    for(auto color: DoorColors)
-    {
-      auto doorData = map->DoorData().at(color);
-      if(!doorData.doorPosition.empty() && doorData.keyPosition && map->NavigationParameters().doorParameters.at(color).avoidDoor)
-      {
-        return color;
-      }
-    }
-
-    return std::nullopt;
-  }
+    auto* trace = m_player.Trace();
+    if(!trace)
+      return;
 
-  std::optional<DoorColor> Game::PressurePlateToActivate(const std::shared_ptr<const PlayerMap>& map, int)
-  {
-    for(auto color: DoorColors)
+    const auto now = Tracing::Clock::now();
+    for(size_t playerId: {0uz, 1uz})
     {
-      auto doorData = map->DoorData().at(color);
-      if(
-        !doorData.doorPosition.empty() && doorData.pressurePlatePosition
-        && map->NavigationParameters().doorParameters.at(color).avoidDoor)
-      {
-        return color;
-      }
-    }
+      auto& traced = m_tracedStates[playerId];
+      const auto state = GetPlayerState(playerId);
+      if(state == traced.state && !gameOver)
+        continue;
 
-    return std::nullopt;
+      trace->Complete(Tracing::StateTrack(playerId), std::format("{}", traced.state), traced.start, now);
+      traced = {state, now};
+    }
   }
 
-  OffsetSet Game::BouldersToMove(const std::shared_ptr<const PlayerMap>& map, int) { return map->uncheckedBoulders; }
+  size_t Game::LeadPlayer() const { return m_leadPlayerId; }
+  size_t Game::OtherPlayer() const { return 1 - m_leadPlayerId; }
+  Game::PlayerState& Game::GetPlayerState(size_t id) { return id == LeadPlayer() ? m_leadPlayerState : m_otherPlayerState; }
+  bool Game::IsAvailable(size_t playerId) { return m_player.State()[playerId].active; }
 
   Offset Game::ClosestUncheckedBoulder(const PlayerMap& map, size_t id)
   {
@@ -369,7 +442,8 @@ namespace Bot
 
     auto destinationPredicate = [&](Offset p) { return map.uncheckedBoulders.contains(p); };
     auto weights = WeightMap(id, map, map.enemies, map.NavigationParameters(), destinationPredicate);
-    auto [dist, destination] = DistanceMap(weights, state.position, destinationPredicate);
+    auto [dist, destination] =
+      DistanceMap(weights, state.position, destinationPredicate, {m_player.SearchStatistics(), "ClosestUncheckedBoulder"});
 
     assert(destination);
 
@@ -392,31 +466,10 @@ namespace Bot
     auto destination = [&](Offset p) { return unusedBoulders.contains(p); };
 
     auto weights = WeightMap(id, map, map.enemies, navigationParameters, destination);
-    auto [dist, boulderPosition] = DistanceMap(weights, currentLocation, destination);
+    auto [dist, boulderPosition] =
+      DistanceMap(weights, currentLocation, destination, {m_player.SearchStatistics(), "ClosestUnusedBoulder"});
 
     return boulderPosition;
   }
 
-  bool Game::ExitIsReachable(const PlayerMap& map)
-  {
-    if(!map.Exit())
-      return false;
-
-    auto stateArray = m_player.State();
-    bool reachable = true;
-    Offset exit = *map.Exit();
-
-    for(const auto& state: stateArray)
-    {
-      if(state.active)
-      {
-        auto weights = WeightMap(state.playerId, map, map.enemies, map.NavigationParameters(), exit);
-        auto path = ReversedPath(weights, state.position, [&](Offset p) { return p == exit; });
-        reachable = reachable && !path.empty();
-      }
-    }
-
-    return reachable;
-  }
-
 } // namespace Bot
\ No newline at end of file
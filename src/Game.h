@@ -1,16 +1,36 @@
 #pragma once
 
+#include <array>
 #include <expected>
 
+#include "AtomicSnapshot.h"
 #include "DungeonMap.h"
 #include "GameCallbacks.h"
+#include "Options.h"
 #include "Player.h"
 #include "PlayerMap.h"
 #include "Swoq.hpp"
-#include "ThreadSafe.h"
+#include "Tracing.h"
 
 namespace Bot
 {
+  // What Game::Finished bases the next plan on
+  struct Assessment
+  {
+    std::optional<DoorColor> doorToOpen;
+    std::optional<DoorColor> pressurePlateToActivate;
+    OffsetSet bouldersToMove;
+    bool exitIsReachable = false;
+    OffsetSet originalEnemyLocations;
+  };
+
+  Assessment Assess(
+    TaskPool& taskPool,
+    const PlayerMap& map,
+    const DungeonMap& dungeonMap,
+    const PlayerStateArray& players,
+    SearchStats::Stats* searchStats = nullptr);
+
   class Game : private GameCallbacks
   {
   public:
@@ -30,9 +50,10 @@ namespace Bot
       HuntingEnemies,
     };
 
-    Game(const Swoq::GameConnection& gameConnection, std::unique_ptr<Swoq::Game> game, std::optional<int> expectedLevel);
+    Game(std::unique_ptr<Swoq::Game> game, std::optional<int> expectedLevel, const Options& options = {});
 
     std::expected<void, std::string> Run();
+    int Level() const { return m_level; }
 
   private:
     void LevelReached(int level) override;
@@ -47,25 +68,30 @@ namespace Bot
     void MapUpdated(size_t playerId);
     void SwapPlayers();
     void CheckPlayerPresence();
-    OffsetSet OriginalEnemyLocations();
+    // Adds the states that ended to the trace. At the end of the game, all of them have.
+    void TraceStates(bool gameOver);
 
-    std::optional<DoorColor> DoorToOpen(const std::shared_ptr<const PlayerMap>& map, int id);
-    std::optional<DoorColor> PressurePlateToActivate(const std::shared_ptr<const PlayerMap>& map, int id);
-    OffsetSet BouldersToMove(const std::shared_ptr<const PlayerMap>& map, int id);
     Offset ClosestUncheckedBoulder(const PlayerMap& map, size_t id);
     std::optional<Offset> ClosestUnusedBoulder(const PlayerMap& map, Offset currentLocation, size_t id);
-    bool ExitIsReachable(const PlayerMap& map);
 
-    Swoq::GameConnection m_gameConnection;
+    Options m_options;
     int m_seed;
     int m_level;
     Offset m_mapSize;
-    ThreadSafe<DungeonMap::Ptr> m_dungeonMap;
-    ThreadSafe<PlayerMap::Ptr> m_playerMap;
+    AtomicSnapshot<DungeonMap> m_dungeonMap;
+    AtomicSnapshot<PlayerMap> m_playerMap;
     Player m_player;
     size_t m_leadPlayerId = 0;
     PlayerState m_leadPlayerState = PlayerState::Idle;
     PlayerState m_otherPlayerState = PlayerState::Idle;
+
+    // Per player id, the state and when it began
+    struct TracedState
+    {
+      PlayerState state;
+      Tracing::Clock::time_point start;
+    };
+    std::array<TracedState, 2> m_tracedStates;
     std::optional<int> m_expectedLevel;
   };
 
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdlib>
+#include <type_traits>
+
+#include "Offset.h"
+
+namespace Bot
+{
+  // Within visibility, and no opaque tile on the Bresenham line in between. The local server and the forward model
+  // both use this, so they agree on what an enemy can see.
+  template <typename IsOpaque>
+    requires std::is_invocable_r_v<bool, IsOpaque, Offset>
+  bool CanSee(Offset from, Offset to, int visibility, IsOpaque&& isOpaque)
+  {
+    if(std::abs(to.x - from.x) > visibility || std::abs(to.y - from.y) > visibility)
+      return false;
+
+    const int dx = std::abs(to.x - from.x);
+    const int dy = -std::abs(to.y - from.y);
+    const int sx = from.x < to.x ? 1 : -1;
+    const int sy = from.y < to.y ? 1 : -1;
+    int error = dx + dy;
+    Offset current = from;
+    while(current != to)
+    {
+      if(current != from && isOpaque(current))
+        return false;
+
+      const int doubled = 2 * error;
+      if(doubled >= dy)
+      {
+        error += dy;
+        current.x += sx;
+      }
+      if(doubled <= dx)
+      {
+        error += dx;
+        current.y += sy;
+      }
+    }
+    return true;
+  }
+
+} // namespace Bot
@@ -0,0 +1,271 @@
+#include "Logging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "SpscRing.h"
+
+namespace Bot::Log
+{
+  namespace
+  {
+    using Ring = SpscRing<Detail::Entry, 512>;
+
+    // An idle backend looks for new messages this often
+    constexpr std::chrono::milliseconds PollInterval(1);
+
+    template <std::size_t... Index>
+    constexpr std::array<std::atomic<Level>, CategoryCount> DefaultLevels(std::index_sequence<Index...>)
+    {
+      return {((void)Index, DefaultLevel)...};
+    }
+
+    std::optional<Level> ParseLevel(std::string_view name)
+    {
+      const auto found = std::ranges::find(LevelNames, name);
+      if(found == LevelNames.end())
+        return std::nullopt;
+      return static_cast<Level>(found - LevelNames.begin());
+    }
+
+    std::optional<Category> ParseCategory(std::string_view name)
+    {
+      const auto found = std::ranges::find(CategoryNames, name);
+      if(found == CategoryNames.end())
+        return std::nullopt;
+      return static_cast<Category>(found - CategoryNames.begin());
+    }
+
+    class Backend
+    {
+    public:
+      static Backend& Instance()
+      {
+        static Backend backend;
+        return backend;
+      }
+
+      ~Backend()
+      {
+        m_thread.request_stop();
+        m_thread.join();
+        Drain(true);
+      }
+
+      Backend(const Backend&) = delete;
+      Backend& operator=(const Backend&) = delete;
+
+      std::shared_ptr<Ring> Register()
+      {
+        auto ring = std::make_shared<Ring>();
+        std::lock_guard lock(m_queuesMutex);
+        m_rings.push_back(ring);
+        return ring;
+      }
+
+      std::uint64_t NextSequence() { return m_published.fetch_add(1, std::memory_order_relaxed); }
+
+      // For entries that don't fit in the ring of their thread, so the logging thread never waits for the backend
+      void Overflow(Detail::Entry& entry)
+      {
+        std::lock_guard lock(m_queuesMutex);
+        m_overflow.push_back(entry);
+      }
+
+      void Flush() const
+      {
+        // The backend can't wait for itself, e.g. when a sink throws
+        if(std::this_thread::get_id() == m_thread.get_id())
+          return;
+        const auto published = m_published.load(std::memory_order_relaxed);
+        while(m_written.load(std::memory_order_acquire) < published)
+        {
+          std::this_thread::sleep_for(PollInterval);
+        }
+      }
+
+      void SetSink(Sink sink)
+      {
+        std::lock_guard lock(m_mutex);
+        m_sink = std::move(sink);
+      }
+
+    private:
+      Backend()
+        : m_thread(
+            [this](const std::stop_token& stopToken)
+            {
+              while(!stopToken.stop_requested())
+              {
+                if(!Drain(false))
+                  std::this_thread::sleep_for(PollInterval);
+              }
+            })
+      {
+      }
+
+      // Prints whatever the rings hold, returns whether there was anything. A thread that took a sequence number
+      // may not have pushed its entry yet, so the entries after it are held back until it has. The last drain prints
+      // everything.
+      bool Drain(bool last)
+      {
+        std::lock_guard lock(m_mutex);
+
+        {
+          std::lock_guard queuesLock(m_queuesMutex);
+          for(const auto& ring: m_rings)
+          {
+            while(auto entry = ring->TryPop())
+            {
+              m_pending.push_back(*entry);
+            }
+          }
+          std::ranges::move(m_overflow, std::back_inserter(m_pending));
+          m_overflow.clear();
+          // Rings of threads that are gone
+          std::erase_if(m_rings, [](const auto& ring) { return ring.use_count() == 1 && ring->Empty(); });
+        }
+
+        std::ranges::sort(m_pending, {}, &Detail::Entry::sequence);
+        std::size_t ready = 0;
+        while(ready < m_pending.size() && (last || m_pending[ready].sequence == m_nextSequence + ready))
+        {
+          ++ready;
+        }
+        if(ready == 0)
+          return false;
+
+        for(const auto& entry: std::span(m_pending).first(ready))
+        {
+          m_line.clear();
+          if(entry.game)
+            std::format_to(std::back_inserter(m_line), "[game {}] ", *entry.game);
+          if(entry.level >= Level::Warning)
+            m_line += entry.level == Level::Warning ? "Warning: " : "Error: ";
+          try
+          {
+            entry.formatFunction(entry, m_line);
+          }
+          catch(const std::format_error& error)
+          {
+            m_line += std::format("<{}: {}>", entry.format, error.what());
+          }
+
+          if(m_sink)
+          {
+            m_sink(m_line);
+          }
+          else
+          {
+            m_line += '\n';
+            std::fwrite(m_line.data(), 1, m_line.size(), stdout);
+          }
+        }
+        if(!m_sink)
+          std::fflush(stdout);
+
+        m_pending.erase(m_pending.begin(), m_pending.begin() + static_cast<std::ptrdiff_t>(ready));
+        m_nextSequence += ready;
+        m_written.fetch_add(ready, std::memory_order_release);
+        return true;
+      }
+
+      // Guards the sink and what is being printed
+      std::mutex m_mutex;
+      Sink m_sink;
+      // Sorted by sequence when printing
+      std::vector<Detail::Entry> m_pending;
+      std::uint64_t m_nextSequence = 0;
+      std::string m_line;
+      // Guards the list of rings and the overflow. Producers only take it when they log for the first time or their ring
+      // is full, and the backend doesn't hold it while printing.
+      std::mutex m_queuesMutex;
+      std::vector<std::shared_ptr<Ring>> m_rings;
+      std::vector<Detail::Entry> m_overflow;
+      std::atomic<std::uint64_t> m_published = 0;
+      std::atomic<std::uint64_t> m_written = 0;
+      std::jthread m_thread;
+    };
+
+    Ring& ThreadRing()
+    {
+      // Keeps the ring alive until the backend has emptied it
+      thread_local const std::shared_ptr<Ring> ring = Backend::Instance().Register();
+      return *ring;
+    }
+  } // namespace
+
+  std::array<std::atomic<Level>, CategoryCount> Detail::levels = DefaultLevels(std::make_index_sequence<CategoryCount>{});
+  thread_local std::optional<std::size_t> Detail::game;
+
+  void Detail::Publish(Entry& entry)
+  {
+    auto& ring = ThreadRing();
+    auto& backend = Backend::Instance();
+    entry.sequence = backend.NextSequence();
+    // When the backend can not keep up, the entry takes the slow path instead of making the logging thread wait
+    if(!ring.TryPush(std::move(entry)))
+      backend.Overflow(entry);
+  }
+
+  std::expected<void, std::string> Configure(std::string_view spec)
+  {
+    for(const auto part: spec | std::views::split(','))
+    {
+      const std::string_view item(part.begin(), part.end());
+      const auto equals = item.find('=');
+      const auto levelName = equals == std::string_view::npos ? item : item.substr(equals + 1);
+      const auto level = ParseLevel(levelName);
+      if(!level)
+        return std::unexpected(std::format("Unknown log level '{}'", levelName));
+
+      if(equals == std::string_view::npos)
+      {
+        for(std::size_t category = 0; category < CategoryCount; ++category)
+        {
+          SetLevel(static_cast<Category>(category), *level);
+        }
+        continue;
+      }
+
+      const auto category = ParseCategory(item.substr(0, equals));
+      if(!category)
+        return std::unexpected(std::format("Unknown log category '{}'", item.substr(0, equals)));
+      SetLevel(*category, *level);
+    }
+    return {};
+  }
+
+  void SetLevel(Category category, Level level)
+  {
+    Detail::levels[static_cast<std::size_t>(category)].store(level, std::memory_order_relaxed);
+  }
+
+  Level GetLevel(Category category) { return Detail::levels[static_cast<std::size_t>(category)].load(std::memory_order_relaxed); }
+
+  void Flush() { Backend::Instance().Flush(); }
+
+  void FlushOnTerminate()
+  {
+    static std::terminate_handler previous = nullptr;
+    previous = std::set_terminate(
+      []
+      {
+        Flush();
+        if(previous)
+          previous();
+        std::abort();
+      });
+  }
+
+  void SetSink(Sink sink) { Backend::Instance().SetSink(std::move(sink)); }
+
+} // namespace Bot::Log
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <format>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Logging by level and category. Logging a message only copies its arguments into a ring owned by the calling thread,
+// or into a shared overflow list when that ring is full. A background thread formats the messages and prints them, in
+// the order they were logged.
+// Messages that are not printed yet are lost when the process dies without returning from main or calling exit, e.g.
+// on a signal. Call Flush before exiting any other way.
+namespace Bot::Log
+{
+  enum class Level : std::uint8_t
+  {
+    Trace,
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off,
+  };
+
+  enum class Category : std::uint8_t
+  {
+    Game,
+    Player,
+    Map,
+    Path,
+    Network,
+    Runner,
+    Profiling,
+    Config,
+  };
+
+  inline constexpr std::array LevelNames{"trace", "debug", "info", "warning", "error", "off"};
+  inline constexpr std::array CategoryNames{"game", "player", "map", "path", "network", "runner", "profiling", "config"};
+  constexpr std::size_t CategoryCount = CategoryNames.size();
+
+  // Messages below this level are compiled out, whatever the runtime configuration
+  constexpr Level CompiledLevel = Level::Debug;
+  // The level of every category until configured otherwise
+  constexpr Level DefaultLevel = Level::Info;
+
+  // A level for all categories, optionally followed by levels for some of them, e.g. "info,player=debug,map=off"
+  std::expected<void, std::string> Configure(std::string_view spec);
+  void SetLevel(Category category, Level level);
+  Level GetLevel(Category category);
+
+  // Waits until the messages logged so far are printed
+  void Flush();
+  // Flushes before std::terminate aborts, so an uncaught exception doesn't lose the messages leading up to it
+  void FlushOnTerminate();
+
+  // Receives every formatted message, without a trailing newline. Prints to stdout when empty.
+  using Sink = std::function<void(std::string_view)>;
+  void SetSink(Sink sink);
+
+  namespace Detail
+  {
+    extern std::array<std::atomic<Level>, CategoryCount> levels;
+    extern thread_local std::optional<std::size_t> game;
+
+    inline bool IsEnabled(Category category, Level level)
+    {
+      return level >= levels[static_cast<std::size_t>(category)].load(std::memory_order_relaxed);
+    }
+
+    // A message that is not formatted yet. The arguments live in storage if they are small and trivially copyable,
+    // otherwise storage holds a pointer to a heap copy. Either way the entry itself can be copied byte by byte.
+    struct Entry
+    {
+      // Formats the message into out, and frees the arguments
+      using FormatFunction = void (*)(const Entry& entry, std::string& out);
+      static constexpr std::size_t StorageSize = 96;
+
+      std::uint64_t sequence = 0;
+      std::optional<std::size_t> game;
+      Level level = Level::Info;
+      Category category = Category::Game;
+      std::string_view format;
+      FormatFunction formatFunction = nullptr;
+      alignas(std::max_align_t) std::array<std::byte, StorageSize> storage{};
+    };
+
+    // Strings are copied, the caller's buffer may be gone by the time the message is formatted
+    template <typename T>
+    using Stored = std::conditional_t<
+      std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>
+        || std::is_same_v<std::decay_t<T>, std::string_view>,
+      std::string,
+      std::decay_t<T>>;
+
+    // Offsets of the arguments in Entry::storage, followed by the total size
+    template <typename... Args>
+    constexpr std::array<std::size_t, sizeof...(Args) + 1> InlineOffsets()
+    {
+      std::array<std::size_t, sizeof...(Args) + 1> offsets{};
+      std::size_t offset = 0;
+      std::size_t index = 0;
+      ((offset = (offset + alignof(Args) - 1) / alignof(Args) * alignof(Args), offsets[index++] = offset, offset += sizeof(Args)),
+       ...);
+      offsets[index] = offset;
+      return offsets;
+    }
+
+    template <typename... Args>
+    constexpr bool FitsInline = (std::is_trivially_copyable_v<Args> && ...)
+                             && InlineOffsets<Args...>().back() <= Entry::StorageSize
+                             && ((alignof(Args) <= alignof(std::max_align_t)) && ...);
+
+    template <typename T>
+    const T& InlineArgument(const Entry& entry, std::size_t offset)
+    {
+      return *std::launder(reinterpret_cast<const T*>(entry.storage.data() + offset));
+    }
+
+    template <typename... Args, std::size_t... Index>
+    void FormatInline(const Entry& entry, std::string& out, std::index_sequence<Index...>)
+    {
+      [[maybe_unused]] constexpr auto offsets = InlineOffsets<Args...>();
+      std::vformat_to(
+        std::back_inserter(out), entry.format, std::make_format_args(InlineArgument<Args>(entry, offsets[Index])...));
+    }
+
+    template <typename... Args>
+    void Format(const Entry& entry, std::string& out)
+    {
+      if constexpr(FitsInline<Args...>)
+      {
+        FormatInline<Args...>(entry, out, std::index_sequence_for<Args...>{});
+      }
+      else
+      {
+        std::tuple<Args...>* copy = nullptr;
+        std::memcpy(&copy, entry.storage.data(), sizeof(copy));
+        const std::unique_ptr<std::tuple<Args...>> arguments(copy);
+        std::apply(
+          [&](auto&... values) { std::vformat_to(std::back_inserter(out), entry.format, std::make_format_args(values...)); },
+          *arguments);
+      }
+    }
+
+    // Assigns the sequence number and hands the entry to the ring of this thread
+    void Publish(Entry& entry);
+
+    template <typename... Args, typename... Values>
+    void Push(Category category, Level level, std::string_view format, Values&&... values)
+    {
+      Entry entry;
+      entry.game = game;
+      entry.level = level;
+      entry.category = category;
+      entry.format = format;
+      entry.formatFunction = &Format<Args...>;
+      if constexpr(FitsInline<Args...>)
+      {
+        [[maybe_unused]] constexpr auto offsets = InlineOffsets<Args...>();
+        [&]<std::size_t... Index>(std::index_sequence<Index...>)
+        {
+          (::new(entry.storage.data() + offsets[Index]) Args(std::forward<Values>(values)), ...);
+        }(std::index_sequence_for<Args...>{});
+      }
+      else
+      {
+        auto* copy = new std::tuple<Args...>(std::forward<Values>(values)...);
+        std::memcpy(entry.storage.data(), &copy, sizeof(copy));
+      }
+      Publish(entry);
+    }
+  } // namespace Detail
+
+  // Lines logged by this thread while it is alive start with "[game <index>] ", so concurrent games can be told apart.
+  // Tasks submitted to a TaskPool take the game of the submitting thread along.
+  class GameScope
+  {
+  public:
+    explicit GameScope(std::optional<std::size_t> game)
+      : m_previous(std::exchange(Detail::game, game))
+    {
+    }
+    ~GameScope() { Detail::game = m_previous; }
+    GameScope(const GameScope&) = delete;
+    GameScope& operator=(const GameScope&) = delete;
+
+  private:
+    std::optional<std::size_t> m_previous;
+  };
+
+  inline std::optional<std::size_t> CurrentGame() { return Detail::game; }
+
+  // Use one per file, e.g. constexpr Log::Logger<Log::Category::Game> logger;
+  template <Category C>
+  class Logger
+  {
+  public:
+    template <typename... Args>
+    void Trace(std::format_string<Args...> format, Args&&... args) const
+    {
+      Write<Level::Trace>(format, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void Debug(std::format_string<Args...> format, Args&&... args) const
+    {
+      Write<Level::Debug>(format, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void Info(std::format_string<Args...> format, Args&&... args) const
+    {
+      Write<Level::Info>(format, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void Warning(std::format_string<Args...> format, Args&&... args) const
+    {
+      Write<Level::Warning>(format, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void Error(std::format_string<Args...> format, Args&&... args) const
+    {
+      Write<Level::Error>(format, std::forward<Args>(args)...);
+    }
+
+    // For messages that are expensive to build
+    bool IsEnabled(Level level) const { return level >= CompiledLevel && Detail::IsEnabled(C, level); }
+
+  private:
+    template <Level L, typename... Args>
+    static void Write(std::format_string<Args...> format, Args&&... args)
+    {
+      if constexpr(L >= CompiledLevel)
+      {
+        if(Detail::IsEnabled(C, L))
+          Detail::Push<Detail::Stored<Args>...>(C, L, format.get(), std::forward<Args>(args)...);
+      }
+    }
+  };
+
+} // namespace Bot::Log
@@ -1,18 +1,105 @@
-#include <print>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <thread>
 
 #include "Dotenv.hpp"
 #include "Game.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include "Replay.hpp"
+#include "Runner.h"
+#include "Worker.h"
 #include "Swoq.hpp"
 #include "Vector2d.h"
 
 using namespace Swoq::Interface;
 using namespace Swoq;
 
+namespace
+{
+  constexpr Bot::Log::Logger<Bot::Log::Category::Runner> logger;
+} // namespace
+
 int main(int /*argc*/, char** /*argv*/)
 {
+  // A worker that dies on an uncaught exception still prints what it logged, so the supervisor's log shows why
+  Bot::Log::FlushOnTerminate();
+
   // Load .env file
   load_dotenv();
 
+  if(auto logLevel = get_env_str("SWOQ_LOG_LEVEL"))
+  {
+    if(auto configured = Bot::Log::Configure(*logLevel); !configured)
+    {
+      logger.Warning("SWOQ_LOG_LEVEL: {}", configured.error());
+    }
+  }
+
+  // Set by the supervisor. Its workers inherit SWOQ_METRICS_ADDR, and would all try to serve on the same address.
+  const auto workerFd = get_env_int("SWOQ_WORKER_FD");
+
+  std::unique_ptr<Bot::Metrics::Server> metricsServer;
+  if(auto metricsAddress = get_env_str("SWOQ_METRICS_ADDR"); metricsAddress && !workerFd)
+  {
+    if(auto started = Bot::Metrics::Server::Start(*metricsAddress); started)
+    {
+      metricsServer = std::move(*started);
+      logger.Info("Serving metrics on {}", *metricsAddress);
+    }
+    else
+    {
+      logger.Warning("SWOQ_METRICS_ADDR: {}", started.error());
+    }
+  }
+
+  auto level         = get_env_int("SWOQ_LEVEL");
+  auto seed          = get_env_int("SWOQ_SEED");
+  auto expectedLevel = get_env_int("SWOQ_EXPECTED_LEVEL");
+
+  Bot::Options options;
+  if(get_env_int("SWOQ_PARALLEL_PLANNING").value_or(0) != 0)
+  {
+    options.planningMode = Bot::PlanningMode::Parallel;
+  }
+  options.pipelinedAct        = get_env_int("SWOQ_PIPELINED_ACT").value_or(0) != 0;
+  options.profileFile         = get_env_str("SWOQ_PROFILE_FILE");
+  options.searchHeatmapFolder = get_env_str("SWOQ_SEARCH_HEATMAP_FOLDER");
+  options.traceFolder         = get_env_str("SWOQ_TRACE_FOLDER");
+
+  // Re-run the bot over a recorded game, no server needed
+  if(auto replayFile = get_env_str("SWOQ_REPLAY_FILE"))
+  {
+    auto replay = ReplayGame::open(*replayFile);
+    if(!replay)
+    {
+      logger.Error("Failed to open replay: {}", replay.error());
+      return -1;
+    }
+    const auto& replayGame = **replay;
+
+    const auto cpuStart  = std::clock();
+    const auto wallStart = std::chrono::steady_clock::now();
+    Bot::Game  botGame(std::move(*replay), std::nullopt, options);
+    const auto result = botGame.Run();
+    const auto wall   = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - wallStart).count();
+    const auto cpu    = 1e6 * static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    const auto ticks  = std::max(replayGame.ticks(), 1);
+
+    logger.Info(
+      "Replay: {} ticks, {} diverged, {:.1f} us CPU / {:.1f} us wall per tick",
+      replayGame.ticks(),
+      replayGame.divergences(),
+      cpu / ticks,
+      wall / ticks);
+    if(!result)
+    {
+      logger.Error("Replay stopped: {}", result.error());
+    }
+    return 0;
+  }
+
   // Create a new GameConnection instance using env variables
   auto           user_id        = require_env_str("SWOQ_USER_ID");
   auto           user_name      = require_env_str("SWOQ_USER_NAME");
@@ -20,24 +107,54 @@ int main(int /*argc*/, char** /*argv*/)
   auto           replays_folder = get_env_str("SWOQ_REPLAYS_FOLDER");
   GameConnection connection(user_id, user_name, host, replays_folder);
 
+  // Play the games handed out by the supervisor
+  if(workerFd)
+  {
+    auto served = Bot::ServeWorkItems(*workerFd, connection, expectedLevel, options);
+    if(!served)
+    {
+      logger.Error("Worker failed: {}", served.error());
+    }
+    return served ? 0 : -1;
+  }
+
+  // Play many games in this process
+  if(auto games = get_env_int("SWOQ_RUNNER_GAMES"))
+  {
+    Bot::RunnerOptions runnerOptions;
+    runnerOptions.games         = static_cast<std::size_t>(std::max(*games, 0));
+    runnerOptions.concurrency   = static_cast<std::size_t>(
+      std::max(get_env_int("SWOQ_RUNNER_CONCURRENCY").value_or(static_cast<int>(std::thread::hardware_concurrency())), 1));
+    runnerOptions.pinThreads    = get_env_int("SWOQ_RUNNER_PIN_CPUS").value_or(0) != 0;
+    runnerOptions.level         = level;
+    runnerOptions.seed          = seed;
+    runnerOptions.expectedLevel = expectedLevel;
+    runnerOptions.options       = options;
+
+    const auto start   = std::chrono::steady_clock::now();
+    auto       results = Bot::Runner(connection, runnerOptions).Run();
+    auto       summary = Bot::Summarize(
+      results, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start));
+    Bot::PrintSummary(summary);
+
+    return summary.successes == summary.games ? 0 : -1;
+  }
+
   // Start a new Game using env variables
-  auto level         = get_env_int("SWOQ_LEVEL");
-  auto seed          = get_env_int("SWOQ_SEED");
-  auto expectedLevel = get_env_int("SWOQ_EXPECTED_LEVEL");
-  auto start_result  = connection.start(level, seed);
+  auto start_result = connection.start(level, seed);
   if(!start_result)
   {
-    std::println("Failed to start game: {}", start_result.error());
+    logger.Error("Failed to start game: {}", start_result.error());
     return -1;
   }
   auto& game = (*start_result);
 
-  Bot::Game  botGame(connection, std::move(game), expectedLevel);
+  Bot::Game  botGame(std::move(game), expectedLevel, options);
   const auto result = botGame.Run();
 
   if(!result)
   {
-    std::println("Failed to run game: {}", result.error());
+    logger.Error("Failed to run game: {}", result.error());
   }
 
   return result ? 0 : -1;
@@ -4,6 +4,8 @@
 
 #include "Map.h"
 
+#include "Allocations.h"
+
 namespace Bot
 {
   std::vector<Tile> NewMapData(const Vector2d<Tile>& other, Offset newSize)
@@ -22,6 +24,7 @@ namespace Bot
 
   Vector2d<Swoq::Interface::Tile> ViewFromState(int visibility, const Swoq::Interface::PlayerState& state)
   {
+    Allocations::Scope scope(Allocations::Phase::ViewDecoding);
     int visibility_dimension = 2 * visibility + 1;
     assert(state.surroundings_size() == visibility_dimension * visibility_dimension);
     return Vector2d(
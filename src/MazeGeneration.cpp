@@ -0,0 +1,175 @@
+#include "MazeGeneration.h"
+
+#include <algorithm>
+#include <deque>
+
+namespace Bot::Generation
+{
+  bool IsOpen(const Vector2d<Tile>& tiles, Offset position)
+  {
+    return tiles.IsInRange(position) && tiles[position] != Tile::TILE_WALL;
+  }
+
+  bool IsDeadEnd(const Vector2d<Tile>& tiles, Offset position)
+  {
+    return IsOpen(tiles, position)
+           && std::ranges::count_if(Directions, [&](Offset d) { return IsOpen(tiles, position + d); }) == 1;
+  }
+
+  std::vector<Offset> OpenCells(const Vector2d<Tile>& tiles)
+  {
+    std::vector<Offset> result;
+    for(std::size_t i = 0; i < tiles.Data().size(); ++i)
+    {
+      if(tiles[i] != Tile::TILE_WALL)
+        result.push_back(tiles.ToOffset(i));
+    }
+    return result;
+  }
+
+  void CarveRoom(Vector2d<Tile>& tiles)
+  {
+    for(std::size_t i = 0; i < tiles.Data().size(); ++i)
+    {
+      const Offset position = tiles.ToOffset(i);
+      if(position.x > 0 && position.y > 0 && position.x < tiles.Width() - 1 && position.y < tiles.Height() - 1)
+        tiles[i] = Tile::TILE_EMPTY;
+    }
+  }
+
+  void CarveMaze(Vector2d<Tile>& tiles, Random& random, bool braid)
+  {
+    auto isCell = [&](Offset p)
+    { return p.x >= 1 && p.y >= 1 && p.x <= tiles.Width() - 2 && p.y <= tiles.Height() - 2 && p.x % 2 == 1 && p.y % 2 == 1; };
+
+    std::vector<Offset> stack{Offset{1, 1}};
+    tiles[stack.back()] = Tile::TILE_EMPTY;
+    while(!stack.empty())
+    {
+      const Offset current = stack.back();
+      std::vector<Offset> options;
+      for(auto direction: Directions)
+      {
+        if(isCell(current + 2 * direction) && tiles[current + 2 * direction] == Tile::TILE_WALL)
+          options.push_back(direction);
+      }
+      if(options.empty())
+      {
+        stack.pop_back();
+        continue;
+      }
+
+      const Offset direction = random.Pick(options);
+      tiles[current + direction] = Tile::TILE_EMPTY;
+      tiles[current + 2 * direction] = Tile::TILE_EMPTY;
+      stack.push_back(current + 2 * direction);
+    }
+
+    if(!braid)
+      return;
+
+    // Knocking through only opens the walls between cells, so every cell is still visited
+    for(std::size_t i = 0; i < tiles.Data().size(); ++i)
+    {
+      const Offset cell = tiles.ToOffset(i);
+      if(!isCell(cell) || !IsDeadEnd(tiles, cell) || random.Below(2) != 0)
+        continue;
+
+      std::vector<Offset> walls;
+      for(auto direction: Directions)
+      {
+        if(isCell(cell + 2 * direction) && tiles[cell + direction] == Tile::TILE_WALL)
+          walls.push_back(direction);
+      }
+      if(!walls.empty())
+        tiles[cell + random.Pick(walls)] = Tile::TILE_EMPTY;
+    }
+  }
+
+  Vector2d<int> Distances(const Vector2d<Tile>& tiles, Offset from, const std::vector<Offset>& blocked)
+  {
+    Vector2d<int> distances(tiles.Width(), tiles.Height(), -1);
+    std::deque<Offset> queue{from};
+    distances[from] = 0;
+    while(!queue.empty())
+    {
+      const Offset current = queue.front();
+      queue.pop_front();
+      for(auto direction: Directions)
+      {
+        const Offset next = current + direction;
+        if(!IsOpen(tiles, next) || distances[next] >= 0 || std::ranges::contains(blocked, next))
+          continue;
+        distances[next] = distances[current] + 1;
+        queue.push_back(next);
+      }
+    }
+    return distances;
+  }
+
+  Offset Farthest(const Vector2d<int>& distances)
+  {
+    return distances.ToOffset(static_cast<std::size_t>(std::ranges::max_element(distances.Data()) - distances.Data().begin()));
+  }
+
+  Offset StepBack(const Vector2d<int>& distances, Offset position)
+  {
+    for(auto direction: Directions)
+    {
+      const Offset previous = position + direction;
+      if(distances.IsInRange(previous) && distances[previous] >= 0 && distances[previous] == distances[position] - 1)
+        return previous;
+    }
+    return position;
+  }
+
+  std::vector<Offset> Path(const Vector2d<int>& distances, Offset to)
+  {
+    std::vector<Offset> path{to};
+    while(distances[path.back()] > 0)
+    {
+      path.push_back(StepBack(distances, path.back()));
+    }
+    std::ranges::reverse(path);
+    return path;
+  }
+
+  std::vector<Offset>
+    Region(const Vector2d<Tile>& tiles, Offset from, const std::vector<Offset>& blocked, const std::vector<Offset>& inner)
+  {
+    const auto outer = Distances(tiles, from, blocked);
+    const auto excluded = inner.empty() ? Vector2d<int>(outer.Width(), outer.Height(), -1) : Distances(tiles, from, inner);
+    std::vector<Offset> result;
+    for(std::size_t i = 0; i < outer.Data().size(); ++i)
+    {
+      if(outer[i] >= 0 && excluded[i] < 0)
+        result.push_back(outer.ToOffset(i));
+    }
+    return result;
+  }
+
+  std::vector<Offset> DoorsOnPath(const std::vector<Offset>& path, std::size_t count)
+  {
+    std::vector<Offset> result;
+    const std::size_t length = path.size();
+    if(length < count + 2)
+      return result;
+
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      result.push_back(path[std::clamp((i + 1) * length / (count + 1), i + 1, length - 2)]);
+    }
+    return result;
+  }
+
+  std::vector<Offset> KeyRegion(const Vector2d<Tile>& tiles, Offset start, const std::vector<Offset>& doors, std::size_t index)
+  {
+    const std::vector<Offset> closed(doors.begin() + static_cast<std::ptrdiff_t>(index), doors.end());
+    if(index == 0)
+      return Region(tiles, start, closed);
+
+    const std::vector<Offset> previous(doors.begin() + static_cast<std::ptrdiff_t>(index - 1), doors.end());
+    return Region(tiles, start, closed, previous);
+  }
+
+} // namespace Bot::Generation
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "Offset.h"
+#include "Swoq.pb.h"
+#include "Vector2d.h"
+
+// The pieces the level generator of the local server and the synthetic dungeon generator have in common. Both are
+// deterministic, so nothing in here may depend on the platform.
+namespace Bot::Generation
+{
+  using Swoq::Interface::Tile;
+
+  // In the order the doors are placed on the path to the exit
+  inline constexpr std::array DoorTiles{Tile::TILE_DOOR_RED, Tile::TILE_DOOR_GREEN, Tile::TILE_DOOR_BLUE};
+  inline constexpr std::array KeyTiles{Tile::TILE_KEY_RED, Tile::TILE_KEY_GREEN, Tile::TILE_KEY_BLUE};
+
+  // SplitMix64. The standard distributions are implementation defined, so they would break determinism across platforms.
+  class Random
+  {
+  public:
+    explicit Random(std::uint64_t seed)
+      : m_state(seed)
+    {
+    }
+
+    std::uint64_t Next()
+    {
+      std::uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      return z ^ (z >> 31);
+    }
+
+    std::size_t Below(std::size_t count)
+    {
+      assert(count > 0);
+      return Next() % count;
+    }
+
+    template <typename T>
+    const T& Pick(const std::vector<T>& values)
+    {
+      return values[Below(values.size())];
+    }
+
+  private:
+    std::uint64_t m_state;
+  };
+
+  // Anything but a wall is open
+  bool IsOpen(const Vector2d<Tile>& tiles, Offset position);
+  // An open cell with exactly one open neighbour
+  bool IsDeadEnd(const Vector2d<Tile>& tiles, Offset position);
+  std::vector<Offset> OpenCells(const Vector2d<Tile>& tiles);
+
+  // Everything but the border
+  void CarveRoom(Vector2d<Tile>& tiles);
+  // Recursive backtracker on the odd cells of a map that is all walls, optionally with half of the dead ends knocked
+  // through so there are loops
+  void CarveMaze(Vector2d<Tile>& tiles, Random& random, bool braid);
+
+  // Breadth first, treating walls and the blocked cells as impassable. Unreachable cells are -1.
+  Vector2d<int> Distances(const Vector2d<Tile>& tiles, Offset from, const std::vector<Offset>& blocked = {});
+  // The first of the farthest cells
+  Offset Farthest(const Vector2d<int>& distances);
+  // A neighbour one step closer to where the distances start, or the position itself when there is none
+  Offset StepBack(const Vector2d<int>& distances, Offset position);
+  // From where the distances start to the given cell, both included
+  std::vector<Offset> Path(const Vector2d<int>& distances, Offset to);
+
+  // Cells reachable from 'from' with 'blocked' closed, but not with 'inner' closed as well
+  std::vector<Offset> Region(
+    const Vector2d<Tile>& tiles,
+    Offset from,
+    const std::vector<Offset>& blocked,
+    const std::vector<Offset>& inner = {});
+
+  // Where count doors split the path in equal parts, never on its first or last cell. None when the path is too short.
+  std::vector<Offset> DoorsOnPath(const std::vector<Offset>& path, std::size_t count);
+  // Where the key of doors[index] goes when the doors have to be opened in order: in front of the first door for the
+  // first key, behind the door before it for the others
+  std::vector<Offset> KeyRegion(const Vector2d<Tile>& tiles, Offset start, const std::vector<Offset>& doors, std::size_t index);
+
+} // namespace Bot::Generation
@@ -0,0 +1,296 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Bot::Metrics
+{
+  std::atomic<bool> Detail::enabled = false;
+  std::atomic<std::uint64_t> Detail::distanceMapCalls = 0;
+
+  namespace
+  {
+    // Waiting this long for a request, or for the stop request
+    constexpr int PollMilliseconds = 200;
+
+    std::atomic<std::uint64_t> ticks = 0;
+    std::array<Histogram, 3> latencies;
+    std::array<std::atomic<std::uint64_t>, 2> mapSnapshots{};
+    std::array<std::atomic<std::uint64_t>, 2> speculativePaths{};
+
+    std::mutex levelsMutex;
+    std::map<std::string, int, std::less<>> levels;
+
+    double Seconds(std::uint64_t nanoseconds) { return static_cast<double>(nanoseconds) / 1e9; }
+
+    std::string ErrorMessage(std::string_view what) { return std::format("{}: {}", what, std::strerror(errno)); }
+
+    void Counter(std::string& out, std::string_view name, std::string_view help)
+    {
+      std::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} counter\n", name, help, name);
+    }
+
+    void Gauge(std::string& out, std::string_view name, std::string_view help)
+    {
+      std::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} gauge\n", name, help, name);
+    }
+
+    std::uint64_t Load(const std::atomic<std::uint64_t>& value) { return value.load(std::memory_order_relaxed); }
+  } // namespace
+
+  void Histogram::Record(Clock::duration duration)
+  {
+    const double seconds = std::chrono::duration<double>(duration).count();
+    const auto bucket = static_cast<std::size_t>(std::ranges::lower_bound(BucketBounds, seconds) - BucketBounds.begin());
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_sumNanoseconds.fetch_add(
+      static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), 0)),
+      std::memory_order_relaxed);
+  }
+
+  void Histogram::Write(std::string& out, std::string_view name, std::string_view labels) const
+  {
+    std::uint64_t cumulative = 0;
+    for(std::size_t bucket = 0; bucket < BucketBounds.size(); ++bucket)
+    {
+      cumulative += Load(m_buckets[bucket]);
+      std::format_to(std::back_inserter(out), "{}_bucket{{{}le=\"{}\"}} {}\n", name, labels, BucketBounds[bucket], cumulative);
+    }
+    cumulative += Load(m_buckets.back());
+    std::format_to(std::back_inserter(out), "{}_bucket{{{}le=\"+Inf\"}} {}\n", name, labels, cumulative);
+
+    const auto plainLabels = labels.empty() ? std::string() : std::format("{{{}}}", labels.substr(0, labels.size() - 1));
+    std::format_to(std::back_inserter(out), "{}_sum{} {}\n", name, plainLabels, Seconds(Load(m_sumNanoseconds)));
+    std::format_to(std::back_inserter(out), "{}_count{} {}\n", name, plainLabels, cumulative);
+  }
+
+  void CountTick()
+  {
+    if(Detail::Enabled())
+      ticks.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void Record(Latency latency, Clock::duration duration)
+  {
+    if(Detail::Enabled())
+      latencies[static_cast<std::size_t>(latency)].Record(duration);
+  }
+
+  void CountMapSnapshot(MapKind kind)
+  {
+    if(Detail::Enabled())
+      mapSnapshots[static_cast<std::size_t>(kind)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void CountSpeculativePath(bool used)
+  {
+    if(Detail::Enabled())
+      speculativePaths[used ? 0 : 1].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void SetLevel(std::string_view gameId, int level)
+  {
+    if(!Detail::Enabled())
+      return;
+
+    std::lock_guard lock(levelsMutex);
+    auto found = levels.find(gameId);
+    if(found == levels.end())
+      levels.emplace(gameId, level);
+    else
+      found->second = level;
+  }
+
+  void RemoveGame(std::string_view gameId)
+  {
+    std::lock_guard lock(levelsMutex);
+    if(auto found = levels.find(gameId); found != levels.end())
+      levels.erase(found);
+  }
+
+  std::string Render()
+  {
+    std::string out;
+
+    Counter(out, "swoq_ticks_total", "Ticks played by all games");
+    std::format_to(std::back_inserter(out), "swoq_ticks_total {}\n", Load(ticks));
+
+    out += "# HELP swoq_act_seconds Duration of the act RPC\n# TYPE swoq_act_seconds histogram\n";
+    latencies[static_cast<std::size_t>(Latency::Act)].Write(out, "swoq_act_seconds", "");
+    out += "# HELP swoq_plan_seconds Duration of planning the next action of a player\n# TYPE swoq_plan_seconds histogram\n";
+    latencies[static_cast<std::size_t>(Latency::Plan0)].Write(out, "swoq_plan_seconds", R"(player="0",)");
+    latencies[static_cast<std::size_t>(Latency::Plan1)].Write(out, "swoq_plan_seconds", R"(player="1",)");
+
+    Gauge(out, "swoq_game_level", "Current level of each running game");
+    {
+      std::lock_guard lock(levelsMutex);
+      for(const auto& [gameId, level]: levels)
+      {
+        std::format_to(std::back_inserter(out), "swoq_game_level{{game=\"{}\"}} {}\n", gameId, level);
+      }
+    }
+
+    Counter(out, "swoq_map_snapshots_total", "Map versions published");
+    std::format_to(std::back_inserter(out), "swoq_map_snapshots_total{{map=\"player\"}} {}\n", Load(mapSnapshots[0]));
+    std::format_to(std::back_inserter(out), "swoq_map_snapshots_total{{map=\"dungeon\"}} {}\n", Load(mapSnapshots[1]));
+
+    Counter(out, "swoq_distance_map_calls_total", "Path searches");
+    std::format_to(std::back_inserter(out), "swoq_distance_map_calls_total {}\n", Load(Detail::distanceMapCalls));
+
+    Counter(out, "swoq_speculative_paths_total", "Paths planned while the act was in flight, by whether the next tick used them");
+    std::format_to(std::back_inserter(out), "swoq_speculative_paths_total{{outcome=\"used\"}} {}\n", Load(speculativePaths[0]));
+    std::format_to(std::back_inserter(out), "swoq_speculative_paths_total{{outcome=\"discarded\"}} {}\n", Load(speculativePaths[1]));
+
+    return out;
+  }
+
+  std::expected<std::unique_ptr<Server>, std::string> Server::Start(std::string_view address)
+  {
+    int fd = -1;
+    std::string unixPath;
+    if(address.starts_with("unix:"))
+    {
+      unixPath = address.substr(5);
+      sockaddr_un socketAddress{};
+      socketAddress.sun_family = AF_UNIX;
+      if(unixPath.empty() || unixPath.size() >= sizeof(socketAddress.sun_path))
+        return std::unexpected(std::format("Invalid socket path '{}'", unixPath));
+      std::ranges::copy(unixPath, socketAddress.sun_path);
+
+      fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      if(fd < 0)
+        return std::unexpected(ErrorMessage("socket"));
+      unlink(unixPath.c_str());
+      if(bind(fd, reinterpret_cast<const sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0)
+      {
+        auto error = ErrorMessage(std::format("bind {}", address));
+        close(fd);
+        return std::unexpected(error);
+      }
+    }
+    else
+    {
+      const auto colon = address.rfind(':');
+      if(colon == std::string_view::npos)
+        return std::unexpected(std::format("Expected host:port or unix:path, not '{}'", address));
+
+      const auto port = address.substr(colon + 1);
+      std::uint16_t portNumber = 0;
+      if(auto [end, error] = std::from_chars(port.data(), port.data() + port.size(), portNumber);
+         error != std::errc() || end != port.data() + port.size())
+        return std::unexpected(std::format("Invalid port '{}'", port));
+
+      sockaddr_in socketAddress{};
+      socketAddress.sin_family = AF_INET;
+      socketAddress.sin_port = htons(portNumber);
+      const std::string host(address.substr(0, colon));
+      if(host.empty())
+        socketAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+      else if(inet_pton(AF_INET, host.c_str(), &socketAddress.sin_addr) != 1)
+        return std::unexpected(std::format("Invalid IPv4 address '{}'", host));
+
+      fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      if(fd < 0)
+        return std::unexpected(ErrorMessage("socket"));
+      const int reuse = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+      if(bind(fd, reinterpret_cast<const sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0)
+      {
+        auto error = ErrorMessage(std::format("bind {}", address));
+        close(fd);
+        return std::unexpected(error);
+      }
+    }
+
+    if(listen(fd, 16) != 0)
+    {
+      auto error = ErrorMessage("listen");
+      close(fd);
+      return std::unexpected(error);
+    }
+
+    Detail::enabled = true;
+    return std::unique_ptr<Server>(new Server(fd, std::move(unixPath)));
+  }
+
+  Server::Server(int socket, std::string unixPath)
+    : m_socket(socket)
+    , m_unixPath(std::move(unixPath))
+    , m_thread([this](const std::stop_token& stopToken) { Run(stopToken); })
+  {
+  }
+
+  Server::~Server()
+  {
+    m_thread.request_stop();
+    m_thread.join();
+    close(m_socket);
+    if(!m_unixPath.empty())
+      unlink(m_unixPath.c_str());
+  }
+
+  void Server::Run(const std::stop_token& stopToken)
+  {
+    while(!stopToken.stop_requested())
+    {
+      pollfd listening{.fd = m_socket, .events = POLLIN, .revents = 0};
+      if(poll(&listening, 1, PollMilliseconds) <= 0)
+        continue;
+
+      const int client = accept4(m_socket, nullptr, nullptr, SOCK_CLOEXEC);
+      if(client < 0)
+        continue;
+      Serve(client);
+      close(client);
+    }
+  }
+
+  void Server::Serve(int client)
+  {
+    // Only the request line matters. A client that sends nothing gets the metrics anyway.
+    std::array<char, 1024> request{};
+    pollfd readable{.fd = client, .events = POLLIN, .revents = 0};
+    ssize_t received = 0;
+    if(poll(&readable, 1, PollMilliseconds) > 0)
+      received = recv(client, request.data(), request.size(), 0);
+    const std::string_view requestLine(request.data(), static_cast<std::size_t>(std::max<ssize_t>(received, 0)));
+
+    std::string response;
+    if(requestLine.empty() || requestLine.starts_with("GET / ") || requestLine.starts_with("GET /metrics"))
+    {
+      const auto body = Render();
+      response = std::format(
+        "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+        body.size(),
+        body);
+    }
+    else
+    {
+      response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    }
+
+    std::string_view remaining = response;
+    while(!remaining.empty())
+    {
+      const auto sent = send(client, remaining.data(), remaining.size(), MSG_NOSIGNAL);
+      if(sent <= 0)
+        return;
+      remaining.remove_prefix(static_cast<std::size_t>(sent));
+    }
+  }
+
+} // namespace Bot::Metrics
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Live numbers for all games in the process, in the Prometheus text format. Nothing is counted until a Server is started.
+namespace Bot::Metrics
+{
+  using Clock = std::chrono::steady_clock;
+
+  // A Prometheus histogram of durations, with fixed buckets
+  class Histogram
+  {
+  public:
+    // Upper bounds, in seconds
+    static constexpr std::array BucketBounds{
+      0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+
+    void Record(Clock::duration duration);
+    // labels is empty or ends with a comma, e.g. player="0",
+    void Write(std::string& out, std::string_view name, std::string_view labels) const;
+
+  private:
+    // Not cumulative, the last one counts everything above the highest bound
+    std::array<std::atomic<std::uint64_t>, BucketBounds.size() + 1> m_buckets{};
+    std::atomic<std::uint64_t> m_sumNanoseconds = 0;
+  };
+
+  enum class Latency : std::uint8_t
+  {
+    Act,
+    Plan0,
+    Plan1,
+  };
+
+  constexpr Latency Plan(std::size_t playerId) { return playerId == 0 ? Latency::Plan0 : Latency::Plan1; }
+
+  enum class MapKind : std::uint8_t
+  {
+    Player,
+    Dungeon,
+  };
+
+  namespace Detail
+  {
+    extern std::atomic<bool> enabled;
+    extern std::atomic<std::uint64_t> distanceMapCalls;
+
+    inline bool Enabled() { return enabled.load(std::memory_order_relaxed); }
+  } // namespace Detail
+
+  void CountTick();
+  void Record(Latency latency, Clock::duration duration);
+  void CountMapSnapshot(MapKind kind);
+  void CountSpeculativePath(bool used);
+  void SetLevel(std::string_view gameId, int level);
+  void RemoveGame(std::string_view gameId);
+
+  // Called by every DistanceMap search
+  inline void CountDistanceMap()
+  {
+    if(Detail::Enabled())
+      Detail::distanceMapCalls.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // All metrics in the Prometheus text format
+  std::string Render();
+
+  // Records the time until the end of the scope
+  class ScopedLatency
+  {
+  public:
+    explicit ScopedLatency(Latency latency)
+      : m_latency(latency)
+    {
+      if(Detail::Enabled())
+        m_start = Clock::now();
+    }
+
+    ~ScopedLatency()
+    {
+      if(Detail::Enabled() && m_start != Clock::time_point{})
+        Record(m_latency, Clock::now() - m_start);
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+  private:
+    Latency m_latency;
+    Clock::time_point m_start;
+  };
+
+  // Answers every HTTP request with the metrics. Listens on ipv4:port (an empty address means all interfaces), or on a
+  // Unix socket with unix:/path. Starting a server enables counting. Requests don't change anything, so any number of
+  // scrapers can watch the same server; rates are left to them, e.g. rate(swoq_ticks_total[1m]).
+  class Server
+  {
+  public:
+    static std::expected<std::unique_ptr<Server>, std::string> Start(std::string_view address);
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+  private:
+    Server(int socket, std::string unixPath);
+
+    void Serve(int client);
+    void Run(const std::stop_token& stopToken);
+
+    int m_socket;
+    std::string m_unixPath;
+    std::jthread m_thread;
+  };
+
+} // namespace Bot::Metrics
@@ -21,7 +21,7 @@ struct Offset
   {
   }
 
-  constexpr Offset(Swoq::Interface::Position p)
+  constexpr Offset(const Swoq::Interface::Position& p)
     : x(p.x())
     , y(p.y())
   {
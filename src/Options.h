@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace Bot
+{
+  class TaskPool;
+
+  enum class PlanningMode : std::uint8_t
+  {
+    Sequential,
+    // Both players search concurrently against the same map snapshot. Map edits and Game callbacks are
+    // still applied one player at a time, in player order.
+    Parallel,
+  };
+
+  struct Options
+  {
+    PlanningMode planningMode = PlanningMode::Sequential;
+    // Plan the next tick from the predicted positions while the act request is in flight
+    bool pipelinedAct = false;
+    // May be shared between games. Game uses TaskPool::Shared() when left empty.
+    std::shared_ptr<TaskPool> taskPool;
+    // With BOT_PROFILING, the per-level phase timings are also appended here as JSON lines
+    std::optional<std::string> profileFile;
+    // With BOT_PROFILING, a heatmap of the cells expanded by path searches is written here for every level
+    std::optional<std::string> searchHeatmapFolder;
+    // A Chrome trace of every game is written here, as <game id>.json
+    std::optional<std::string> traceFolder;
+  };
+
+} // namespace Bot
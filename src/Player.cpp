@@ -1,10 +1,15 @@
 #include "Player.h"
 
-#include <print>
+#include <filesystem>
 
 #include <Dijkstra.h>
 
+#include "Allocations.h"
+#include "Logging.h"
 #include "LoggingAndDebugging.h"
+#include "Metrics.h"
+#include "SearchStats.h"
+#include "TaskPool.h"
 
 namespace Bot
 {
@@ -13,8 +18,29 @@ namespace Bot
 
   namespace
   {
+    constexpr Log::Logger<Log::Category::Player> logger;
+
     constexpr std::chrono::seconds delay(8);
 
+    // While planning in parallel, each planning thread sees its own edits on top of the shared snapshot.
+    // The edits are published after all players are done.
+    struct PlanningOverlay
+    {
+      PlayerMap::Ptr map;
+      std::vector<std::function<void(const std::shared_ptr<PlayerMap>&)>> edits;
+    };
+
+    thread_local PlanningOverlay* planningOverlay = nullptr;
+
+    // Set while planning the next tick from a predicted position, before the act response has arrived
+    struct Speculation
+    {
+      size_t playerId;
+      Offset start;
+    };
+
+    thread_local const Speculation* speculation = nullptr;
+
     std::expected<DirectedAction, std::string> ActionFromDirection(Offset direction)
     {
       if(direction == East)
@@ -57,6 +83,36 @@ namespace Bot
       return std::unexpected("Invalid direction");
     }
 
+    std::optional<Offset> PredictedPosition(const PlayerState& state)
+    {
+      if(!state.active)
+        return std::nullopt;
+
+      using enum Swoq::Interface::DirectedAction;
+      switch(state.next)
+      {
+      case DIRECTED_ACTION_MOVE_NORTH:
+        return state.position + North;
+      case DIRECTED_ACTION_MOVE_EAST:
+        return state.position + East;
+      case DIRECTED_ACTION_MOVE_SOUTH:
+        return state.position + South;
+      case DIRECTED_ACTION_MOVE_WEST:
+        return state.position + West;
+      default:
+        return state.position;
+      }
+    }
+
+    // Commands that only compute a path and step along it, so they can be replanned without side effects
+    bool IsPathCommand(const Command& command)
+    {
+      return std::holds_alternative<Explore_t>(command) || std::holds_alternative<Bot::VisitTiles>(command)
+          || std::holds_alternative<Bot::Visit>(command) || std::holds_alternative<FetchKey>(command)
+          || std::holds_alternative<Bot::OpenDoor>(command) || std::holds_alternative<Bot::FetchBoulder>(command)
+          || std::holds_alternative<Bot::PlaceBoulderOnPressurePlate>(command);
+    }
+
     constexpr bool IsUse(Swoq::Interface::DirectedAction action)
     {
       using enum Swoq::Interface::DirectedAction;
@@ -89,11 +145,11 @@ namespace Bot
 
 
   void PlayerState::Update(
-    const std::optional<Swoq::Interface::PlayerState>& state,
+    const Swoq::Interface::PlayerState* state,
     int visibility_,
-    std::optional<Vector2d<Swoq::Interface::Tile>>& view_)
+    const std::optional<Vector2d<Swoq::Interface::Tile>>& view_)
   {
-    auto newPosition = state.transform([](const auto& s) -> Offset { return s.position(); }).value_or(Offset(-1, -1));
+    auto newPosition = state ? Offset(state->position()) : Offset(-1, -1);
 
     if(state && newPosition.x >= 0 && newPosition.y >= 0)
     {
@@ -111,114 +167,137 @@ namespace Bot
       active = false;
   }
 
-  std::optional<DirectedAction> PlayerState::GetAction() { return active ? std::make_optional(next) : std::nullopt; }
+  std::optional<DirectedAction> PlayerState::GetAction() const { return active ? std::make_optional(next) : std::nullopt; }
+
+  PlayerViews::PlayerViews(const Swoq::Interface::State& state, int visibility_)
+    : visibility(visibility_)
+  {
+    states[0] = state.has_playerstate() ? &state.playerstate() : nullptr;
+    states[1] = state.has_player2state() ? &state.player2state() : nullptr;
+    for(std::size_t i = 0; i < states.size(); ++i)
+    {
+      if(states[i])
+        views[i] = ViewFromState(visibility, *states[i]);
+    }
+  }
+
+  DungeonMap::Ptr PlayerViews::Apply(const DungeonMap::Ptr& dungeonMap) const
+  {
+    auto newDungeonMap = dungeonMap;
+    for(std::size_t i = 0; i < states.size(); ++i)
+    {
+      if(states[i])
+        newDungeonMap = newDungeonMap->Update(states[i]->position(), visibility, *views[i]);
+    }
+    return newDungeonMap;
+  }
+
+  PlayerMap::Ptr PlayerViews::Apply(const PlayerMap::Ptr& map) const
+  {
+    auto newMap = map;
+    for(std::size_t i = 0; i < states.size(); ++i)
+    {
+      if(states[i])
+        newMap = newMap->Update(i, states[i]->position(), visibility, *views[i]);
+    }
+    return newMap;
+  }
+
+  void PlayerViews::Apply(PlayerStateArray& players) const
+  {
+    for(std::size_t i = 0; i < states.size(); ++i)
+    {
+      players[i].Update(states[i], visibility, views[i]);
+    }
+  }
 
   Player::Player(
     GameCallbacks& callbacks,
     std::unique_ptr<Swoq::Game> game,
-    ThreadSafe<DungeonMap::Ptr>& dungeonMap,
-    ThreadSafe<PlayerMap::Ptr>& map)
+    AtomicSnapshot<DungeonMap>& dungeonMap,
+    AtomicSnapshot<PlayerMap>& map,
+    const Options& options)
     : m_callbacks(callbacks)
     , m_game(std::move(game))
     , m_dungeonMap(dungeonMap)
     , m_playerMap(map)
+    , m_options(options)
   {
     // Show game stats
-    std::println("Game {} started", m_game->game_id());
-    std::println("- seed: {}", m_game->seed());
-    std::println("- map size: {}x{}", m_game->map_height(), m_game->map_width());
-    std::println("- visibility: {}", m_game->visibility_range());
+    logger.Info("Game {} started", m_game->game_id());
+    logger.Info("- seed: {}", m_game->seed());
+    logger.Info("- map size: {}x{}", m_game->map_height(), m_game->map_width());
+    logger.Info("- visibility: {}", m_game->visibility_range());
+
+    if(m_options.traceFolder)
+    {
+      const auto path = std::filesystem::path(*m_options.traceFolder) / std::format("{}.json", m_game->game_id());
+      auto trace = Tracing::TraceFile::Open(path, m_game->game_id());
+      if(trace)
+        m_trace = std::move(*trace);
+      else
+        logger.Warning("{}", trace.error());
+    }
   }
 
   bool Player::UpdateMap()
   {
-    const int visibility = m_game->visibility_range();
-
-    auto state0 = m_game->state().has_playerstate() ? std::make_optional(m_game->state().playerstate()) : std::nullopt;
-    const auto& pos0 = state0.transform([](const auto& state) { return state.position(); });
-    auto view0 = state0.transform([&](const auto& state) { return ViewFromState(visibility, state); });
-
-    auto state1 = m_game->state().has_player2state() ? std::make_optional(m_game->state().player2state()) : std::nullopt;
-    const auto& pos1 = state1.transform([](const auto& state) { return state.position(); });
-    auto view1 = state1.transform([&](const auto& state) { return ViewFromState(visibility, state); });
-
-    {
-      auto dungeonMap = m_dungeonMap.Lock();
-      if(state0)
-      {
-        assert(pos0 && view0);
-        dungeonMap = dungeonMap->Update(*pos0, visibility, *view0);
-      }
+    Allocations::Scope scope(Allocations::Phase::UpdateMap);
+    const PlayerViews views(m_game->state(), m_game->visibility_range());
 
-      if(state1)
+    m_dungeonMap.Update(
+      [&](const DungeonMap::Ptr& dungeonMap)
       {
-        assert(pos1 && view1);
-        dungeonMap = dungeonMap->Update(*pos1, visibility, *view1);
-      }
-    }
-
-    auto map = m_playerMap.Lock();
-    auto newMap = map.Get();
-    if(state0)
-    {
-      newMap = newMap->Update(0, *pos0, visibility, *view0);
-    }
-    if(state1)
-    {
-      newMap = newMap->Update(1, *pos1, visibility, *view1);
-    }
-
-    auto playerStateArray = m_state.Lock();
-    (*playerStateArray)[0].Update(state0, visibility, view0);
-    (*playerStateArray)[1].Update(state1, visibility, view1);
+        auto newDungeonMap = views.Apply(dungeonMap);
+        if(newDungeonMap != dungeonMap)
+          Metrics::CountMapSnapshot(Metrics::MapKind::Dungeon);
+        return newDungeonMap;
+      });
 
-    if(newMap != map.Get())
-    {
-      map = newMap;
+    views.Apply(*m_state.Write());
 
-      return true;
-    }
+    bool changed = false;
+    m_playerMap.Update(
+      [&](const PlayerMap::Ptr& map)
+      {
+        auto newMap = views.Apply(map);
+        changed = newMap != map;
+        if(changed)
+          Metrics::CountMapSnapshot(Metrics::MapKind::Player);
+        return newMap;
+      });
 
-    return false;
+    return changed;
   }
 
   std::expected<bool, std::string> Player::DoCommandIfAny(size_t playerId)
   {
-    if(m_state.Get()[playerId].active)
+    auto& commands = m_commands[playerId];
+    if(m_channels[playerId].Drain(commands))
     {
-      auto commandsArray = m_commands.Lock();
-      auto& commands = (*commandsArray)[playerId];
+      ++m_commandSerials[playerId];
+      TraceCommandEnd(playerId, "superseded");
+    }
 
+    if(m_state.Get()[playerId].active)
+    {
       std::expected<bool, std::string> result = true;
       while(result && *result && !commands.empty())
       {
-        result = std::visit(
-          Visitor{
-            [&](Explore_t) { return Explore(playerId); },
-            [&](const Bot::VisitTiles& visitTiles) { return VisitTiles(playerId, visitTiles.tiles); },
-            [&](Terminate_t) { return TerminateRequested(playerId); },
-            [&](const Bot::Visit& visit) { return Visit(playerId, visit.position); },
-            [&](const FetchKey& key) { return Visit(playerId, key.position); },
-            [&](Bot::OpenDoor& door) { return OpenDoor(playerId, door); },
-            [&](Bot::FetchBoulder& boulder) { return FetchBoulder(playerId, boulder); },
-            [&](DropBoulder_t& dropBoulder) { return DropBoulder(playerId, dropBoulder); },
-            [&](const ReconsiderUncheckedBoulders_t&) { return ReconsiderUncheckedBoulders(); },
-            [&](Bot::PlaceBoulderOnPressurePlate& place) { return PlaceBoulderOnPressurePlate(playerId, place); },
-            [&](const Wait_t&) { return Wait(playerId); },
-            [&](LeaveSquare_t& leaveSquare) { return LeaveSquare(playerId, leaveSquare.originalSquare); },
-            [&](DropDoorOnEnemy& dropDoorOnEnemy) { return Execute(playerId, dropDoorOnEnemy); },
-            [&](const Bot::PeekUnderEnemies& peekUnderEnemies)
-            { return PeekUnderEnemies(playerId, peekUnderEnemies.tileLocations); },
-            [&](Attack_t& attack) { return Attack(playerId, attack); },
-            [&](Bot::HuntEnemies& huntEnemies) { return HuntEnemies(playerId, huntEnemies); },
-          },
-          commands.front());
+        if(m_trace && !m_tracedCommands[playerId])
+          m_tracedCommands[playerId] = TracedCommand{CommandName(commands.front()), Tracing::Clock::now()};
+
+        result = DoCommand(playerId, commands.front());
 
         if(!result)
           return result;
         if(*result)
+        {
+          TraceCommandEnd(playerId, "done");
           commands.pop();
-      } // namespace Bot
+          ++m_commandSerials[playerId];
+        }
+      }
       assert(result);
       assert(!*result || commands.empty());
 
@@ -228,12 +307,59 @@ namespace Bot
     return true;
   }
 
+  std::expected<bool, std::string> Player::DoCommand(size_t playerId, Command& command)
+  {
+    Tracing::ScopedSpan span(m_trace.get(), Tracing::PlanTrack(playerId), CommandName(command));
+    auto result = std::visit(
+      Visitor{
+        [&](Explore_t) { return Explore(playerId); },
+        [&](const Bot::VisitTiles& visitTiles) { return VisitTiles(playerId, visitTiles.tiles); },
+        [&](Terminate_t) { return TerminateRequested(playerId); },
+        [&](const Bot::Visit& visit) { return Visit(playerId, visit.position); },
+        [&](const FetchKey& key) { return Visit(playerId, key.position); },
+        [&](Bot::OpenDoor& door) { return OpenDoor(playerId, door); },
+        [&](Bot::FetchBoulder& boulder) { return FetchBoulder(playerId, boulder); },
+        [&](DropBoulder_t& dropBoulder) { return DropBoulder(playerId, dropBoulder); },
+        [&](const ReconsiderUncheckedBoulders_t&) { return ReconsiderUncheckedBoulders(); },
+        [&](Bot::PlaceBoulderOnPressurePlate& place) { return PlaceBoulderOnPressurePlate(playerId, place); },
+        [&](const Wait_t&) { return Wait(playerId); },
+        [&](LeaveSquare_t& leaveSquare) { return LeaveSquare(playerId, leaveSquare.originalSquare); },
+        [&](DropDoorOnEnemy& dropDoorOnEnemy) { return Execute(playerId, dropDoorOnEnemy); },
+        [&](const Bot::PeekUnderEnemies& peekUnderEnemies) { return PeekUnderEnemies(playerId, peekUnderEnemies.tileLocations); },
+        [&](Attack_t& attack) { return Attack(playerId, attack); },
+        [&](Bot::HuntEnemies& huntEnemies) { return HuntEnemies(playerId, huntEnemies); },
+      },
+      command);
+    if(span.Enabled())
+      span.SetArgs(std::format(R"({{"speculative":{},"done":{}}})", speculation != nullptr, result.value_or(false)));
+    return result;
+  }
+
+  void Player::TraceCommandEnd(size_t playerId, std::string_view outcome)
+  {
+    auto& traced = m_tracedCommands[playerId];
+    if(!m_trace || !traced)
+      return;
+
+    m_trace->Complete(
+      Tracing::CommandTrack(playerId), traced->name, traced->start, Tracing::Clock::now(), std::format(R"({{"outcome":"{}"}})", outcome));
+    traced.reset();
+  }
+
   bool Player::WaitForCommands()
   {
-    auto commandsArray = m_commands.Lock();
-    return commandsArray.WaitUntil(
+    Tracing::ScopedSpan span(m_trace.get(), Tracing::Track::GameLoop, "WaitForCommands");
+    auto posted = m_commandsPosted.Read();
+    const bool arrived = posted.WaitUntil(
       m_lastCommandTime + delay,
-      [&] { return !std::ranges::all_of(*commandsArray, [](auto& commands) { return commands.empty(); }); });
+      [&]
+      {
+        return !std::ranges::all_of(m_commands, [](auto& commands) { return commands.empty(); })
+            || std::ranges::any_of(m_channels, [](auto& channel) { return channel.HasPending(); });
+      });
+    if(span.Enabled())
+      span.SetArgs(std::format(R"({{"timedOut":{}}})", !arrived));
+    return arrived;
   }
 
   void Player::PrintMap()
@@ -267,60 +393,113 @@ namespace Bot
             characterMap[step] = '*';
         }
       }
-      std::println("Player map:");
+      logger.Info("Player map:");
       Print(characterMap);
-      std::println();
-      std::println("Exit:                 {}", map->Exit());
-      std::println("DoorData:             {}", map->DoorData());
-      std::println("Unchecked boulders:   {}", map->uncheckedBoulders);
-      std::println("Used boulders:        {}", map->usedBoulders);
-      std::println("Enemies:              {}", map->enemies);
-      std::println("NavigationParameters: {}", map->NavigationParameters());
+      logger.Info("Exit:                 {}", map->Exit());
+      logger.Info("DoorData:             {}", map->DoorData());
+      logger.Info("Unchecked boulders:   {}", map->uncheckedBoulders);
+      logger.Info("Used boulders:        {}", map->usedBoulders);
+      logger.Info("Enemies:              {}", map->enemies);
+      logger.Info("NavigationParameters: {}", map->NavigationParameters());
     }
     if constexpr(Debugging::PrintPlayerMapsAsTiles)
     {
       PrintEnum(*m_playerMap.Get());
-      std::println();
     }
   }
 
   std::expected<void, std::string> Player::UpdatePlan(size_t playerId)
   {
-    std::expected<bool, std::string> commandDone = false;
+    Profiling::ScopedTimer timer(m_profile.get(), Profiling::UpdatePlan(playerId));
+    Metrics::ScopedLatency latency(Metrics::Plan(playerId));
+    Allocations::Scope scope(Allocations::Phase::Commands);
+    return ContinuePlan(playerId, DoCommandIfAny(playerId));
+  }
+
+  std::expected<void, std::string> Player::UpdatePlansInParallel()
+  {
+    Allocations::Scope scope(Allocations::Phase::Commands);
+    const auto map = m_playerMap.Get();
+    std::array<PlanningOverlay, 2> overlays{PlanningOverlay{map, {}}, PlanningOverlay{map, {}}};
+
+    auto plan = [&](size_t playerId)
+    {
+      Profiling::ScopedTimer timer(m_profile.get(), Profiling::UpdatePlan(playerId));
+      Metrics::ScopedLatency latency(Metrics::Plan(playerId));
+      // Runs on a pool thread, which has a phase of its own
+      Allocations::Scope planScope(Allocations::Phase::Commands);
+      // While waiting, this thread may run the other player's task, so restore rather than clear
+      PlanningOverlay* previous = std::exchange(planningOverlay, &overlays[playerId]);
+      auto result = DoCommandIfAny(playerId);
+      planningOverlay = previous;
+      return result;
+    };
+
+    auto [result0, result1] = ParallelInvoke(*m_options.taskPool, [&] { return plan(0); }, [&] { return plan(1); });
+    std::array results{std::move(result0), std::move(result1)};
+
+    // Whichever search finished first, side effects happen in player order
+    for(auto& overlay: overlays)
+    {
+      for(auto& edit: overlay.edits)
+      {
+        UpdateMap(std::move(edit));
+      }
+    }
+
+    for(size_t playerId: {0uz, 1uz})
+    {
+      auto result = ContinuePlan(playerId, std::move(results[playerId]));
+      if(!result)
+        return result;
+    }
+    return {};
+  }
+
+  std::expected<void, std::string> Player::ContinuePlan(size_t playerId, std::expected<bool, std::string> commandDone)
+  {
     bool commandArrived = true;
 
-    while(commandDone && !*commandDone && commandArrived)
+    while(true)
     {
-      commandDone = DoCommandIfAny(playerId);
       if(!commandDone)
         return std::unexpected(commandDone.error());
+      if(*commandDone)
+        break;
 
-      if(!*commandDone)
+      logger.Debug("Player {}: No commands done", playerId);
       {
-        std::println("Player {}: No commands done", playerId);
+        Profiling::ScopedTimer timer(m_profile.get(), Profiling::Phase::Callbacks);
+        Tracing::ScopedSpan span(m_trace.get(), Tracing::PlanTrack(playerId), "Finished");
         m_callbacks.Finished(playerId);
-        commandArrived = WaitForCommands();
       }
+      commandArrived = WaitForCommands();
+      if(!commandArrived)
+        break;
+
+      commandDone = DoCommandIfAny(playerId);
     }
 
     assert(*commandDone || !commandArrived);
-    if(!*commandDone)
+    // Only this thread writes the state, so it can't become inactive in between
+    if(!*commandDone && (*m_state.Read())[playerId].active)
     {
-      auto stateArray = m_state.Lock();
+      auto stateArray = m_state.Write();
       auto& state = (*stateArray)[playerId];
-      if(state.active)
-      {
-        std::println("Player {}: No commands found: {}", playerId, DirectedAction::DIRECTED_ACTION_NONE);
-        state.next = DirectedAction::DIRECTED_ACTION_NONE;
-        state.reversedPath.clear();
-        state.pathLength = 0;
-      }
+      logger.Info("Player {}: No commands found: {}", playerId, DirectedAction::DIRECTED_ACTION_NONE);
+      state.next = DirectedAction::DIRECTED_ACTION_NONE;
+      state.reversedPath.clear();
+      state.pathLength = 0;
     }
 
     return {};
   }
 
-  void Player::SetCommands(size_t playerId, Commands commands) { (*m_commands.Lock())[playerId].swap(commands); }
+  void Player::SetCommands(size_t playerId, Commands commands)
+  {
+    m_channels[playerId].Replace(std::move(commands));
+    ++*m_commandsPosted.Write();
+  }
 
   void Player::SetCommand(size_t playerId, Command command)
   {
@@ -330,15 +509,8 @@ namespace Bot
 
   void Player::FirstDo(size_t playerId, Commands commands)
   {
-    auto commandsArray = m_commands.Lock();
-    auto& currentCommands = (*commandsArray)[playerId];
-
-    while(!currentCommands.empty())
-    {
-      commands.push(std::move(currentCommands.front()));
-      currentCommands.pop();
-    }
-    currentCommands.swap(commands);
+    m_channels[playerId].Prepend(std::move(commands));
+    ++*m_commandsPosted.Write();
   }
 
   void Player::FirstDo(size_t playerId, Command command)
@@ -347,39 +519,57 @@ namespace Bot
     FirstDo(playerId, commands);
   }
 
-  void Player::InitializeCommands() { m_commands.Lock() = {}; }
-
-  void Player::InitializeMap()
+  void Player::InitializeCommands()
   {
-    auto state = m_game->state().playerstate();
-    auto pos = state.position();
-    auto map = m_playerMap.Lock();
-    auto newMap = std::make_shared<PlayerMap>(*map, max(pos + 2 * One, map->Size()));
-    auto& cell = (*newMap)[pos];
-    if(cell == Tile::TILE_UNKNOWN)
+    for(auto& channel: m_channels)
     {
-      cell = Tile::TILE_EMPTY;
+      channel.Discard();
     }
-    if(m_game->state().has_player2state())
+    m_commands = {};
+    for(auto& serial: m_commandSerials)
     {
-      auto state2 = m_game->state().player2state();
-      auto pos2 = state2.position();
-      newMap = std::make_shared<PlayerMap>(*newMap, max(pos2 + 2 * One, map->Size()));
-      auto& cell2 = (*newMap)[pos2];
-      if(cell2 == Tile::TILE_UNKNOWN)
-      {
-        cell2 = Tile::TILE_EMPTY;
-      }
+      ++serial;
+    }
+    for(size_t playerId: {0uz, 1uz})
+    {
+      TraceCommandEnd(playerId, "level ended");
     }
+    m_speculativePaths.Clear();
+  }
 
-    map = newMap;
+  void Player::InitializeMap()
+  {
+    const auto& state = m_game->state().playerstate();
+    const Offset pos = state.position();
+    m_playerMap.Update(
+      [&](const PlayerMap::Ptr& map) -> PlayerMap::Ptr
+      {
+        auto newMap = std::make_shared<PlayerMap>(*map, max(pos + 2 * One, map->Size()));
+        auto& cell = (*newMap)[pos];
+        if(cell == Tile::TILE_UNKNOWN)
+        {
+          cell = Tile::TILE_EMPTY;
+        }
+        if(m_game->state().has_player2state())
+        {
+          const auto& state2 = m_game->state().player2state();
+          const Offset pos2 = state2.position();
+          newMap = std::make_shared<PlayerMap>(*newMap, max(pos2 + 2 * One, map->Size()));
+          auto& cell2 = (*newMap)[pos2];
+          if(cell2 == Tile::TILE_UNKNOWN)
+          {
+            cell2 = Tile::TILE_EMPTY;
+          }
+        }
+        return newMap;
+      });
   }
 
   void Player::InitializeState()
   {
-    auto stateArray = m_state.Lock();
+    auto stateArray = m_state.Write();
     stateArray = {};
-    auto state = m_game->state();
+    const auto& state = m_game->state();
 
     if(state.has_playerstate())
     {
@@ -412,7 +602,7 @@ namespace Bot
       return std::unexpected(action.error());
     }
 
-    std::println(
+    logger.Debug(
       "Player {}: tick: {}, action: {} because position is {} and next is {}",
       state.playerId,
       m_game->state().tick(),
@@ -434,7 +624,7 @@ namespace Bot
       return std::unexpected(action.error());
     }
 
-    std::println(
+    logger.Debug(
       "Player: {}, tick: {}, action: {} because position is {} and next is {}",
       state.playerId,
       m_game->state().tick(),
@@ -479,7 +669,8 @@ namespace Bot
 
   std::expected<bool, std::string> Player::VisitTiles(size_t playerId, const std::set<Tile>& tiles)
   {
-    auto map = m_playerMap.Get();
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "VisitTiles");
+    auto map = CurrentMap();
     return ComputePathToDestinationAndThen(
       playerId,
       map,
@@ -489,18 +680,20 @@ namespace Bot
 
   std::expected<bool, std::string> Player::Visit(size_t playerId, Offset destination)
   {
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "Visit");
     return ComputePathToDestinationAndThen(
       playerId,
-      m_playerMap.Get(),
+      CurrentMap(),
       [destination](Offset p) { return p == destination; },
       [&](PlayerState& state) { return MoveToDestination(state, destination); });
   }
 
   std::expected<bool, std::string> Player::Visit(size_t playerId, OffsetSet destinations)
   {
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "Visit");
     return ComputePathToDestinationAndThen(
       playerId,
-      m_playerMap.Get(),
+      CurrentMap(),
       [destinations](Offset p) { return destinations.contains(p); },
       [&](PlayerState& state) { return MoveToDestination(state); });
   }
@@ -512,8 +705,8 @@ namespace Bot
       door,
       [&]()
       {
-        std::println("Player {}: Opened door of color {}", state.playerId, door.color);
-        UpdateMap([&](auto map) { map->NavigationParameters().doorParameters.at(door.color).avoidDoor = false; });
+        logger.Info("Player {}: Opened door of color {}", state.playerId, door.color);
+        UpdateMap([color = door.color](auto map) { map->NavigationParameters().doorParameters.at(color).avoidDoor = false; });
       });
   }
 
@@ -528,7 +721,7 @@ namespace Bot
       auto destination = state.reversedPath.front();
       if((*map)[destination] == expectedTileAfterUse)
       {
-        std::println("Player {}: Finished {}", state.playerId, message);
+        logger.Info("Player {}: Finished {}", state.playerId, message);
         return true;
       }
 
@@ -548,19 +741,21 @@ namespace Bot
 
   std::expected<bool, std::string> Player::OpenDoor(size_t playerId, Bot::OpenDoor& door)
   {
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "OpenDoor");
     return ComputePathToDestinationAndThen(
       playerId,
-      m_playerMap.Get(),
+      CurrentMap(),
       [&](Offset p) { return door.positions.contains(p); },
       [&](PlayerState& state) { return MoveAlongPathThenOpenDoor(state, door); });
   }
 
   std::expected<bool, std::string> Player::FetchBoulder(size_t playerId, Bot::FetchBoulder& fetchBoulder)
   {
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "FetchBoulder");
     auto boulderPositions = fetchBoulder.positions;
     return ComputePathToDestinationAndThen(
       playerId,
-      m_playerMap.Get(),
+      CurrentMap(),
       [&](Offset p) { return boulderPositions.contains(p); },
       [&](PlayerState& state)
       {
@@ -570,9 +765,9 @@ namespace Bot
           [&]()
           {
             auto boulderPosition = state.reversedPath.front();
-            std::println("FetchBoulder: About to pick up boulder at {}", boulderPosition);
+            logger.Info("FetchBoulder: About to pick up boulder at {}", boulderPosition);
             UpdateMap(
-              [&](auto map)
+              [boulderPosition](auto map)
               {
                 map->uncheckedBoulders.erase(boulderPosition);
                 map->usedBoulders.erase(boulderPosition);
@@ -583,7 +778,8 @@ namespace Bot
 
   std::expected<bool, std::string> Player::DropBoulder(size_t playerId, Bot::DropBoulder_t& dropBoulder)
   {
-    auto map = m_playerMap.Get();
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "DropBoulder");
+    auto map = CurrentMap();
     auto myLocation = m_state.Get()[playerId].position;
     return ComputePathToDestinationAndThen(
       playerId,
@@ -597,7 +793,7 @@ namespace Bot
           [&]()
           {
             auto destination = state.reversedPath.front();
-            std::println("DropBoulder: About to drop boulder at {}", destination);
+            logger.Info("DropBoulder: About to drop boulder at {}", destination);
           });
       });
   }
@@ -605,9 +801,10 @@ namespace Bot
   std::expected<bool, std::string>
     Player::PlaceBoulderOnPressurePlate(size_t playerId, Bot::PlaceBoulderOnPressurePlate& placeBoulder)
   {
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "PlaceBoulderOnPressurePlate");
     return ComputePathToDestinationAndThen(
       playerId,
-      m_playerMap.Get(),
+      CurrentMap(),
       [&](Offset p) { return placeBoulder.positions.contains(p); },
       [&](PlayerState& state) -> std::expected<bool, std::string>
       {
@@ -617,12 +814,12 @@ namespace Bot
           [&]()
           {
             auto pressurePlatePosition = state.reversedPath.front();
-            std::println("PlaceBoulderOnPressurePlate: About to drop boulder at {}", pressurePlatePosition);
+            logger.Info("PlaceBoulderOnPressurePlate: About to drop boulder at {}", pressurePlatePosition);
             UpdateMap(
-              [&](auto map)
+              [pressurePlatePosition, color = placeBoulder.color](auto map)
               {
                 map->usedBoulders.insert(pressurePlatePosition);
-                map->NavigationParameters().doorParameters.at(placeBoulder.color).avoidDoor = false;
+                map->NavigationParameters().doorParameters.at(color).avoidDoor = false;
               });
           });
       });
@@ -631,7 +828,7 @@ namespace Bot
   std::expected<bool, std::string> Player::ReconsiderUncheckedBoulders()
   {
     UpdateMap(
-      [&](auto map)
+      [](auto map)
       {
         map->uncheckedBoulders = map->uncheckedBoulders | std::views::filter([&map](Offset p) { return !map->IsGoodBoulder(p); })
                                | std::ranges::to<OffsetSet>();
@@ -643,14 +840,14 @@ namespace Bot
 
   std::expected<bool, std::string> Player::TerminateRequested(size_t playerId)
   {
-    std::println("Player {}: Terminate requested", playerId);
+    logger.Info("Player {}: Terminate requested", playerId);
     m_terminateRequested = true;
     return false;
   }
 
   std::expected<bool, std::string> Player::Wait(size_t playerId)
   {
-    auto stateArray = m_state.Lock();
+    auto stateArray = m_state.Write();
     auto& state = (*stateArray)[playerId];
     state.next = DirectedAction::DIRECTED_ACTION_NONE;
     return false;
@@ -669,6 +866,7 @@ namespace Bot
 
   std::expected<bool, std::string> Player::LeaveSquare(size_t playerId, std::optional<Offset>& originalSquare)
   {
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "LeaveSquare");
     auto position = m_state.Get()[playerId].position;
     if(!originalSquare)
     {
@@ -681,14 +879,15 @@ namespace Bot
 
     return ComputePathAndThen(
       playerId,
-      m_playerMap.Get(),
+      CurrentMap(),
       [position](Offset p) { return p != position; },
       [&](PlayerState& state) { return MoveToDestination(state); });
   }
 
   std::expected<bool, std::string> Player::Execute(size_t playerId, DropDoorOnEnemy& dropDoorOnEnemy)
   {
-    auto map = m_playerMap.Get();
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "DropDoorOnEnemy");
+    auto map = CurrentMap();
     if(dropDoorOnEnemy.waiting)
     {
       const auto& enemies = map->enemies.inSight[playerId];
@@ -705,7 +904,8 @@ namespace Bot
 
   std::expected<bool, std::string> Player::PeekUnderEnemies(size_t playerId, const OffsetSet& tileLocations)
   {
-    auto map = m_playerMap.Get();
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "PeekUnderEnemies");
+    auto map = CurrentMap();
     auto remaining = tileLocations | std::views::filter([&](Offset location) { return (*map)[location] == Tile::TILE_UNKNOWN; })
                    | std::ranges::to<OffsetSet>();
 
@@ -716,7 +916,7 @@ namespace Bot
     navigationParameters.avoidEnemies = false;
     auto weights = WeightMap(playerId, *map, map->enemies, navigationParameters, destinationPredicate);
 
-    auto [dist, destination] = DistanceMap(weights, state.position, destinationPredicate);
+    auto [dist, destination] = DistanceMap(weights, state.position, destinationPredicate, SearchCaller(playerId));
     if(!destination)
       return true;
 
@@ -738,21 +938,23 @@ namespace Bot
 
   std::expected<bool, std::string> Player::Attack(size_t playerId, Attack_t&)
   {
-    auto map = m_playerMap.Get();
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "Attack");
+    auto map = CurrentMap();
     if(map->enemies.inSight[playerId].empty())
     {
-      auto currentMap = m_playerMap.Lock();
-      auto newMap = currentMap->Clone();
-      newMap->enemies.killed++;
-      currentMap = newMap;
+      UpdateMap([](auto newMap) { newMap->enemies.killed++; });
       return true;
     }
-    auto stateArray = m_state.Lock();
-    auto& state = (*stateArray)[playerId];
-    if(state.health <= 1)
+    Offset position{0, 0};
     {
-      std::println("Health low. Giving up");
-      return true;
+      auto stateArray = m_state.Read();
+      const auto& state = (*stateArray)[playerId];
+      if(state.health <= 1)
+      {
+        logger.Info("Health low. Giving up");
+        return true;
+      }
+      position = state.position;
     }
 
     auto destinationPredicate = [&](Offset p) { return map->enemies.inSight[playerId].contains(p); };
@@ -760,14 +962,22 @@ namespace Bot
     navigationParameters.avoidEnemies = false;
     auto weights = WeightMap(playerId, *map, map->enemies, navigationParameters, destinationPredicate);
 
-    auto [dist, destination] = DistanceMap(weights, state.position, destinationPredicate);
+    auto [dist, destination] = DistanceMap(weights, position, destinationPredicate, SearchCaller(playerId));
     if(!destination)
       return std::unexpected("Enemies are unreachable?");
 
     auto distance = dist[*destination];
+    std::vector<Offset> reversedPath;
+    if(distance != 2)
+    {
+      reversedPath = ReversedPath(weights, position, destinationPredicate, SearchCaller(playerId));
+    }
+
+    auto stateArray = m_state.Write();
+    auto& state = (*stateArray)[playerId];
     if(distance != 2)
     {
-      state.reversedPath = ReversedPath(weights, state.position, destinationPredicate);
+      state.reversedPath = std::move(reversedPath);
       state.pathLength = state.reversedPath.size();
       std::expected<bool, std::string> used = StepAlongPathOrUse(state);
       if(!used)
@@ -780,8 +990,9 @@ namespace Bot
 
   std::expected<bool, std::string> Player::HuntEnemies(size_t playerId, Bot::HuntEnemies& huntEnemies)
   {
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "HuntEnemies");
     auto stateArray = m_state.Get();
-    auto map = m_playerMap.Get();
+    auto map = CurrentMap();
 
     for(auto& state: stateArray)
     {
@@ -810,6 +1021,7 @@ namespace Bot
 
   std::expected<bool, std::string> Player::Explore(size_t playerId)
   {
+    SearchStats::Scope searchScope(m_searchCallers[playerId], "Explore");
     std::set tiles{Tile::TILE_UNKNOWN, Tile::TILE_HEALTH};
     auto stateArray = m_state.Get();
     auto& state = stateArray[playerId];
@@ -819,47 +1031,236 @@ namespace Bot
     return VisitTiles(playerId, tiles);
   }
 
+  void Player::UpdateMap(MapEdit edit)
+  {
+    if(planningOverlay)
+    {
+      auto newMap = planningOverlay->map->Clone();
+      edit(newMap);
+      planningOverlay->map = newMap;
+      planningOverlay->edits.push_back(std::move(edit));
+      return;
+    }
+
+    m_playerMap.Update(
+      [&](const PlayerMap::Ptr& map) -> PlayerMap::Ptr
+      {
+        auto newMap = map->Clone();
+        edit(newMap);
+        Metrics::CountMapSnapshot(Metrics::MapKind::Player);
+        return newMap;
+      });
+  }
+
+  PlayerMap::Ptr Player::CurrentMap() const { return planningOverlay ? planningOverlay->map : m_playerMap.Get(); }
+
+  Offset Player::Position(size_t playerId) const { return (*m_state.Read())[playerId].position; }
+
+  std::expected<void, std::string> Player::Act()
+  {
+    std::optional<DirectedAction> action0;
+    std::optional<DirectedAction> action1;
+    std::array<std::optional<Offset>, 2> predictedPositions;
+    {
+      auto stateArray = m_state.Read();
+      action0 = (*stateArray)[0].GetAction();
+      action1 = (*stateArray)[1].GetAction();
+      predictedPositions = {PredictedPosition((*stateArray)[0]), PredictedPosition((*stateArray)[1])};
+    }
+
+    Allocations::Scope scope(Allocations::Phase::Protobuf);
+    if(!m_options.pipelinedAct)
+    {
+      auto acted = m_game->act(action0, action1);
+      RecordActRoundTrip();
+      return acted;
+    }
+
+    auto started = m_game->act_start(action0, action1);
+    if(!started)
+    {
+      return started;
+    }
+    {
+      Tracing::ScopedSpan span(m_trace.get(), Tracing::Track::GameLoop, "Speculate");
+      Speculate(predictedPositions);
+    }
+    auto acted = m_game->act_finish();
+    RecordActRoundTrip();
+    return acted;
+  }
+
+  // Only the time the request was on its way, which in pipelined mode overlaps with speculating. So the span is on the gRPC
+  // track, next to the Speculate span on the game loop.
+  void Player::RecordActRoundTrip()
+  {
+    const auto roundTrip = m_game->last_act_round_trip();
+    if(!roundTrip)
+      return;
+
+    Metrics::Record(Metrics::Latency::Act, roundTrip->received - roundTrip->sent);
+    if(m_trace)
+      m_trace->Complete(Tracing::Track::Grpc, "Act", roundTrip->sent, roundTrip->received);
+  }
+
+  void Player::Speculate(const std::array<std::optional<Offset>, 2>& predictedPositions)
+  {
+    auto speculate = [&](size_t playerId)
+    {
+      auto& commands = m_commands[playerId];
+      if(!predictedPositions[playerId] || commands.empty() || !IsPathCommand(commands.front()))
+        return false;
+
+      Allocations::Scope scope(Allocations::Phase::Commands);
+      // Work on a copy, so the real command is untouched when the speculation turns out to be wrong
+      Command command = commands.front();
+      Speculation current{playerId, *predictedPositions[playerId]};
+      const Speculation* previous = std::exchange(speculation, &current);
+      auto result = DoCommand(playerId, command);
+      speculation = previous;
+      return result.has_value();
+    };
+
+    ParallelInvoke(*m_options.taskPool, [&] { return speculate(0); }, [&] { return speculate(1); });
+  }
+
+  std::optional<Offset> Player::SpeculativeStart(size_t playerId) const
+  {
+    if(speculation && speculation->playerId == playerId)
+      return speculation->start;
+    return std::nullopt;
+  }
+
+  void Player::StoreSpeculativePath(size_t playerId, const PlayerMap::Ptr& map, Offset start, std::vector<Offset> reversedPath)
+  {
+    m_speculativePaths.Store(playerId, map, start, m_commandSerials[playerId], std::move(reversedPath));
+  }
+
+  std::optional<std::vector<Offset>> Player::TakeSpeculativePath(size_t playerId, const PlayerMap::Ptr& map, Offset position)
+  {
+    return m_speculativePaths.Take(playerId, map, position, m_commandSerials[playerId]);
+  }
+
   std::expected<void, std::string> Player::Run()
   {
-    // Game loop
+    if constexpr(Profiling::Enabled)
+    {
+      m_profile = std::make_unique<Profiling::TickProfile>(m_game->game_id(), m_options.profileFile);
+      m_searchStats = std::make_unique<SearchStats::Stats>(m_options.searchHeatmapFolder.has_value());
+    }
+
+    auto result = GameLoop();
+    for(size_t playerId: {0uz, 1uz})
+    {
+      TraceCommandEnd(playerId, "game ended");
+    }
+    Metrics::RemoveGame(m_game->game_id());
+
+    if constexpr(Profiling::Enabled)
+    {
+      FinishLevelProfile();
+      m_profile->FinishGame();
+    }
+    return result;
+  }
+
+  void Player::FinishLevelProfile()
+  {
+    if(m_level < 0)
+      return;
+
+    m_profile->FinishLevel(m_level);
+    logger.Info("Search effort on level {}:", m_level);
+    m_searchStats->Print();
+    if(m_options.searchHeatmapFolder)
+    {
+      const std::filesystem::path folder = *m_options.searchHeatmapFolder;
+      std::error_code error;
+      std::filesystem::create_directories(folder, error);
+      const auto path = folder / std::format("{}-level-{}.csv", m_game->game_id(), m_level);
+      if(!m_searchStats->WriteHeatmap(path))
+        logger.Warning("Failed to write {}", path.string());
+    }
+    m_searchStats->Reset();
+  }
+
+  std::expected<void, std::string> Player::GameLoop()
+  {
     while(m_game->state().status() == GameStatus::GAME_STATUS_ACTIVE)
     {
+      Tracing::ScopedSpan tick(m_trace.get(), Tracing::Track::GameLoop, "Tick");
+      if(tick.Enabled())
+        tick.SetArgs(std::format(R"({{"tick":{},"level":{}}})", m_game->state().tick(), m_game->state().level()));
+
       auto level = m_game->state().level();
       if(level != m_level)
       {
-        m_callbacks.LevelReached(level);
+        if constexpr(Profiling::Enabled)
+        {
+          FinishLevelProfile();
+        }
+        {
+          Profiling::ScopedTimer timer(m_profile.get(), Profiling::Phase::Callbacks);
+          Tracing::ScopedSpan span(m_trace.get(), Tracing::Track::GameLoop, "LevelReached");
+          m_callbacks.LevelReached(level);
+        }
         m_level = level;
+        Metrics::SetLevel(m_game->game_id(), level);
         InitializeLevel();
       }
 
-      if(UpdateMap())
+      bool mapChanged = false;
+      {
+        Profiling::ScopedTimer timer(m_profile.get(), Profiling::Phase::UpdateMap);
+        Tracing::ScopedSpan span(m_trace.get(), Tracing::Track::GameLoop, "UpdateMap");
+        mapChanged = UpdateMap();
+      }
+      if(mapChanged)
       {
+        Profiling::ScopedTimer timer(m_profile.get(), Profiling::Phase::Callbacks);
+        Tracing::ScopedSpan span(m_trace.get(), Tracing::Track::GameLoop, "MapUpdated");
         m_callbacks.MapUpdated();
       }
-      auto updateResult = UpdatePlan(0).and_then([&] { return UpdatePlan(1); });
+      const auto states = m_state.Get();
+      const bool planInParallel = m_options.planningMode == PlanningMode::Parallel && states[0].active && states[1].active;
+      std::expected<void, std::string> updateResult;
+      {
+        Tracing::ScopedSpan span(m_trace.get(), Tracing::Track::GameLoop, "UpdatePlan");
+        updateResult = planInParallel ? UpdatePlansInParallel() : UpdatePlan(0).and_then([&] { return UpdatePlan(1); });
+      }
       if(!updateResult)
       {
         return std::unexpected(updateResult.error());
       }
 
-      PrintMap();
+      {
+        Profiling::ScopedTimer timer(m_profile.get(), Profiling::Phase::PrintMap);
+        PrintMap();
+      }
 
       if(m_terminateRequested)
       {
-        std::println("Player: Terminating");
+        logger.Info("Player: Terminating");
         return {};
       }
 
-      auto stateArray = m_state.Lock();
-      auto& state0 = (*stateArray)[0];
-      auto& state1 = (*stateArray)[1];
-      auto result = m_game->act(state0.GetAction(), state1.GetAction());
+      std::expected<void, std::string> result;
+      {
+        Profiling::ScopedTimer timer(m_profile.get(), Profiling::Phase::Act);
+        result = Act();
+      }
       m_lastCommandTime = std::chrono::steady_clock::now();
       if(!result)
       {
-        std::println("Player: Action failed: {}", result.error());
+        logger.Error("Player: Action failed: {}", result.error());
         return std::unexpected("Action failed");
       }
+      Metrics::CountTick();
+    }
+
+    if(m_options.pipelinedAct)
+    {
+      logger.Info("Player: speculative paths used: {}, discarded: {}", m_speculativePaths.Used(), m_speculativePaths.Discarded());
     }
     return InterpretGameState(m_game->state().status());
   }
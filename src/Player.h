@@ -2,13 +2,21 @@
 
 #include <chrono>
 #include <expected>
+#include <functional>
 
+#include "AtomicSnapshot.h"
+#include "CommandChannel.h"
 #include "Commands.h"
 #include "DungeonMap.h"
 #include "GameCallbacks.h"
+#include "Options.h"
 #include "PlayerMap.h"
+#include "Profiling.h"
+#include "SearchStats.h"
+#include "SpeculativePaths.h"
 #include "Swoq.hpp"
 #include "ThreadSafe.h"
+#include "Tracing.h"
 
 namespace Bot
 {
@@ -27,24 +35,46 @@ namespace Bot
     int visibility = 0;
     Vector2d<Swoq::Interface::Tile> view;
 
+    // state is null when the player isn't in the game
     void Update(
-      const std::optional<Swoq::Interface::PlayerState>& state,
+      const Swoq::Interface::PlayerState* state,
       int visibility_,
-      std::optional<Vector2d<Swoq::Interface::Tile>>& view_);
-    std::optional<DirectedAction> GetAction();
+      const std::optional<Vector2d<Swoq::Interface::Tile>>& view_);
+    std::optional<DirectedAction> GetAction() const;
   };
 
   using PlayerStateArray = std::array<PlayerState, 2>;
 
+  // What the players see in a state of the game, and how that changes the maps and player states. Apply doesn't
+  // change the views, so it can run inside AtomicSnapshot::Update. The replay benchmark uses this without a Player.
+  struct PlayerViews
+  {
+    PlayerViews(const Swoq::Interface::State& state, int visibility_);
+
+    int visibility;
+    // Null for a player that isn't in the game
+    std::array<const Swoq::Interface::PlayerState*, 2> states{};
+    std::array<std::optional<Vector2d<Swoq::Interface::Tile>>, 2> views;
+
+    [[nodiscard]] DungeonMap::Ptr Apply(const DungeonMap::Ptr& dungeonMap) const;
+    [[nodiscard]] PlayerMap::Ptr Apply(const PlayerMap::Ptr& map) const;
+    void Apply(PlayerStateArray& players) const;
+  };
+
   class Player
   {
   public:
     Player(
       GameCallbacks& callbacks,
       std::unique_ptr<Swoq::Game> game,
-      ThreadSafe<DungeonMap::Ptr>& dungeonMap,
-      ThreadSafe<PlayerMap::Ptr>& map);
+      AtomicSnapshot<DungeonMap>& dungeonMap,
+      AtomicSnapshot<PlayerMap>& map,
+      const Options& options = {});
     std::expected<void, std::string> Run();
+    // Null unless Options::traceFolder is set
+    Tracing::TraceFile* Trace() const { return m_trace.get(); }
+    // Null unless Profiling::Enabled
+    SearchStats::Stats* SearchStatistics() const { return m_searchStats.get(); }
 
     PlayerStateArray State() { return m_state.Get(); }
     void SetCommands(size_t playerId, Commands commands);
@@ -53,6 +83,9 @@ namespace Bot
     void FirstDo(size_t playerId, Command command);
 
   private:
+    // Edits may be replayed after the command that made them has finished, so they must capture by value
+    using MapEdit = std::function<void(const std::shared_ptr<PlayerMap>&)>;
+
     void InitializeCommands();
     void InitializeLevel();
     void InitializeMap();
@@ -76,6 +109,8 @@ namespace Bot
     std::expected<bool, std::string> HuntEnemies(size_t playerId, HuntEnemies& huntEnemies);
     std::expected<bool, std::string> Explore(size_t playerId);
     std::expected<void, std::string> UpdatePlan(size_t playerId);
+    std::expected<void, std::string> UpdatePlansInParallel();
+    std::expected<void, std::string> ContinuePlan(size_t playerId, std::expected<bool, std::string> commandDone);
     std::expected<bool, std::string> DoCommandIfAny(size_t playerId);
     bool WaitForCommands();
     void PrintMap();
@@ -98,13 +133,12 @@ namespace Bot
       Predicate&& predicate,
       Callable&& callable)
     {
-      auto stateArrayProxy = m_state.Lock();
-      auto& state = (*stateArrayProxy)[playerId];
-      auto weights = WeightMap(playerId, *map, map->enemies, map->NavigationParameters(), predicate);
-      state.reversedPath = ReversedPath(weights, state.position, std::forward<Predicate>(predicate));
-      state.pathLength = state.reversedPath.size();
-
-      return std::forward<Callable>(callable)(state);
+      return ComputeReversedPathAndThen(
+        playerId,
+        map,
+        [&] { return WeightMap(playerId, *map, map->enemies, map->NavigationParameters(), predicate); },
+        std::forward<Predicate>(predicate),
+        std::forward<Callable>(callable));
     }
 
     template <typename Predicate, typename Callable>
@@ -112,14 +146,45 @@ namespace Bot
     std::expected<bool, std::string>
       ComputePathAndThen(size_t playerId, const std::shared_ptr<const PlayerMap>& map, Predicate&& predicate, Callable&& callable)
     {
-      auto stateArrayProxy = m_state.Lock();
+      return ComputeReversedPathAndThen(
+        playerId,
+        map,
+        [&] { return WeightMap(playerId, *map, map->enemies, map->NavigationParameters()); },
+        std::forward<Predicate>(predicate),
+        std::forward<Callable>(callable));
+    }
+
+    // While speculating, only computes the path from the predicted position and stores it for the next tick
+    template <typename Weights, typename Predicate, typename Callable>
+    std::expected<bool, std::string> ComputeReversedPathAndThen(
+      size_t playerId,
+      const std::shared_ptr<const PlayerMap>& map,
+      Weights&& weights,
+      Predicate&& predicate,
+      Callable&& callable)
+    {
+      if(auto start = SpeculativeStart(playerId))
+      {
+        StoreSpeculativePath(
+          playerId, map, *start, ReversedPath(std::invoke(weights), *start, std::forward<Predicate>(predicate), SearchCaller(playerId)));
+        return false;
+      }
+
+      const Offset position = Position(playerId);
+      auto reversedPath = TakeSpeculativePath(playerId, map, position);
+      if(!reversedPath)
+      {
+        reversedPath = ReversedPath(std::invoke(weights), position, std::forward<Predicate>(predicate), SearchCaller(playerId));
+      }
+
+      auto stateArrayProxy = m_state.Write();
       auto& state = (*stateArrayProxy)[playerId];
-      auto weights = WeightMap(playerId, *map, map->enemies, map->NavigationParameters());
-      state.reversedPath = ReversedPath(weights, state.position, std::forward<Predicate>(predicate));
+      state.reversedPath = std::move(*reversedPath);
       state.pathLength = state.reversedPath.size();
 
       return std::forward<Callable>(callable)(state);
     }
+
     template <typename Callable>
       requires std::is_invocable_v<Callable>
     std::expected<bool, std::string> MoveAlongPathThenUse(PlayerState& state, Bot::MoveThenUse& moveThenUse, Callable&& onUse)
@@ -146,25 +211,52 @@ namespace Bot
       return std::unexpected("Destination unreachable");
     }
 
-    template <typename Callable>
-      requires std::is_invocable_v<Callable, const std::shared_ptr<PlayerMap>&>
-    void UpdateMap(Callable&& callable)
+    void UpdateMap(MapEdit edit);
+    PlayerMap::Ptr CurrentMap() const;
+    SearchStats::Caller SearchCaller(size_t playerId) { return {m_searchStats.get(), m_searchCallers[playerId]}; }
+    Offset Position(size_t playerId) const;
+
+    struct TracedCommand
     {
-      auto map = m_playerMap.Lock();
-      auto newMap = map->Clone();
-      std::invoke(std::forward<Callable>(callable), newMap);
-      map = newMap;
-    }
+      std::string_view name;
+      Tracing::Clock::time_point start;
+    };
+
+    std::expected<void, std::string> GameLoop();
+    void FinishLevelProfile();
+    std::expected<void, std::string> Act();
+    void Speculate(const std::array<std::optional<Offset>, 2>& predictedPositions);
+    void RecordActRoundTrip();
+    std::expected<bool, std::string> DoCommand(size_t playerId, Command& command);
+    void TraceCommandEnd(size_t playerId, std::string_view outcome);
+    std::optional<Offset> SpeculativeStart(size_t playerId) const;
+    void StoreSpeculativePath(size_t playerId, const PlayerMap::Ptr& map, Offset start, std::vector<Offset> reversedPath);
+    std::optional<std::vector<Offset>> TakeSpeculativePath(size_t playerId, const PlayerMap::Ptr& map, Offset position);
 
     GameCallbacks& m_callbacks;
     std::unique_ptr<Swoq::Game> m_game;
-    ThreadSafe<DungeonMap::Ptr>& m_dungeonMap;
-    ThreadSafe<std::shared_ptr<const PlayerMap>>& m_playerMap;
+    AtomicSnapshot<DungeonMap>& m_dungeonMap;
+    AtomicSnapshot<PlayerMap>& m_playerMap;
+    Options m_options;
     int m_level = -1;
-    ThreadSafe<PlayerStateArray> m_state;
-    ThreadSafe<std::array<Commands, 2>> m_commands;
+    SharedThreadSafe<PlayerStateArray> m_state;
+    std::array<CommandChannel, 2> m_channels;
+    std::array<Commands, 2> m_commands;
+    // Changes whenever the command at the front of the queue may have changed
+    std::array<std::uint64_t, 2> m_commandSerials{};
+    SpeculativePaths m_speculativePaths;
+    SharedThreadSafe<std::uint64_t> m_commandsPosted;
     std::chrono::steady_clock::time_point m_lastCommandTime = std::chrono::steady_clock::now();
     std::atomic<bool> m_terminateRequested = false;
+    // Only with Profiling::Enabled
+    std::unique_ptr<Profiling::TickProfile> m_profile;
+    std::unique_ptr<SearchStats::Stats> m_searchStats;
+    // Per player, the command its searches are counted for. Not thread_local: a task pool thread may run the other
+    // player's search while it waits.
+    std::array<std::string_view, 2> m_searchCallers{};
+    std::unique_ptr<Tracing::TraceFile> m_trace;
+    // The command at the front of each queue, for the trace
+    std::array<std::optional<TracedCommand>, 2> m_tracedCommands;
   };
 
 } // namespace Bot
@@ -2,8 +2,8 @@
 
 #include <algorithm>
 #include <cassert>
-#include <print>
 
+#include "Logging.h"
 #include "LoggingAndDebugging.h"
 #include "Swoq.hpp"
 
@@ -11,6 +11,8 @@ namespace Bot
 {
   namespace
   {
+    constexpr Log::Logger<Log::Category::Map> logger;
+
     bool AreTilesConsistent(Tile viewTile, Tile destinationTile)
     {
       bool const result = viewTile == Tile::TILE_UNKNOWN || destinationTile == Tile::TILE_UNKNOWN || viewTile == destinationTile
@@ -18,7 +20,7 @@ namespace Bot
                        || CanMove(destinationTile) || IsDoor(destinationTile) || IsDoor(viewTile);
 
       if(!result)
-        std::println("Tiles are not consistent: view {}, destination {}", viewTile, destinationTile);
+        logger.Warning("Tiles are not consistent: view {}, destination {}", viewTile, destinationTile);
 
       return result;
     }
@@ -254,17 +256,21 @@ namespace Bot
     {
       const auto MyCharFromTile = [&me = *this](Offset p) { return me.IsInRange(p) ? CharFromTile(me[p]) : '@'; };
 
-      std::println(
-        "IsGoodBoulder at position {}: doublyIsolated: {}, partiallyIsolated: {}, result: {}",
+      logger.Info(
+        "IsGoodBoulder at position {}: doublyIsolated: {}, partiallyIsolated: {}, result: {}\n{}{}{}\n{}{}{}\n{}{}{}",
         position,
         doublyIsolated,
         partiallyIsolated,
-        result);
-      std::println(
-        "{}{}{}", MyCharFromTile(position + NorthWest), MyCharFromTile(position + North), MyCharFromTile(position + NorthEast));
-      std::println("{}{}{}", MyCharFromTile(position + West), MyCharFromTile(position), MyCharFromTile(position + East));
-      std::println(
-        "{}{}{}", MyCharFromTile(position + SouthWest), MyCharFromTile(position + South), MyCharFromTile(position + SouthEast));
+        result,
+        MyCharFromTile(position + NorthWest),
+        MyCharFromTile(position + North),
+        MyCharFromTile(position + NorthEast),
+        MyCharFromTile(position + West),
+        MyCharFromTile(position),
+        MyCharFromTile(position + East),
+        MyCharFromTile(position + SouthWest),
+        MyCharFromTile(position + South),
+        MyCharFromTile(position + SouthEast));
     }
     return result;
   }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "Allocations.h"
 #include "Dijkstra.h"
+#include "Logging.h"
 #include "LoggingAndDebugging.h"
 #include "Map.h"
 #include "Swoq.pb.h"
@@ -224,6 +226,7 @@ namespace Bot
     const NavigationParameters& navigationParameters,
     Callable&& callable)
   {
+    Allocations::Scope scope(Allocations::Phase::WeightMap);
     const int Inf = Infinity(map);
     Vector2d weights(map.Width(), map.Height(), Inf);
 
@@ -243,7 +246,7 @@ namespace Bot
 
     if constexpr(Debugging::PrintWeightMap)
     {
-      std::println("Weight map {}:", playerId);
+      Log::Logger<Log::Category::Path>().Info("Weight map {}:", playerId);
       Print(weights);
     }
     return weights;
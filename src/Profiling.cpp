@@ -0,0 +1,146 @@
+#include "Profiling.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <print>
+
+#include "Logging.h"
+
+namespace Bot::Profiling
+{
+  namespace
+  {
+    // Games may share the dump file
+    std::mutex dumpMutex;
+
+    constexpr Log::Logger<Log::Category::Profiling> logger;
+
+    double Microseconds(Clock::duration duration) { return std::chrono::duration<double, std::micro>(duration).count(); }
+  } // namespace
+
+  std::size_t Histogram::BucketIndex(std::uint64_t value)
+  {
+    if(value < 2 * SubBuckets)
+      return value;
+
+    const auto shift = static_cast<std::size_t>(63 - std::countl_zero(value) - SubBucketBits);
+    const std::size_t subBucket = (value >> shift) - SubBuckets;
+    return 2 * SubBuckets + (shift - 1) * SubBuckets + subBucket;
+  }
+
+  std::uint64_t Histogram::BucketUpperBound(std::size_t index)
+  {
+    if(index < 2 * SubBuckets)
+      return index;
+
+    const auto shift = (index - 2 * SubBuckets) / SubBuckets + 1;
+    const auto top = std::uint64_t{(index - 2 * SubBuckets) % SubBuckets + SubBuckets};
+    return (top << shift) + ((std::uint64_t{1} << shift) - 1);
+  }
+
+  void Histogram::Record(Clock::duration duration)
+  {
+    const auto value = static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), 0));
+    ++m_counts[BucketIndex(value)];
+    ++m_count;
+    m_max = std::max(m_max, value);
+  }
+
+  void Histogram::Merge(const Histogram& other)
+  {
+    for(std::size_t i = 0; i < BucketCount; ++i)
+    {
+      m_counts[i] += other.m_counts[i];
+    }
+    m_count += other.m_count;
+    m_max = std::max(m_max, other.m_max);
+  }
+
+  Clock::duration Histogram::Percentile(double percentile) const
+  {
+    if(m_count == 0)
+      return {};
+
+    const auto rank = std::max<std::uint64_t>(
+      static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(m_count))), 1);
+    std::uint64_t seen = 0;
+    for(std::size_t i = 0; i < BucketCount; ++i)
+    {
+      seen += m_counts[i];
+      if(seen >= rank)
+        return std::chrono::nanoseconds(std::min(BucketUpperBound(i), m_max));
+    }
+    return Max();
+  }
+
+  TickProfile::TickProfile(std::string gameId, std::optional<std::string> dumpFile)
+    : m_gameId(std::move(gameId))
+    , m_dumpFile(std::move(dumpFile))
+  {
+  }
+
+  void TickProfile::FinishLevel(int level)
+  {
+    Report(level, m_level);
+    for(std::size_t phase = 0; phase < PhaseCount; ++phase)
+    {
+      m_game[phase].Merge(m_level[phase]);
+      m_level[phase].Reset();
+    }
+  }
+
+  void TickProfile::FinishGame() { Report(std::nullopt, m_game); }
+
+  void TickProfile::Report(std::optional<int> level, const Histograms& histograms) const
+  {
+    if(level)
+      logger.Info("Profile of level {} (us):", *level);
+    else
+      logger.Info("Profile of game {} (us):", m_gameId);
+    logger.Info("  {:<14} {:>8} {:>10} {:>10} {:>10} {:>10}", "phase", "count", "p50", "p90", "p99", "max");
+    for(std::size_t phase = 0; phase < PhaseCount; ++phase)
+    {
+      const auto& histogram = histograms[phase];
+      if(histogram.Count() == 0)
+        continue;
+
+      logger.Info(
+        "  {:<14} {:>8} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}",
+        PhaseNames[phase],
+        histogram.Count(),
+        Microseconds(histogram.Percentile(50)),
+        Microseconds(histogram.Percentile(90)),
+        Microseconds(histogram.Percentile(99)),
+        Microseconds(histogram.Max()));
+    }
+
+    if(!m_dumpFile)
+      return;
+
+    std::lock_guard lock(dumpMutex);
+    std::ofstream dump(*m_dumpFile, std::ios::app);
+    for(std::size_t phase = 0; phase < PhaseCount; ++phase)
+    {
+      const auto& histogram = histograms[phase];
+      if(histogram.Count() == 0)
+        continue;
+
+      std::println(
+        dump,
+        R"({{"game":"{}","level":{},"phase":"{}","count":{},"p50_us":{:.1f},"p90_us":{:.1f},"p99_us":{:.1f},"max_us":{:.1f}}})",
+        m_gameId,
+        level ? std::to_string(*level) : "null",
+        PhaseNames[phase],
+        histogram.Count(),
+        Microseconds(histogram.Percentile(50)),
+        Microseconds(histogram.Percentile(90)),
+        Microseconds(histogram.Percentile(99)),
+        Microseconds(histogram.Max()));
+    }
+  }
+
+} // namespace Bot::Profiling
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace Bot::Profiling
+{
+  // Set by the BOT_PROFILING CMake option. Without it, the timers compile to nothing.
+#ifdef BOT_PROFILING
+  constexpr bool Enabled = true;
+#else
+  constexpr bool Enabled = false;
+#endif
+
+  using Clock = std::chrono::steady_clock;
+
+  // Log-linear buckets, like HdrHistogram: nanoseconds are counted exactly up to 2 * SubBuckets, above that each power of
+  // two is split into SubBuckets buckets. So percentiles are accurate to within 1 / SubBuckets.
+  class Histogram
+  {
+  public:
+    static constexpr int SubBucketBits = 5;
+    static constexpr std::size_t SubBuckets = 1uz << SubBucketBits;
+    static constexpr std::size_t BucketCount = 2 * SubBuckets + (64 - SubBucketBits - 1) * SubBuckets;
+
+    void Record(Clock::duration duration);
+    void Merge(const Histogram& other);
+    void Reset() { *this = {}; }
+
+    std::uint64_t Count() const { return m_count; }
+    // The highest value in the bucket that holds the percentile, but at most Max()
+    Clock::duration Percentile(double percentile) const;
+    Clock::duration Max() const { return std::chrono::nanoseconds(m_max); }
+
+    static std::size_t BucketIndex(std::uint64_t value);
+    static std::uint64_t BucketUpperBound(std::size_t index);
+
+  private:
+    std::array<std::uint64_t, BucketCount> m_counts{};
+    std::uint64_t m_count = 0;
+    std::uint64_t m_max = 0;
+  };
+
+  enum class Phase : std::uint8_t
+  {
+    UpdateMap,
+    // With parallel planning, only the search of the player
+    UpdatePlan0,
+    UpdatePlan1,
+    // Calls to GameCallbacks. Finished is also counted in UpdatePlan.
+    Callbacks,
+    PrintMap,
+    Act,
+  };
+
+  constexpr std::array PhaseNames{"UpdateMap", "UpdatePlan(0)", "UpdatePlan(1)", "Callbacks", "PrintMap", "Act"};
+  constexpr std::size_t PhaseCount = PhaseNames.size();
+
+  constexpr Phase UpdatePlan(std::size_t playerId) { return playerId == 0 ? Phase::UpdatePlan0 : Phase::UpdatePlan1; }
+
+  // The phase histograms of a game. Each phase must be recorded by one thread at a time.
+  class TickProfile
+  {
+  public:
+    // With a dump file, the summaries are also appended to it as JSON lines
+    TickProfile(std::string gameId, std::optional<std::string> dumpFile);
+
+    void Record(Phase phase, Clock::duration duration) { m_level[static_cast<std::size_t>(phase)].Record(duration); }
+
+    // Prints the summary of the level, and adds it to the game
+    void FinishLevel(int level);
+    // Prints the summary of the whole game
+    void FinishGame();
+
+  private:
+    using Histograms = std::array<Histogram, PhaseCount>;
+
+    void Report(std::optional<int> level, const Histograms& histograms) const;
+
+    std::string m_gameId;
+    std::optional<std::string> m_dumpFile;
+    Histograms m_level;
+    Histograms m_game;
+  };
+
+  // Records the time until the end of the scope
+  class ScopedTimer
+  {
+  public:
+    ScopedTimer(TickProfile* profile, Phase phase)
+      : m_profile(profile)
+      , m_phase(phase)
+    {
+      if constexpr(Enabled)
+        m_start = Clock::now();
+    }
+
+    ~ScopedTimer()
+    {
+      if constexpr(Enabled)
+      {
+        if(m_profile)
+          m_profile->Record(m_phase, Clock::now() - m_start);
+      }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+  private:
+    TickProfile* m_profile;
+    Phase m_phase;
+    Clock::time_point m_start;
+  };
+
+} // namespace Bot::Profiling
@@ -0,0 +1,620 @@
+#include "Replay.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+
+namespace Swoq
+{
+
+  using namespace Swoq::Interface;
+
+  namespace
+  {
+    constexpr int TileBits = 5;
+    constexpr std::uint32_t TileMask = (1u << TileBits) - 1;
+
+    void write_delimited(google::protobuf::io::CodedOutputStream& output, const google::protobuf::Message& message)
+    {
+      output.WriteVarint32(static_cast<std::uint32_t>(message.ByteSizeLong()));
+      message.SerializeWithCachedSizes(&output);
+    }
+  } // namespace
+
+  ViewHistory::ViewHistory(int visibility)
+    : m_visibility(visibility)
+    , m_size(static_cast<std::size_t>((2 * visibility + 1) * (2 * visibility + 1)))
+  {
+  }
+
+  void ViewHistory::reset(const State& state)
+  {
+    m_views = {};
+    if(state.has_playerstate())
+      remember(0, state.playerstate());
+    if(state.has_player2state())
+      remember(1, state.player2state());
+  }
+
+  void ViewHistory::encode(const ActResponse& response, bool keyframe, Replay::ReplayResponse& compact)
+  {
+    compact.Clear();
+    compact.set_result(response.result());
+    if(!response.has_state())
+      return;
+
+    auto& state = *compact.mutable_state();
+    state = response.state();
+    forget_absent(state);
+    if(state.has_playerstate() && encode_view(0, *state.mutable_playerstate(), keyframe))
+    {
+      compact.mutable_view()->mutable_changes()->Add(m_changes.begin(), m_changes.end());
+    }
+    if(state.has_player2state() && encode_view(1, *state.mutable_player2state(), keyframe))
+    {
+      compact.mutable_view2()->mutable_changes()->Add(m_changes.begin(), m_changes.end());
+    }
+  }
+
+  std::expected<void, std::string> ViewHistory::decode(Replay::ReplayResponse& compact, ActResponse& response)
+  {
+    response.Clear();
+    response.set_result(compact.result());
+    if(!compact.has_state())
+      return {};
+
+    auto& state = *response.mutable_state();
+    state.Swap(compact.mutable_state());
+    forget_absent(state);
+    if(state.has_playerstate())
+    {
+      if(auto result = decode_view(0, *state.mutable_playerstate(), compact.has_view() ? &compact.view() : nullptr); !result)
+        return result;
+    }
+    if(state.has_player2state())
+    {
+      if(auto result = decode_view(1, *state.mutable_player2state(), compact.has_view2() ? &compact.view2() : nullptr); !result)
+        return result;
+    }
+    return {};
+  }
+
+  bool ViewHistory::encode_view(std::size_t player, PlayerState& state, bool keyframe)
+  {
+    const auto& previous = m_views[player];
+    bool delta = !keyframe && previous.valid && static_cast<std::size_t>(state.surroundings_size()) == m_size;
+    if(delta)
+    {
+      predict(previous, state.position());
+      m_changes.clear();
+      for(std::size_t i = 0; i < m_size && delta; ++i)
+      {
+        const auto tile = static_cast<std::uint32_t>(state.surroundings(static_cast<int>(i)));
+        delta = tile <= TileMask;
+        if(static_cast<int>(tile) != m_prediction[i])
+        {
+          m_changes.push_back(static_cast<std::uint32_t>(i) << TileBits | tile);
+        }
+      }
+    }
+
+    remember(player, state);
+    if(delta)
+    {
+      state.clear_surroundings();
+    }
+    return delta;
+  }
+
+  std::expected<void, std::string>
+    ViewHistory::decode_view(std::size_t player, PlayerState& state, const Replay::ViewDelta* delta)
+  {
+    if(delta)
+    {
+      const auto& previous = m_views[player];
+      if(!previous.valid)
+      {
+        return std::unexpected("View delta without a previous view");
+      }
+
+      predict(previous, state.position());
+      for(auto change: delta->changes())
+      {
+        const auto index = change >> TileBits;
+        if(index >= m_size)
+        {
+          return std::unexpected("View delta out of range");
+        }
+        m_prediction[index] = static_cast<int>(change & TileMask);
+      }
+      state.mutable_surroundings()->Add(m_prediction.begin(), m_prediction.end());
+    }
+
+    remember(player, state);
+    return {};
+  }
+
+  void ViewHistory::predict(const View& previous, const Position& position)
+  {
+    const int dimension = 2 * m_visibility + 1;
+    const int dx = position.x() - previous.x;
+    const int dy = position.y() - previous.y;
+
+    m_prediction.assign(m_size, Tile::TILE_UNKNOWN);
+    for(int y = std::max(0, -dy); y < std::min(dimension, dimension - dy); ++y)
+    {
+      for(int x = std::max(0, -dx); x < std::min(dimension, dimension - dx); ++x)
+      {
+        m_prediction[static_cast<std::size_t>(y * dimension + x)] =
+          previous.tiles[static_cast<std::size_t>((y + dy) * dimension + x + dx)];
+      }
+    }
+  }
+
+  // A player that reappears is encoded against an empty view, so seeking doesn't depend on the history before a keyframe
+  void ViewHistory::forget_absent(const State& state)
+  {
+    m_views[0].valid = m_views[0].valid && state.has_playerstate();
+    m_views[1].valid = m_views[1].valid && state.has_player2state();
+  }
+
+  void ViewHistory::remember(std::size_t player, const PlayerState& state)
+  {
+    auto& view = m_views[player];
+    view.valid = static_cast<std::size_t>(state.surroundings_size()) == m_size;
+    view.x = state.position().x();
+    view.y = state.position().y();
+    view.tiles.assign(state.surroundings().begin(), state.surroundings().end());
+  }
+
+  std::expected<MappedFile, std::string> MappedFile::open(const fs::path& path, bool sequential)
+  {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+      return std::unexpected(std::format("Failed to open {}: {}", path.string(), std::strerror(errno)));
+    }
+
+    struct stat status{};
+    if(fstat(fd, &status) != 0)
+    {
+      const int error = errno;
+      close(fd);
+      return std::unexpected(std::format("Failed to stat {}: {}", path.string(), std::strerror(error)));
+    }
+
+    const auto size = static_cast<std::size_t>(status.st_size);
+    if(size == 0)
+    {
+      close(fd);
+      return std::unexpected(std::format("{} is empty", path.string()));
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int error = errno;
+    close(fd);
+    if(data == MAP_FAILED)
+    {
+      return std::unexpected(std::format("Failed to map {}: {}", path.string(), std::strerror(error)));
+    }
+    madvise(data, size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+    return MappedFile(std::span(static_cast<const std::uint8_t*>(data), size));
+  }
+
+  MappedFile::MappedFile(std::span<const std::uint8_t> bytes)
+    : m_bytes(bytes)
+  {
+  }
+
+  MappedFile::~MappedFile()
+  {
+    if(!m_bytes.empty())
+    {
+      // munmap doesn't take a pointer to const
+      munmap(const_cast<std::uint8_t*>(m_bytes.data()), m_bytes.size());
+    }
+  }
+
+  MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_bytes(std::exchange(other.m_bytes, {}))
+  {
+  }
+
+  MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+  {
+    std::swap(m_bytes, other.m_bytes);
+    return *this;
+  }
+
+  std::expected<std::unique_ptr<ReplayReader>, std::string> ReplayReader::open(const fs::path& path)
+  {
+    auto file = MappedFile::open(path, true);
+    if(!file)
+    {
+      return std::unexpected(file.error());
+    }
+
+    // The index is optional
+    auto index = MappedFile::open(replay_index_path(path), false);
+
+    auto reader = std::make_unique<ReplayReader>(std::move(*file), index ? std::move(*index) : MappedFile{});
+    if(auto result = reader->read_start(); !result)
+    {
+      return std::unexpected(std::format("Failed to read {}: {}", path.string(), result.error()));
+    }
+    return reader;
+  }
+
+  ReplayReader::ReplayReader(MappedFile file, MappedFile index)
+    : m_file(std::move(file))
+    , m_index(std::move(index))
+    , m_mapping(m_file.bytes())
+  {
+    read_index();
+  }
+
+  void ReplayReader::read_index()
+  {
+    const auto bytes = m_index.bytes();
+    if(
+      bytes.size() < ReplayIndexMagic.size()
+      || std::memcmp(bytes.data(), ReplayIndexMagic.data(), ReplayIndexMagic.size()) != 0)
+    {
+      return;
+    }
+
+    // A crash may leave a partial entry at the end. The mapping is page aligned, and the magic is as large as an entry.
+    const auto count = (bytes.size() - ReplayIndexMagic.size()) / sizeof(ReplayIndexEntry);
+    m_entries = {reinterpret_cast<const ReplayIndexEntry*>(bytes.data() + ReplayIndexMagic.size()), count};
+
+    const auto valid = std::ranges::find_if(m_entries, [&](const auto& entry) { return entry.offset >= m_mapping.size(); });
+    m_entries = m_entries.first(static_cast<std::size_t>(valid - m_entries.begin()));
+  }
+
+  std::expected<void, std::string> ReplayReader::seek_tick(int tick)
+  {
+    return seek(std::ranges::find(m_entries, tick, &ReplayIndexEntry::tick));
+  }
+
+  std::expected<void, std::string> ReplayReader::seek_level(int level)
+  {
+    return seek(std::ranges::find(m_entries, level, &ReplayIndexEntry::level));
+  }
+
+  std::expected<void, std::string> ReplayReader::seek(std::span<const ReplayIndexEntry>::iterator target)
+  {
+    if(target == m_entries.end())
+    {
+      return std::unexpected(m_entries.empty() ? "Replay has no index" : "Not in the index");
+    }
+
+    m_truncated = false;
+    if(m_format == ReplayFormat::V1)
+    {
+      m_offset = target->offset;
+      return {};
+    }
+
+    // View deltas need the views before them, so decode from the last keyframe, or from the start
+    auto keyframe = target;
+    while(keyframe != m_entries.begin() && !keyframe->keyframe)
+    {
+      --keyframe;
+    }
+    if(keyframe->keyframe)
+    {
+      m_views->reset({});
+    }
+    else
+    {
+      m_views->reset(m_start_response.state());
+    }
+
+    m_offset = keyframe->offset;
+    ActRequest request;
+    ActResponse response;
+    for(; keyframe != target; ++keyframe)
+    {
+      if(auto next = this->next(request, response); !next || !*next)
+      {
+        return std::unexpected("Failed to read up to the seek target");
+      }
+    }
+    return {};
+  }
+
+  std::optional<std::span<const std::uint8_t>> ReplayReader::next_record()
+  {
+    if(m_offset == m_mapping.size())
+    {
+      return std::nullopt;
+    }
+
+    auto size = read_varint32();
+    if(!size || *size > m_mapping.size() - m_offset)
+    {
+      m_offset = m_mapping.size();
+      m_truncated = true;
+      return std::nullopt;
+    }
+
+    auto record = m_mapping.subspan(m_offset, *size);
+    m_offset += *size;
+    return record;
+  }
+
+  std::expected<bool, std::string> ReplayReader::next(ActRequest& request, ActResponse& response)
+  {
+    auto request_record = next_record();
+    if(!request_record)
+    {
+      return false;
+    }
+    auto response_record = next_record();
+    if(!response_record)
+    {
+      // The request was sent, but the response never made it to disk
+      m_truncated = true;
+      return false;
+    }
+
+    if(!request.ParseFromArray(request_record->data(), static_cast<int>(request_record->size())))
+    {
+      return std::unexpected("Failed to parse ActRequest");
+    }
+    if(m_format == ReplayFormat::V1)
+    {
+      if(!response.ParseFromArray(response_record->data(), static_cast<int>(response_record->size())))
+      {
+        return std::unexpected("Failed to parse ActResponse");
+      }
+      return true;
+    }
+
+    if(request.gameid().empty())
+    {
+      request.set_gameid(m_start_response.gameid());
+    }
+    if(!m_compact.ParseFromArray(response_record->data(), static_cast<int>(response_record->size())))
+    {
+      return std::unexpected("Failed to parse ReplayResponse");
+    }
+    if(auto decoded = m_views->decode(m_compact, response); !decoded)
+    {
+      return std::unexpected(decoded.error());
+    }
+    return true;
+  }
+
+  std::expected<void, std::string> ReplayReader::read_start()
+  {
+    if(
+      m_mapping.size() >= ReplayMagicV2.size()
+      && std::memcmp(m_mapping.data(), ReplayMagicV2.data(), ReplayMagicV2.size()) == 0)
+    {
+      m_format = ReplayFormat::V2;
+      m_offset = ReplayMagicV2.size();
+    }
+
+    auto request_record = next_record();
+    if(!request_record || !m_start_request.ParseFromArray(request_record->data(), static_cast<int>(request_record->size())))
+    {
+      return std::unexpected("Failed to parse StartRequest");
+    }
+    auto response_record = next_record();
+    if(!response_record || !m_start_response.ParseFromArray(response_record->data(), static_cast<int>(response_record->size())))
+    {
+      return std::unexpected("Failed to parse StartResponse");
+    }
+
+    if(m_format == ReplayFormat::V2)
+    {
+      m_views.emplace(m_start_response.visibilityrange());
+      m_views->reset(m_start_response.state());
+    }
+    return {};
+  }
+
+  std::optional<std::uint32_t> ReplayReader::read_varint32()
+  {
+    std::uint32_t value = 0;
+    for(int shift = 0; shift < 35; shift += 7)
+    {
+      if(m_offset == m_mapping.size())
+      {
+        return std::nullopt;
+      }
+      const auto byte = m_mapping[m_offset++];
+      value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+      if((byte & 0x80) == 0)
+      {
+        return value;
+      }
+    }
+    return std::nullopt;
+  }
+
+  std::expected<void, std::string>
+    convert_replay(const fs::path& from, const fs::path& to, ReplayFormat format, int keyframe_interval)
+  {
+    auto reader = ReplayReader::open(from);
+    if(!reader)
+    {
+      return std::unexpected(reader.error());
+    }
+
+    std::ofstream stream(to, std::ios::binary | std::ios::out);
+    if(!stream.is_open())
+    {
+      return std::unexpected(std::format("Failed to open {}", to.string()));
+    }
+
+    std::vector<ReplayIndexEntry> entries;
+
+    {
+      google::protobuf::io::OstreamOutputStream zero_copy_output(&stream);
+      google::protobuf::io::CodedOutputStream output(&zero_copy_output);
+      if(format == ReplayFormat::V2)
+      {
+        output.WriteRaw(ReplayMagicV2.data(), static_cast<int>(ReplayMagicV2.size()));
+      }
+
+      const auto& start_response = (*reader)->start_response();
+      write_delimited(output, (*reader)->start_request());
+      write_delimited(output, start_response);
+
+      ViewHistory views(start_response.visibilityrange());
+      views.reset(start_response.state());
+      int tick = start_response.state().tick();
+      int level = start_response.state().level();
+
+      ActRequest request;
+      ActResponse response;
+      Replay::ReplayResponse compact;
+      for(int acts = 1;; ++acts)
+      {
+        auto next = (*reader)->next(request, response);
+        if(!next)
+        {
+          return std::unexpected(next.error());
+        }
+        if(!*next)
+        {
+          break;
+        }
+
+        const bool new_level = response.has_state() && response.state().level() != level;
+        if(response.has_state())
+        {
+          tick = response.state().tick();
+          level = response.state().level();
+        }
+        auto& entry = entries.emplace_back(ReplayIndexEntry{
+          .offset = static_cast<std::uint64_t>(output.ByteCount()),
+          .tick = tick,
+          .level = static_cast<std::int16_t>(level),
+        });
+
+        if(format == ReplayFormat::V1)
+        {
+          write_delimited(output, request);
+          write_delimited(output, response);
+          continue;
+        }
+
+        if(request.gameid() == start_response.gameid())
+        {
+          request.clear_gameid();
+        }
+        write_delimited(output, request);
+
+        const bool keyframe = new_level || (keyframe_interval > 0 && acts % keyframe_interval == 0);
+        entry.keyframe = keyframe && response.has_state() ? 1 : 0;
+        views.encode(response, keyframe, compact);
+        write_delimited(output, compact);
+      }
+    }
+
+    std::ofstream index(replay_index_path(to), std::ios::binary | std::ios::out);
+    index.write(ReplayIndexMagic.data(), static_cast<std::streamsize>(ReplayIndexMagic.size()));
+    index.write(
+      reinterpret_cast<const char*>(entries.data()),
+      static_cast<std::streamsize>(entries.size() * sizeof(ReplayIndexEntry)));
+    index.close();
+
+    stream.close();
+    if(!stream || !index)
+    {
+      return std::unexpected(std::format("Failed to write {}", to.string()));
+    }
+    return {};
+  }
+
+  std::expected<std::unique_ptr<ReplayGame>, std::string> ReplayGame::open(const fs::path& path)
+  {
+    auto reader = ReplayReader::open(path);
+    if(!reader)
+    {
+      return std::unexpected(reader.error());
+    }
+    return std::make_unique<ReplayGame>(std::move(*reader));
+  }
+
+  ReplayGame::ReplayGame(std::unique_ptr<ReplayReader> reader)
+    : m_reader(std::move(reader))
+    , m_state(m_reader->start_response().state())
+  {
+  }
+
+  const std::string& ReplayGame::game_id() const { return m_reader->start_response().gameid(); }
+  int ReplayGame::map_width() const { return m_reader->start_response().mapwidth(); }
+  int ReplayGame::map_height() const { return m_reader->start_response().mapheight(); }
+  int ReplayGame::visibility_range() const { return m_reader->start_response().visibilityrange(); }
+  int ReplayGame::seed() const { return m_reader->start_response().seed(); }
+  const State& ReplayGame::state() const { return m_state; }
+
+  std::expected<void, std::string> ReplayGame::act(std::optional<DirectedAction> action0, std::optional<DirectedAction> action1)
+  {
+    auto next = m_reader->next(m_request, m_response);
+    if(!next)
+    {
+      return std::unexpected(next.error());
+    }
+    if(!*next)
+    {
+      return std::unexpected(std::format("Replay ended after {} ticks", m_ticks));
+    }
+
+    ++m_ticks;
+    if(action0.value_or(DirectedAction::DIRECTED_ACTION_NONE) != m_request.action()
+       || action1.value_or(DirectedAction::DIRECTED_ACTION_NONE) != m_request.action2())
+    {
+      ++m_divergences;
+    }
+
+    if(m_response.result() != ActResult::ACT_RESULT_OK)
+    {
+      return std::unexpected(std::format("Act failed (result {})", m_response.result()));
+    }
+    m_state.Swap(m_response.mutable_state());
+    return {};
+  }
+
+  std::expected<void, std::string>
+    ReplayGame::act_start(std::optional<DirectedAction> action0, std::optional<DirectedAction> action1)
+  {
+    if(m_pending_act)
+    {
+      return std::unexpected("Act already in flight");
+    }
+
+    m_pending_act.emplace(action0, action1);
+    return {};
+  }
+
+  std::expected<void, std::string> ReplayGame::act_finish()
+  {
+    if(!m_pending_act)
+    {
+      return std::unexpected("No act in flight");
+    }
+
+    auto [action0, action1] = *m_pending_act;
+    m_pending_act.reset();
+    return act(action0, action1);
+  }
+
+  bool ReplayGame::act_in_flight() const { return m_pending_act.has_value(); }
+
+} // namespace Swoq
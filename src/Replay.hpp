@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Replay.pb.h"
+#include "Swoq.hpp"
+
+namespace Swoq
+{
+
+  namespace fs = std::filesystem;
+
+  enum class ReplayFormat : std::uint8_t
+  {
+    // Length-delimited messages, as written by ReplayFile
+    V1,
+    // Starts with ReplayMagicV2, then the same records, except that act responses are ReplayResponses (Replay.proto)
+    V2,
+  };
+
+  // v1 files start with the size of the StartRequest instead
+  inline constexpr std::string_view ReplayMagicV2 = "SWOQ-REPLAY-2\n";
+  constexpr int DefaultKeyframeInterval = 100;
+
+  // The last view of each player, which v2 view deltas are relative to
+  class ViewHistory
+  {
+  public:
+    explicit ViewHistory(int visibility);
+
+    void reset(const Interface::State& state);
+    // A keyframe keeps the full surroundings
+    void encode(const Interface::ActResponse& response, bool keyframe, Replay::ReplayResponse& compact);
+    std::expected<void, std::string> decode(Replay::ReplayResponse& compact, Interface::ActResponse& response);
+
+  private:
+    struct View
+    {
+      bool valid = false;
+      int x = 0;
+      int y = 0;
+      std::vector<int> tiles;
+    };
+
+    bool encode_view(std::size_t player, Interface::PlayerState& state, bool keyframe);
+    std::expected<void, std::string>
+      decode_view(std::size_t player, Interface::PlayerState& state, const Replay::ViewDelta* delta);
+    void predict(const View& previous, const Interface::Position& position);
+    void forget_absent(const Interface::State& state);
+    void remember(std::size_t player, const Interface::PlayerState& state);
+
+    int m_visibility;
+    std::size_t m_size;
+    std::array<View, 2> m_views;
+    std::vector<int> m_prediction;
+    std::vector<std::uint32_t> m_changes;
+  };
+
+  // A read-only memory mapping of a whole file
+  class MappedFile
+  {
+  public:
+    static std::expected<MappedFile, std::string> open(const fs::path& path, bool sequential);
+
+    MappedFile() = default;
+    explicit MappedFile(std::span<const std::uint8_t> bytes);
+    ~MappedFile();
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    std::span<const std::uint8_t> bytes() const { return m_bytes; }
+
+  private:
+    std::span<const std::uint8_t> m_bytes;
+  };
+
+  // Iterates the records of a replay straight from a memory mapped file, in either format. A record cut short by a
+  // crashed writer ends the replay, and is reported by truncated(). When the replay has an index next to it, the reader
+  // can seek to any tick or level.
+  class ReplayReader
+  {
+  public:
+    static std::expected<std::unique_ptr<ReplayReader>, std::string> open(const fs::path& path);
+
+    explicit ReplayReader(MappedFile file, MappedFile index = {});
+    ReplayReader(const ReplayReader&) = delete;
+    ReplayReader& operator=(const ReplayReader&) = delete;
+
+    const Interface::StartRequest& start_request() const { return m_start_request; }
+    const Interface::StartResponse& start_response() const { return m_start_response; }
+
+    // The serialized bytes of the next record, pointing into the mapping
+    std::optional<std::span<const std::uint8_t>> next_record();
+
+    // Parses the next act into the given messages, so their memory is reused. Returns false at the end of the replay.
+    std::expected<bool, std::string> next(Interface::ActRequest& request, Interface::ActResponse& response);
+
+    bool truncated() const { return m_truncated; }
+    ReplayFormat format() const { return m_format; }
+
+    // Empty without an index. Entries that point past the end of a truncated replay are left out.
+    std::span<const ReplayIndexEntry> index() const { return m_entries; }
+    // Afterwards next() returns the first act that resulted in the given tick
+    std::expected<void, std::string> seek_tick(int tick);
+    // Afterwards next() returns the first act on the given level
+    std::expected<void, std::string> seek_level(int level);
+
+  private:
+    std::expected<void, std::string> read_start();
+    void read_index();
+    std::expected<void, std::string> seek(std::span<const ReplayIndexEntry>::iterator target);
+    std::optional<std::uint32_t> read_varint32();
+
+    MappedFile m_file;
+    MappedFile m_index;
+    std::span<const std::uint8_t> m_mapping;
+    std::span<const ReplayIndexEntry> m_entries;
+    std::size_t m_offset = 0;
+    bool m_truncated = false;
+    ReplayFormat m_format = ReplayFormat::V1;
+    Interface::StartRequest m_start_request;
+    Interface::StartResponse m_start_response;
+    std::optional<ViewHistory> m_views;
+    Replay::ReplayResponse m_compact;
+  };
+
+  // Rewrites a replay in the given format. V2 writes a keyframe every keyframe_interval acts, and at every new level.
+  std::expected<void, std::string> convert_replay(
+    const fs::path& from,
+    const fs::path& to,
+    ReplayFormat format,
+    int keyframe_interval = DefaultKeyframeInterval);
+
+  // Plays back a recorded game. The actions passed to act() are ignored, the state simply advances to the next recorded
+  // response. This runs the bot's map updates and planning without a server.
+  class ReplayGame final : public Game
+  {
+  public:
+    static std::expected<std::unique_ptr<ReplayGame>, std::string> open(const fs::path& path);
+
+    explicit ReplayGame(std::unique_ptr<ReplayReader> reader);
+
+    const std::string& game_id() const override;
+    int map_width() const override;
+    int map_height() const override;
+    int visibility_range() const override;
+    int seed() const override;
+    const Swoq::Interface::State& state() const override;
+
+    std::expected<void, std::string>
+      act(std::optional<Interface::DirectedAction> action0, std::optional<Interface::DirectedAction> action1) override;
+    std::expected<void, std::string>
+      act_start(std::optional<Interface::DirectedAction> action0, std::optional<Interface::DirectedAction> action1) override;
+    std::expected<void, std::string> act_finish() override;
+    bool act_in_flight() const override;
+
+    const ReplayReader& reader() const { return *m_reader; }
+    int ticks() const { return m_ticks; }
+    // Acts where the bot chose differently than the recording
+    int divergences() const { return m_divergences; }
+
+  private:
+    std::unique_ptr<ReplayReader> m_reader;
+    Interface::State m_state;
+    Interface::ActRequest m_request;
+    Interface::ActResponse m_response;
+    std::optional<std::pair<std::optional<Interface::DirectedAction>, std::optional<Interface::DirectedAction>>> m_pending_act;
+    int m_ticks = 0;
+    int m_divergences = 0;
+  };
+
+} // namespace Swoq
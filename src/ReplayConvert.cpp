@@ -0,0 +1,24 @@
+#include <print>
+#include <span>
+#include <string_view>
+
+#include "Replay.hpp"
+
+// Converts a replay between formats: replay_convert <v1|v2> <input> <output>
+int main(int argc, char** argv)
+{
+  const std::span args(argv, static_cast<std::size_t>(argc));
+  if(args.size() != 4 || (std::string_view(args[1]) != "v1" && std::string_view(args[1]) != "v2"))
+  {
+    std::println("Usage: replay_convert <v1|v2> <input> <output>");
+    return -1;
+  }
+
+  const auto format = std::string_view(args[1]) == "v1" ? Swoq::ReplayFormat::V1 : Swoq::ReplayFormat::V2;
+  if(auto converted = Swoq::convert_replay(args[2], args[3], format); !converted)
+  {
+    std::println("Failed to convert {}: {}", args[2], converted.error());
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,170 @@
+#include "Runner.h"
+
+#include <algorithm>
+#include <numeric>
+#include <ranges>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "Formatters.h"
+#include "Game.h"
+#include "Logging.h"
+#include "TaskPool.h"
+
+namespace Bot
+{
+  namespace
+  {
+    constexpr Log::Logger<Log::Category::Runner> logger;
+
+    void PinCurrentThread(std::size_t workerIndex)
+    {
+      const std::size_t cpus = std::max(std::thread::hardware_concurrency(), 1u);
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(workerIndex % cpus, &set);
+      if(int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); error != 0)
+      {
+        logger.Warning("Runner: Failed to pin worker {} (error {})", workerIndex, error);
+      }
+    }
+  } // namespace
+
+  Runner::Runner(const Swoq::GameConnection& connection, RunnerOptions options)
+    : m_connection(connection)
+    , m_options(std::move(options))
+  {
+    m_options.concurrency = std::clamp<std::size_t>(m_options.concurrency, 1, std::max<std::size_t>(m_options.games, 1));
+    if(!m_options.options.taskPool)
+    {
+      m_options.options.taskPool = TaskPool::Shared();
+    }
+  }
+
+  std::vector<GameResult> Runner::Run()
+  {
+    m_results.assign(m_options.games, GameResult{});
+    m_nextGame = 0;
+
+    {
+      std::vector<std::jthread> workers;
+      for(std::size_t i = 0; i < m_options.concurrency; ++i)
+      {
+        workers.emplace_back([this, i] { Worker(i); });
+      }
+    }
+
+    return std::move(m_results);
+  }
+
+  void Runner::Worker(std::size_t workerIndex)
+  {
+    if(m_options.pinThreads)
+    {
+      PinCurrentThread(workerIndex);
+    }
+
+    for(std::size_t index = m_nextGame++; index < m_options.games; index = m_nextGame++)
+    {
+      const Log::GameScope scope(index);
+      m_results[index] = Play(index);
+      const auto& result = m_results[index];
+      logger.Info(
+        "Runner: Game {} ({}) {} at level {} after {}{}",
+        index,
+        result.gameId,
+        result.success ? "succeeded" : "failed",
+        result.level,
+        result.duration,
+        result.success ? "" : std::format(": {}", result.error));
+    }
+  }
+
+  GameResult Runner::Play(std::size_t index)
+  {
+    GameResult result = PlayGame(m_connection, m_options.level, m_options.seed, m_options.expectedLevel, m_options.options);
+    result.index = index;
+    return result;
+  }
+
+  GameResult PlayGame(
+    const Swoq::GameConnection& connection,
+    std::optional<int> level,
+    std::optional<int> seed,
+    std::optional<int> expectedLevel,
+    const Options& options)
+  {
+    GameResult result;
+    const auto start = std::chrono::steady_clock::now();
+
+    auto game = connection.start(level, seed);
+    if(!game)
+    {
+      result.error = game.error();
+    }
+    else
+    {
+      result.gameId = (*game)->game_id();
+      result.seed = (*game)->seed();
+      logger.Info("Runner: Started game {} with seed {}", result.gameId, result.seed);
+
+      Game botGame(std::move(*game), expectedLevel, options);
+      auto played = botGame.Run();
+      result.level = botGame.Level();
+      result.success = played.has_value();
+      if(!played)
+      {
+        result.error = played.error();
+      }
+    }
+
+    result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    return result;
+  }
+
+  RunnerSummary Summarize(std::span<const GameResult> results, std::chrono::milliseconds wallClock)
+  {
+    RunnerSummary summary;
+    summary.games = results.size();
+    summary.wallClock = wallClock;
+    if(results.empty())
+    {
+      return summary;
+    }
+
+    summary.successes = static_cast<std::size_t>(std::ranges::count_if(results, &GameResult::success));
+    for(const auto& result: results)
+    {
+      ++summary.levelsReached[result.level];
+    }
+
+    auto [fastest, slowest] = std::ranges::minmax(results | std::views::transform(&GameResult::duration));
+    summary.fastest = fastest;
+    summary.slowest = slowest;
+
+    auto total = std::accumulate(
+      results.begin(),
+      results.end(),
+      std::chrono::milliseconds{0},
+      [](auto sum, const GameResult& result) { return sum + result.duration; });
+    summary.mean = total / static_cast<std::chrono::milliseconds::rep>(results.size());
+
+    if(wallClock.count() > 0)
+    {
+      summary.gamesPerHour = static_cast<double>(results.size()) * std::chrono::duration<double>(std::chrono::hours(1))
+                           / std::chrono::duration<double>(wallClock);
+    }
+    return summary;
+  }
+
+  void PrintSummary(const RunnerSummary& summary)
+  {
+    logger.Info("Runner: {} of {} games succeeded", summary.successes, summary.games);
+    logger.Info("- levels reached: {}", summary.levelsReached);
+    logger.Info("- game duration: fastest {}, mean {}, slowest {}", summary.fastest, summary.mean, summary.slowest);
+    logger.Info("- wall clock: {} ({:.0f} games per hour)", summary.wallClock, summary.gamesPerHour);
+  }
+
+} // namespace Bot
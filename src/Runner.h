@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Options.h"
+#include "Swoq.hpp"
+
+namespace Bot
+{
+  struct RunnerOptions
+  {
+    std::size_t games = 1;
+    std::size_t concurrency = 1;
+    // Pin worker i to CPU i modulo the number of CPUs
+    bool pinThreads = false;
+    std::optional<int> level;
+    std::optional<int> seed;
+    std::optional<int> expectedLevel;
+    Options options;
+  };
+
+  struct GameResult
+  {
+    std::size_t index = 0;
+    std::string gameId;
+    int seed = 0;
+    int level = 0;
+    bool success = false;
+    std::string error;
+    std::chrono::milliseconds duration{0};
+  };
+
+  struct RunnerSummary
+  {
+    std::size_t games = 0;
+    std::size_t successes = 0;
+    std::map<int, std::size_t> levelsReached;
+    std::chrono::milliseconds fastest{0};
+    std::chrono::milliseconds slowest{0};
+    std::chrono::milliseconds mean{0};
+    std::chrono::milliseconds wallClock{0};
+    double gamesPerHour = 0.0;
+  };
+
+  // Plays many games in this process. All games share the connection's gRPC channel and completion queue
+  // driver, and the task pool in the options.
+  class Runner
+  {
+  public:
+    Runner(const Swoq::GameConnection& connection, RunnerOptions options);
+
+    std::vector<GameResult> Run();
+
+  private:
+    GameResult Play(std::size_t index);
+    void Worker(std::size_t workerIndex);
+
+    Swoq::GameConnection m_connection;
+    RunnerOptions m_options;
+    std::atomic<std::size_t> m_nextGame = 0;
+    // Every worker only writes the entries of the games it played
+    std::vector<GameResult> m_results;
+  };
+
+  GameResult PlayGame(
+    const Swoq::GameConnection& connection,
+    std::optional<int> level,
+    std::optional<int> seed,
+    std::optional<int> expectedLevel,
+    const Options& options);
+
+  RunnerSummary Summarize(std::span<const GameResult> results, std::chrono::milliseconds wallClock);
+  void PrintSummary(const RunnerSummary& summary);
+
+} // namespace Bot
@@ -0,0 +1,94 @@
+#include "SearchStats.h"
+
+#include <algorithm>
+#include <fstream>
+#include <print>
+
+#include "Logging.h"
+
+namespace Bot::SearchStats
+{
+  namespace
+  {
+    constexpr Log::Logger<Log::Category::Profiling> logger;
+  } // namespace
+
+  void Stats::Record(std::string_view caller, const Search& search, Offset mapSize)
+  {
+    std::lock_guard lock(m_mutex);
+    auto& totals = m_totals[caller.empty() ? "(unknown)" : caller];
+    ++totals.calls;
+    ++totals.exits[static_cast<std::size_t>(search.exit)];
+    totals.popped += search.popped;
+    totals.relaxations += search.relaxations;
+    totals.maxPopped = std::max(totals.maxPopped, search.popped);
+    totals.maxQueue = std::max(totals.maxQueue, search.queueHighWater);
+
+    if(search.expanded.empty())
+      return;
+
+    if(m_heatmap.Size() != mapSize)
+      m_heatmap = Vector2d<std::uint32_t>(mapSize.x, mapSize.y);
+    for(auto cell: search.expanded)
+    {
+      ++m_heatmap[cell];
+    }
+  }
+
+  bool Stats::WriteHeatmap(const std::filesystem::path& path) const
+  {
+    std::lock_guard lock(m_mutex);
+    std::ofstream stream(path);
+    for(int y = 0; y < m_heatmap.Height(); ++y)
+    {
+      for(int x = 0; x < m_heatmap.Width(); ++x)
+      {
+        std::print(stream, "{}{}", x == 0 ? "" : ",", m_heatmap[Offset(x, y)]);
+      }
+      std::println(stream, "");
+    }
+    return static_cast<bool>(stream);
+  }
+
+  std::map<std::string_view, CallerTotals> Stats::Totals() const
+  {
+    std::lock_guard lock(m_mutex);
+    return m_totals;
+  }
+
+  void Stats::Print() const
+  {
+    const auto snapshot = Totals();
+    logger.Info(
+      "  {:<28} {:>7} {:>7} {:>7} {:>10} {:>10} {:>8} {:>8}",
+      "caller",
+      "calls",
+      "found",
+      "flooded",
+      "popped",
+      "relaxed",
+      "max pop",
+      "max q");
+    for(const auto& [caller, counts]: snapshot)
+    {
+      logger.Info(
+        "  {:<28} {:>7} {:>7} {:>7} {:>10} {:>10} {:>8} {:>8}",
+        caller,
+        counts.calls,
+        counts.exits[static_cast<std::size_t>(Exit::Destination)],
+        counts.exits[static_cast<std::size_t>(Exit::Exhausted)],
+        counts.popped,
+        counts.relaxations,
+        counts.maxPopped,
+        counts.maxQueue);
+    }
+  }
+
+  void Stats::Reset()
+  {
+    std::lock_guard lock(m_mutex);
+    m_totals.clear();
+    m_heatmap = {};
+  }
+
+} // namespace Bot::SearchStats
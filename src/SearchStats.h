@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "Offset.h"
+#include "Profiling.h"
+#include "Vector2d.h"
+
+// Counts the effort of every DistanceMap search, per caller. Like the phase timers, this only exists with BOT_PROFILING.
+// Each game owns its counts, and passes them to the searches it runs along with the name of the caller.
+namespace Bot::SearchStats
+{
+  enum class Exit : std::uint8_t
+  {
+    // Found a cell that matched the predicate
+    Destination,
+    // Visited everything reachable
+    Exhausted,
+  };
+
+  struct Search
+  {
+    std::size_t popped = 0;
+    std::size_t relaxations = 0;
+    std::size_t queueHighWater = 0;
+    Exit exit = Exit::Exhausted;
+    // The popped cells, only with the heatmap enabled
+    std::vector<Offset> expanded;
+  };
+
+  struct CallerTotals
+  {
+    std::size_t calls = 0;
+    // Indexed by Exit
+    std::array<std::size_t, 2> exits{};
+    std::size_t popped = 0;
+    std::size_t relaxations = 0;
+    std::size_t maxPopped = 0;
+    std::size_t maxQueue = 0;
+  };
+
+  // The counts of one game. Both players search at the same time, so recording is thread safe.
+  class Stats
+  {
+  public:
+    explicit Stats(bool heatmap = false)
+      : m_heatmapEnabled(heatmap)
+    {
+    }
+
+    // Counts per cell how often a search popped it. The heatmap restarts when the map size changes.
+    [[nodiscard]] bool HeatmapEnabled() const { return m_heatmapEnabled; }
+
+    void Record(std::string_view caller, const Search& search, Offset mapSize);
+    bool WriteHeatmap(const std::filesystem::path& path) const;
+
+    std::map<std::string_view, CallerTotals> Totals() const;
+    void Print() const;
+    void Reset();
+
+  private:
+    const bool m_heatmapEnabled;
+    mutable std::mutex m_mutex;
+    std::map<std::string_view, CallerTotals> m_totals;
+    Vector2d<std::uint32_t> m_heatmap;
+  };
+
+  // Where a search is counted. Without stats, it isn't.
+  struct Caller
+  {
+    Stats* stats = nullptr;
+    std::string_view name;
+  };
+
+  // Names the searches made through slot until the end of the scope. caller must be a literal. The outermost scope
+  // wins, so a command that works through another one, like HuntEnemies through Visit, is counted as itself.
+  class Scope
+  {
+  public:
+    Scope(std::string_view& slot, std::string_view caller)
+      : m_slot(slot)
+    {
+      if constexpr(Profiling::Enabled)
+      {
+        m_outermost = m_slot.empty();
+        if(m_outermost)
+          m_slot = caller;
+      }
+    }
+
+    ~Scope()
+    {
+      if constexpr(Profiling::Enabled)
+      {
+        if(m_outermost)
+          m_slot = {};
+      }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    std::string_view& m_slot;
+    bool m_outermost = false;
+  };
+
+} // namespace Bot::SearchStats
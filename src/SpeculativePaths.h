@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "Metrics.h"
+#include "Offset.h"
+
+namespace Bot
+{
+  class PlayerMap;
+
+  // Paths planned while the previous act was in flight, one per player. A path only depends on the map, the start
+  // position and the command, so it is handed out only when none of these changed since it was planned.
+  class SpeculativePaths
+  {
+  public:
+    using MapPtr = std::shared_ptr<const PlayerMap>;
+
+    void Store(std::size_t playerId, MapPtr map, Offset start, std::uint64_t commandSerial, std::vector<Offset> reversedPath)
+    {
+      m_paths[playerId] = Path{std::move(map), start, commandSerial, std::move(reversedPath)};
+    }
+
+    // The stored path is gone afterwards, also when it could not be used
+    std::optional<std::vector<Offset>> Take(std::size_t playerId, const MapPtr& map, Offset position, std::uint64_t commandSerial)
+    {
+      auto path = std::exchange(m_paths[playerId], std::nullopt);
+      if(!path)
+        return std::nullopt;
+
+      if(path->map != map || path->start != position || path->commandSerial != commandSerial)
+      {
+        ++m_discarded;
+        Metrics::CountSpeculativePath(false);
+        return std::nullopt;
+      }
+
+      ++m_used;
+      Metrics::CountSpeculativePath(true);
+      return std::move(path->reversedPath);
+    }
+
+    void Clear() { m_paths = {}; }
+
+    [[nodiscard]] std::size_t Used() const { return m_used.load(); }
+    [[nodiscard]] std::size_t Discarded() const { return m_discarded.load(); }
+
+  private:
+    struct Path
+    {
+      MapPtr map;
+      Offset start;
+      std::uint64_t commandSerial = 0;
+      std::vector<Offset> reversedPath;
+    };
+
+    std::array<std::optional<Path>, 2> m_paths;
+    std::atomic<std::size_t> m_used = 0;
+    std::atomic<std::size_t> m_discarded = 0;
+  };
+
+} // namespace Bot
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace Bot
+{
+  // Bounded single-producer/single-consumer queue. Head and tail are ever-increasing sequence numbers, so
+  // neither side ever takes a lock and the consumer can tell how many items were ever published.
+  template <typename T, std::size_t Capacity>
+  class SpscRing
+  {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+  public:
+    // Producer side. value is only moved from when there was room.
+    bool TryPush(T&& value)
+    {
+      const auto head = m_head.load(std::memory_order_relaxed);
+      if(head - m_tail.load(std::memory_order_acquire) == Capacity)
+      {
+        return false;
+      }
+      m_slots[head % Capacity] = std::move(value);
+      m_head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Consumer side
+    std::optional<T> TryPop()
+    {
+      const auto tail = m_tail.load(std::memory_order_relaxed);
+      if(tail == m_head.load(std::memory_order_acquire))
+      {
+        return std::nullopt;
+      }
+      std::optional<T> result(std::move(m_slots[tail % Capacity]));
+      m_slots[tail % Capacity] = T();
+      m_tail.store(tail + 1, std::memory_order_release);
+      return result;
+    }
+
+    [[nodiscard]] bool Empty() const
+    {
+      return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] std::uint64_t Published() const { return m_head.load(std::memory_order_acquire); }
+    [[nodiscard]] std::uint64_t Consumed() const { return m_tail.load(std::memory_order_acquire); }
+
+  private:
+    static constexpr std::size_t CacheLineSize = 64;
+
+    alignas(CacheLineSize) std::atomic<std::uint64_t> m_head{0};
+    alignas(CacheLineSize) std::atomic<std::uint64_t> m_tail{0};
+    alignas(CacheLineSize) std::array<T, Capacity> m_slots{};
+  };
+
+} // namespace Bot
@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Dotenv.hpp"
+#include "Logging.h"
+#include "Runner.h"
+#include "Worker.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  constexpr Bot::Log::Logger<Bot::Log::Category::Runner> logger;
+} // namespace
+
+int main(int /*argc*/, char** /*argv*/)
+{
+  load_dotenv();
+  std::signal(SIGPIPE, SIG_IGN);
+
+  auto games       = static_cast<std::size_t>(std::max(get_env_int("SWOQ_SUPERVISOR_GAMES").value_or(100), 0));
+  auto workerCount = static_cast<std::size_t>(
+    std::max(get_env_int("SWOQ_SUPERVISOR_WORKERS").value_or(static_cast<int>(std::thread::hardware_concurrency())), 1));
+  auto level       = get_env_int("SWOQ_LEVEL");
+  auto seed        = get_env_int("SWOQ_SEED");
+  auto firstSeed   = get_env_int("SWOQ_SUPERVISOR_FIRST_SEED");
+  auto logFolder   = get_env_str("SWOQ_SUPERVISOR_LOG_FOLDER").transform([](const auto& folder) { return fs::path(folder); });
+  auto resultsFile = fs::path(get_env_str("SWOQ_SUPERVISOR_RESULTS").value_or("sweep-results.tsv"));
+
+  fs::path bot;
+  if(auto configured = get_env_str("SWOQ_SUPERVISOR_BOT"))
+  {
+    bot = *configured;
+  }
+  else
+  {
+    // Next to this executable. Without /proc, SWOQ_SUPERVISOR_BOT has to be set.
+    std::error_code error;
+    const auto self = fs::read_symlink("/proc/self/exe", error);
+    if(error)
+    {
+      logger.Error("Supervisor: Can't find the bot next to the supervisor ({}), set SWOQ_SUPERVISOR_BOT", error.message());
+      return -1;
+    }
+    bot = self.parent_path() / "bot";
+  }
+
+  if(logFolder)
+  {
+    fs::create_directories(*logFolder);
+  }
+
+  std::vector<Bot::WorkItem> items;
+  for(std::size_t i = 0; i < games; ++i)
+  {
+    items.push_back({i, level, firstSeed ? std::make_optional(*firstSeed + static_cast<int>(i)) : seed});
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto results = Bot::Supervise(items, {bot, workerCount, logFolder});
+
+  std::ofstream output(resultsFile);
+  std::println(output, "{}", Bot::RecordColumns);
+  for(const auto& result: results)
+  {
+    std::println(output, "{}", Bot::ToRecord(result));
+  }
+  logger.Info("Supervisor: Results written to {}", resultsFile.string());
+
+  auto summary = Bot::Summarize(
+    results, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start));
+  Bot::PrintSummary(summary);
+
+  return summary.games == games && summary.successes == summary.games ? 0 : -1;
+}
@@ -1,12 +1,45 @@
 #include "Swoq.hpp"
 
-#include <print>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include "Logging.h"
 
 namespace Swoq
 {
+  namespace
+  {
+    constexpr Bot::Log::Logger<Bot::Log::Category::Network> logger;
+  } // namespace
 
   using namespace Swoq::Interface;
 
+  CompletionQueueDriver::CompletionQueueDriver()
+    : m_thread([queue = m_queue] { run(*queue); })
+  {
+  }
+
+  CompletionQueueDriver::~CompletionQueueDriver()
+  {
+    m_queue->Shutdown();
+    // A coroutine resumed on the driver thread may drop the last reference. The thread can't join itself, so it is left
+    // to drain the queue and exit on its own.
+    if(m_thread.get_id() == std::this_thread::get_id())
+      m_thread.detach();
+    else
+      m_thread.join();
+  }
+
+  void CompletionQueueDriver::run(grpc::CompletionQueue& queue)
+  {
+    void* tag = nullptr;
+    bool ok = false;
+    while(queue.Next(&tag, &ok))
+    {
+      static_cast<Operation*>(tag)->complete(ok);
+    }
+  }
+
   GameConnection::GameConnection(
     std::string_view user_id,
     std::string_view user_name,
@@ -15,14 +48,20 @@ namespace Swoq
     : m_user_id(user_id)
     , m_user_name(user_name)
     , m_replays_folder(replays_folder)
+    , m_driver(std::make_shared<CompletionQueueDriver>())
   {
     m_channel = grpc::CreateChannel(std::string{host}, grpc::InsecureChannelCredentials());
     m_stub = GameService::NewStub(m_channel);
   }
 
-  std::expected<std::unique_ptr<Game>, std::string> GameConnection::start(std::optional<int> level, std::optional<int> seed)
+  std::expected<std::unique_ptr<Game>, std::string> GameConnection::start(std::optional<int> level, std::optional<int> seed) const
+  {
+    return sync_wait(start_async(level, seed));
+  }
+
+  Task<std::expected<std::unique_ptr<Game>, std::string>>
+    GameConnection::start_async(std::optional<int> level, std::optional<int> seed) const
   {
-    grpc::ClientContext context;
     StartRequest start_request;
     start_request.set_userid(m_user_id);
     start_request.set_username(m_user_name);
@@ -31,25 +70,25 @@ namespace Swoq
     if(seed)
       start_request.set_seed(*seed);
 
-    auto start_response = start_internal(level, seed);
+    auto start_response = co_await start_internal(level, seed);
     if(!start_response)
     {
-      return std::unexpected(start_response.error());
+      co_return std::unexpected(start_response.error());
     }
 
     while(start_response->result() == StartResult::START_RESULT_QUEST_QUEUED)
     {
-      std::println("Quest queued, retrying ...");
-      start_response = start_internal(level, seed);
+      logger.Info("Quest queued, retrying ...");
+      start_response = co_await start_internal(level, seed);
       if(!start_response)
       {
-        return std::unexpected(start_response.error());
+        co_return std::unexpected(start_response.error());
       }
     }
 
     if(start_response->result() != StartResult::START_RESULT_OK)
     {
-      return std::unexpected(std::format("Start failed (result {})", start_response->result()));
+      co_return std::unexpected(std::format("Start failed (result {})", start_response->result()));
     }
 
     std::unique_ptr<ReplayFile> replay_file;
@@ -58,15 +97,16 @@ namespace Swoq
       auto replay_result = ReplayFile::create(*m_replays_folder, start_request, *start_response);
       if(!replay_result)
       {
-        return std::unexpected(std::format("Failed to create ReplayFile: {}", replay_result.error()));
+        co_return std::unexpected(std::format("Failed to create ReplayFile: {}", replay_result.error()));
       }
       replay_file = std::move(replay_result.value());
     }
 
-    return std::make_unique<Game>(m_stub, *start_response, std::move(replay_file));
+    co_return std::make_unique<RemoteGame>(m_stub, m_driver, *start_response, std::move(replay_file));
   }
 
-  std::expected<StartResponse, std::string> GameConnection::start_internal(std::optional<int> level, std::optional<int> seed)
+  Task<std::expected<StartResponse, std::string>>
+    GameConnection::start_internal(std::optional<int> level, std::optional<int> seed) const
   {
     grpc::ClientContext context;
     StartRequest start_request;
@@ -76,15 +116,15 @@ namespace Swoq
       start_request.set_level(*level);
     if(seed)
       start_request.set_seed(*seed);
-    StartResponse start_response;
 
-    auto status = m_stub->Start(&context, start_request, &start_response);
+    auto [start_response, status] =
+      co_await UnaryCall<StartResponse>(m_stub->AsyncStart(&context, start_request, m_driver->queue()));
     if(!status.ok())
     {
-      return std::unexpected(std::format("gRPC error {} - {}", std::to_string(status.error_code()), status.error_message()));
+      co_return std::unexpected(std::format("gRPC error {} - {}", std::to_string(status.error_code()), status.error_message()));
     }
 
-    return start_response;
+    co_return start_response;
   }
 
   std::expected<std::unique_ptr<ReplayFile>, std::string>
@@ -111,94 +151,276 @@ namespace Swoq
       return std::unexpected("Failed to open file stream");
     }
 
-    // Construct ReplayFile and write initial messages
-    auto replay_file = std::make_unique<ReplayFile>(std::move(stream));
-    if(auto result = replay_file->write_delimited(request); !result)
+    std::ofstream index(replay_index_path(filename), std::ios::binary | std::ios::out);
+    if(!index.write(ReplayIndexMagic.data(), static_cast<std::streamsize>(ReplayIndexMagic.size())))
     {
-      return std::unexpected(std::format("Failed to write StartRequest: {}", result.error()));
-    }
-    if(auto result = replay_file->write_delimited(response); !result)
-    {
-      return std::unexpected(std::format("Failed to write StartResponse: {}", result.error()));
+      return std::unexpected("Failed to open index file stream");
     }
 
+    // Construct ReplayFile and queue initial messages
+    auto replay_file = std::make_unique<ReplayFile>(std::move(stream), std::move(index));
+    replay_file->enqueue(StartRecord{request, response});
+
     return replay_file;
   }
 
-  ReplayFile::ReplayFile(std::ofstream&& stream)
+  fs::path replay_index_path(const fs::path& replay)
+  {
+    auto path = replay;
+    path += ".idx";
+    return path;
+  }
+
+  ReplayFile::ReplayFile(std::ofstream&& stream, std::ofstream&& index)
     : m_stream(std::move(stream))
-    , m_zero_copy_output(&m_stream)
-    , m_coded_output(&m_zero_copy_output)
+    , m_index(std::move(index))
+    , m_thread([this] { run(); })
   {
   }
 
+  ReplayFile::~ReplayFile()
+  {
+    {
+      std::lock_guard lock(m_mutex);
+      m_closing = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+  }
+
   std::expected<void, std::string> ReplayFile::append(const ActRequest& request, const ActResponse& response)
   {
-    if(auto result = write_delimited(request); !result)
     {
-      return std::unexpected(std::format("Failed to write ActRequest: {}", result.error()));
+      std::lock_guard lock(m_mutex);
+      if(m_error)
+      {
+        return std::unexpected(*m_error);
+      }
     }
-    if(auto result = write_delimited(response); !result)
+    ActRecord record;
+    record.request = request.SerializeAsString();
+    record.response = response.SerializeAsString();
+    if(response.has_state())
     {
-      return std::unexpected(std::format("Failed to write ActResponse: {}", result.error()));
+      record.tick = response.state().tick();
+      record.level = static_cast<std::int16_t>(response.state().level());
     }
+    enqueue(std::move(record));
     return {};
   }
 
-  std::expected<void, std::string> ReplayFile::write_delimited(const google::protobuf::Message& msg)
+  void ReplayFile::enqueue(Record record)
+  {
+    bool full = false;
+    {
+      std::lock_guard lock(m_mutex);
+      m_queue.push_back(std::move(record));
+      full = m_queue.size() >= BatchSize;
+    }
+    if(full)
+    {
+      m_wake.notify_one();
+    }
+  }
+
+  void ReplayFile::run()
   {
-    m_coded_output.WriteVarint32(msg.ByteSizeLong());
-    if(!msg.SerializeToCodedStream(&m_coded_output))
+    std::vector<Record> batch;
+    bool closing = false;
+    while(!closing)
     {
-      return std::unexpected("SerializeToCodedStream failed");
+      {
+        std::unique_lock lock(m_mutex);
+        m_wake.wait_for(lock, FlushInterval, [&] { return m_closing || m_queue.size() >= BatchSize; });
+        closing = m_closing;
+        batch.swap(m_queue);
+      }
+
+      if(batch.empty())
+        continue;
+
+      if(auto result = write(batch); !result)
+      {
+        std::lock_guard lock(m_mutex);
+        m_error = m_error.value_or(result.error());
+      }
+      batch.clear();
+    }
+  }
+
+  std::expected<void, std::string> ReplayFile::write(const std::vector<Record>& records)
+  {
+    m_buffer.clear();
+    m_entries.clear();
+    {
+      google::protobuf::io::StringOutputStream zero_copy_output(&m_buffer);
+      google::protobuf::io::CodedOutputStream coded_output(&zero_copy_output);
+      const auto serialize = [&](const google::protobuf::Message& message)
+      {
+        coded_output.WriteVarint32(static_cast<std::uint32_t>(message.ByteSizeLong()));
+        return message.SerializeToCodedStream(&coded_output);
+      };
+
+      for(const auto& record: records)
+      {
+        if(const auto* act = std::get_if<ActRecord>(&record))
+        {
+          if(act->tick)
+          {
+            m_tick = *act->tick;
+            m_level = act->level;
+          }
+          m_entries.push_back(
+            {.offset = m_offset + static_cast<std::uint64_t>(coded_output.ByteCount()), .tick = m_tick, .level = m_level});
+          for(const std::string* bytes: {&act->request, &act->response})
+          {
+            coded_output.WriteVarint32(static_cast<std::uint32_t>(bytes->size()));
+            coded_output.WriteString(*bytes);
+          }
+        }
+        else
+        {
+          const auto& start = std::get<StartRecord>(record);
+          m_tick = start.response.state().tick();
+          m_level = static_cast<std::int16_t>(start.response.state().level());
+          if(!serialize(start.request) || !serialize(start.response))
+            return std::unexpected("SerializeToCodedStream failed");
+        }
+      }
+    }
+
+    m_stream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_stream.flush();
+    if(!m_stream)
+    {
+      return std::unexpected("Failed to write replay");
+    }
+    m_offset += m_buffer.size();
+
+    // Only after the records it points to are on disk
+    m_index.write(
+      reinterpret_cast<const char*>(m_entries.data()),
+      static_cast<std::streamsize>(m_entries.size() * sizeof(ReplayIndexEntry)));
+    m_index.flush();
+    if(!m_index)
+    {
+      return std::unexpected("Failed to write replay index");
     }
     return {};
   }
 
-  Game::Game(
+  RemoteGame::RemoteGame(
     std::shared_ptr<GameService::Stub> stub,
+    std::shared_ptr<CompletionQueueDriver> driver,
     const StartResponse& start_response,
     std::unique_ptr<ReplayFile>&& replay_file)
     : m_stub(stub)
+    , m_driver(std::move(driver))
     , m_replay_file(std::move(replay_file))
     , m_start_response(start_response)
-    , m_state(start_response.state())
+    , m_state(&m_start_response.state())
   {
   }
 
-  const std::string& Game::game_id() const { return m_start_response.gameid(); }
-  int Game::map_width() const { return m_start_response.mapwidth(); }
-  int Game::map_height() const { return m_start_response.mapheight(); }
-  int Game::visibility_range() const { return m_start_response.visibilityrange(); }
-  int Game::seed() const { return m_start_response.seed(); }
-  const State& Game::state() const { return m_state; }
+  const std::string& RemoteGame::game_id() const { return m_start_response.gameid(); }
+  int RemoteGame::map_width() const { return m_start_response.mapwidth(); }
+  int RemoteGame::map_height() const { return m_start_response.mapheight(); }
+  int RemoteGame::visibility_range() const { return m_start_response.visibilityrange(); }
+  int RemoteGame::seed() const { return m_start_response.seed(); }
+  const State& RemoteGame::state() const { return *m_state; }
 
-  std::expected<void, std::string> Game::act(std::optional<DirectedAction> action0, std::optional<DirectedAction> action1)
+  RemoteGame::~RemoteGame()
   {
+    // The act coroutine refers to this game
+    if(m_pending_act)
+    {
+      m_pending_act->wait();
+    }
+  }
+
+  std::expected<void, std::string> RemoteGame::act(std::optional<DirectedAction> action0, std::optional<DirectedAction> action1)
+  {
+    return sync_wait(act_async(action0, action1));
+  }
+
+  Task<std::expected<void, std::string>>
+    RemoteGame::act_async(std::optional<DirectedAction> action0, std::optional<DirectedAction> action1)
+  {
+    auto& arena = m_arenas[m_free_arena];
+    arena.Reset();
+    auto& act_request = *google::protobuf::Arena::Create<ActRequest>(&arena);
+    auto& act_response = *google::protobuf::Arena::Create<ActResponse>(&arena);
+
     grpc::ClientContext context;
-    ActRequest act_request;
     act_request.set_gameid(game_id());
     assert(action0 || action1);
     if(action0)
       act_request.set_action(*action0);
     if(action1)
       act_request.set_action2(*action1);
-    ActResponse act_response;
-    auto status = m_stub->Act(&context, act_request, &act_response);
+
+    const auto sent = std::chrono::steady_clock::now();
+    auto status = co_await UnaryCallInto<ActResponse>(m_stub->AsyncAct(&context, act_request, m_driver->queue()), act_response);
+    m_last_round_trip = ActRoundTrip{sent, std::chrono::steady_clock::now()};
     if(!status.ok())
     {
-      return std::unexpected(std::format("gRPC error {} - {}", std::to_string(status.error_code()), status.error_message()));
+      co_return std::unexpected(std::format("gRPC error {} - {}", std::to_string(status.error_code()), status.error_message()));
+    }
+
+    const auto result = act_response.result();
+    if(result == ActResult::ACT_RESULT_OK)
+    {
+      m_state = &act_response.state();
+      m_free_arena = 1 - m_free_arena;
     }
 
+    // The writer thread outlives the arena, so recording serializes the act here, on the driver. That costs about as much
+    // as the deep copy it replaces, but is one buffer per message with nothing left to walk on the writer thread.
+    // Without recording nothing is copied.
+    std::expected<void, std::string> recorded;
     if(m_replay_file)
-      m_replay_file->append(act_request, act_response);
+    {
+      recorded = m_replay_file->append(act_request, act_response);
+    }
+
+    if(result != ActResult::ACT_RESULT_OK)
+    {
+      co_return std::unexpected(std::format("Act failed (result {})", result));
+    }
+    // Like a replay that can't be created, one that can't be written ends the game instead of silently stopping
+    if(!recorded)
+    {
+      co_return std::unexpected(std::format("Failed to write replay: {}", recorded.error()));
+    }
+    co_return std::expected<void, std::string>{};
+  }
 
-    if(act_response.result() != ActResult::ACT_RESULT_OK)
+  std::expected<void, std::string>
+    RemoteGame::act_start(std::optional<DirectedAction> action0, std::optional<DirectedAction> action1)
+  {
+    if(m_pending_act)
     {
-      return std::unexpected(std::format("Act failed (result {})", act_response.result()));
+      return std::unexpected("Act already in flight");
     }
-    m_state = act_response.state();
+
+    m_pending_act = launch(act_async(action0, action1));
     return {};
   }
 
+  std::expected<void, std::string> RemoteGame::act_finish()
+  {
+    if(!m_pending_act)
+    {
+      return std::unexpected("No act in flight");
+    }
+
+    auto pending = std::move(*m_pending_act);
+    m_pending_act.reset();
+    return pending.get();
+  }
+
+  bool RemoteGame::act_in_flight() const { return m_pending_act.has_value(); }
+
+  std::optional<ActRoundTrip> RemoteGame::last_act_round_trip() const { return m_last_round_trip; }
+
 } // namespace Swoq
@@ -1,16 +1,27 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <expected>
+#include <filesystem>
 #include <format>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
 
-#include <google/protobuf/io/coded_stream.h>
-#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/arena.h>
 #include <grpcpp/grpcpp.h>
 
 #include "Swoq.grpc.pb.h"
+#include "Task.hpp"
 
 namespace Swoq
 {
@@ -19,6 +30,107 @@ namespace Swoq
 
   class Game;
 
+  // Runs a single completion queue on its own thread. Coroutines waiting for an RPC are resumed on that thread,
+  // so one driver can serve any number of concurrent games.
+  class CompletionQueueDriver
+  {
+  public:
+    class Operation
+    {
+    public:
+      virtual ~Operation() = default;
+      virtual void complete(bool ok) = 0;
+    };
+
+    CompletionQueueDriver();
+    ~CompletionQueueDriver();
+    CompletionQueueDriver(const CompletionQueueDriver&) = delete;
+    CompletionQueueDriver& operator=(const CompletionQueueDriver&) = delete;
+
+    grpc::CompletionQueue* queue() { return m_queue.get(); }
+
+  private:
+    static void run(grpc::CompletionQueue& queue);
+
+    // Shared with the thread, which outlives the driver when the last owner lets go of it on that thread
+    std::shared_ptr<grpc::CompletionQueue> m_queue = std::make_shared<grpc::CompletionQueue>();
+    std::thread m_thread;
+  };
+
+  template <typename Response>
+  struct RpcResult
+  {
+    Response response;
+    grpc::Status status;
+  };
+
+  // co_await UnaryCallInto(stub->AsyncX(&context, request, driver.queue()), response) suspends until response has been
+  // filled in, and returns the status. The caller owns the response, so it can live on an arena.
+  template <typename Response>
+  class UnaryCallInto final : public CompletionQueueDriver::Operation
+  {
+  public:
+    UnaryCallInto(std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader, Response& response)
+      : m_reader(std::move(reader))
+      , m_response(&response)
+    {
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+      m_handle = handle;
+      // The coroutine may be resumed on the driver thread before Finish returns
+      m_reader->Finish(m_response, &m_status, static_cast<CompletionQueueDriver::Operation*>(this));
+    }
+
+    grpc::Status await_resume()
+    {
+      if(!m_ok && m_status.ok())
+      {
+        m_status = grpc::Status(grpc::StatusCode::CANCELLED, "Completion queue shut down");
+      }
+      return std::move(m_status);
+    }
+
+    void complete(bool ok) override
+    {
+      m_ok = ok;
+      m_handle.resume();
+    }
+
+  private:
+    std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> m_reader;
+    Response* m_response;
+    grpc::Status m_status;
+    bool m_ok = false;
+    std::coroutine_handle<> m_handle;
+  };
+
+  // co_await UnaryCall(stub->AsyncX(&context, request, driver.queue())) suspends until the response arrives
+  template <typename Response>
+  class UnaryCall
+  {
+  public:
+    explicit UnaryCall(std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader)
+      : m_call(std::move(reader), m_response)
+    {
+    }
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { m_call.await_suspend(handle); }
+    RpcResult<Response> await_resume()
+    {
+      auto status = m_call.await_resume();
+      return {std::move(m_response), std::move(status)};
+    }
+
+  private:
+    Response m_response;
+    UnaryCallInto<Response> m_call;
+  };
+
   class GameConnection
   {
   public:
@@ -31,11 +143,15 @@ namespace Swoq
     ~GameConnection() = default;
 
     std::expected<std::unique_ptr<Game>, std::string>
-      start(std::optional<int> level = std::nullopt, std::optional<int> seed = std::nullopt);
+      start(std::optional<int> level = std::nullopt, std::optional<int> seed = std::nullopt) const;
+    Task<std::expected<std::unique_ptr<Game>, std::string>>
+      start_async(std::optional<int> level = std::nullopt, std::optional<int> seed = std::nullopt) const;
+
+    const std::shared_ptr<CompletionQueueDriver>& driver() const { return m_driver; }
 
   private:
-    std::expected<Interface::StartResponse, std::string>
-      start_internal(std::optional<int> level = std::nullopt, std::optional<int> seed = std::nullopt);
+    Task<std::expected<Interface::StartResponse, std::string>>
+      start_internal(std::optional<int> level = std::nullopt, std::optional<int> seed = std::nullopt) const;
 
 
     std::string m_user_id;
@@ -44,54 +160,168 @@ namespace Swoq
 
     std::shared_ptr<grpc::Channel> m_channel;
     std::shared_ptr<Swoq::Interface::GameService::Stub> m_stub;
+    std::shared_ptr<CompletionQueueDriver> m_driver;
   };
 
+  // The index next to a replay, <replay>.idx, starts with ReplayIndexMagic followed by one entry per act
+  struct ReplayIndexEntry
+  {
+    // Of the ActRequest record
+    std::uint64_t offset = 0;
+    // Of the state in the response, or the last known one when the act failed
+    std::int32_t tick = 0;
+    std::int16_t level = 0;
+    // Whether the replay can be read from here on without the records before it
+    std::uint8_t keyframe = 1;
+    std::uint8_t reserved = 0;
+  };
+
+  static_assert(sizeof(ReplayIndexEntry) == 16);
+  inline constexpr std::string_view ReplayIndexMagic = "SWOQ-REPLAY-IDX\n";
+  static_assert(ReplayIndexMagic.size() == sizeof(ReplayIndexEntry));
+
+  fs::path replay_index_path(const fs::path& replay);
+
+  // Records a game. append serializes an act and queues it; a background thread writes the queue in batches,
+  // once BatchSize acts (a request and a response each, the start counts as one) have queued up or FlushInterval has
+  // passed, and when the file is closed. So a crash loses at most the last batch. The index is written after each batch.
   class ReplayFile
   {
   public:
+    static constexpr std::size_t BatchSize = 64;
+    static constexpr std::chrono::milliseconds FlushInterval{500};
+
     static std::expected<std::unique_ptr<ReplayFile>, std::string> create(
       std::string_view replays_folder,
       const Swoq::Interface::StartRequest& request,
       const Swoq::Interface::StartResponse& response);
 
-    explicit ReplayFile(std::ofstream&& stream);
-    ~ReplayFile() = default;
+    ReplayFile(std::ofstream&& stream, std::ofstream&& index);
+    ~ReplayFile();
     ReplayFile(const ReplayFile&) = delete;
     ReplayFile& operator=(const ReplayFile&) = delete;
 
+    // Serializes both right away, so they may live on an arena that is reset afterwards. Fails when an earlier batch
+    // could not be written.
     std::expected<void, std::string>
       append(const Swoq::Interface::ActRequest& request, const Swoq::Interface::ActResponse& response);
 
   private:
-    std::expected<void, std::string> write_delimited(const google::protobuf::Message& msg);
+    struct StartRecord
+    {
+      Swoq::Interface::StartRequest request;
+      Swoq::Interface::StartResponse response;
+    };
+
+    struct ActRecord
+    {
+      std::string request;
+      std::string response;
+      // Of the state in the response, when it has one
+      std::optional<std::int32_t> tick;
+      std::int16_t level = 0;
+    };
+
+    // A request and its response, so an act never straddles two batches
+    using Record = std::variant<StartRecord, ActRecord>;
+
+    void enqueue(Record record);
+    void run();
+    std::expected<void, std::string> write(const std::vector<Record>& records);
 
     std::ofstream m_stream;
-    google::protobuf::io::OstreamOutputStream m_zero_copy_output;
-    google::protobuf::io::CodedOutputStream m_coded_output;
+    std::ofstream m_index;
+    std::string m_buffer;
+    std::vector<ReplayIndexEntry> m_entries;
+    std::uint64_t m_offset = 0;
+    std::int32_t m_tick = 0;
+    std::int16_t m_level = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<Record> m_queue;
+    std::optional<std::string> m_error;
+    bool m_closing = false;
+    std::thread m_thread;
   };
 
+  // From sending an act request to receiving its response
+  struct ActRoundTrip
+  {
+    std::chrono::steady_clock::time_point sent;
+    std::chrono::steady_clock::time_point received;
+  };
+
+  // A game in progress. RemoteGame plays it on the server, ReplayGame (Replay.hpp) plays back a recorded one.
   class Game
   {
   public:
-    Game(
+    Game() = default;
+    virtual ~Game() = default;
+    Game(const Game&) = delete;
+    Game& operator=(const Game&) = delete;
+
+    virtual const std::string& game_id() const = 0;
+    virtual int map_width() const = 0;
+    virtual int map_height() const = 0;
+    virtual int visibility_range() const = 0;
+    virtual int seed() const = 0;
+    virtual const Swoq::Interface::State& state() const = 0;
+
+    virtual std::expected<void, std::string>
+      act(std::optional<Interface::DirectedAction> action0, std::optional<Interface::DirectedAction> action1) = 0;
+
+    // Split act: act_start sends the request and returns immediately, act_finish waits for the response and
+    // updates state(). At most one act can be in flight, and state() must not be read meanwhile.
+    virtual std::expected<void, std::string>
+      act_start(std::optional<Interface::DirectedAction> action0, std::optional<Interface::DirectedAction> action1) = 0;
+    virtual std::expected<void, std::string> act_finish() = 0;
+    virtual bool act_in_flight() const = 0;
+
+    // Of the last act that reached the server. Without a server there is none.
+    virtual std::optional<ActRoundTrip> last_act_round_trip() const { return std::nullopt; }
+  };
+
+  class RemoteGame final : public Game
+  {
+  public:
+    RemoteGame(
       std::shared_ptr<Swoq::Interface::GameService::Stub> stub,
+      std::shared_ptr<CompletionQueueDriver> driver,
       const Swoq::Interface::StartResponse& start_response,
       std::unique_ptr<ReplayFile>&& replay_file);
+    ~RemoteGame() override;
+
+    const std::string& game_id() const override;
+    int map_width() const override;
+    int map_height() const override;
+    int visibility_range() const override;
+    int seed() const override;
+    const Swoq::Interface::State& state() const override;
 
-    const std::string& game_id() const;
-    int map_width() const;
-    int map_height() const;
-    int visibility_range() const;
-    int seed() const;
-    const Swoq::Interface::State& state() const;
+    std::expected<void, std::string>
+      act(std::optional<Interface::DirectedAction> action0, std::optional<Interface::DirectedAction> action1) override;
+    Task<std::expected<void, std::string>>
+      act_async(std::optional<Interface::DirectedAction> action0, std::optional<Interface::DirectedAction> action1);
 
-    std::expected<void, std::string> act(std::optional<Interface::DirectedAction> action0, std::optional<Interface::DirectedAction> action1);
+    std::expected<void, std::string>
+      act_start(std::optional<Interface::DirectedAction> action0, std::optional<Interface::DirectedAction> action1) override;
+    std::expected<void, std::string> act_finish() override;
+    bool act_in_flight() const override;
+    std::optional<ActRoundTrip> last_act_round_trip() const override;
 
   private:
     std::shared_ptr<Swoq::Interface::GameService::Stub> m_stub;
+    std::shared_ptr<CompletionQueueDriver> m_driver;
     std::unique_ptr<ReplayFile> m_replay_file;
     Swoq::Interface::StartResponse m_start_response;
-    Swoq::Interface::State m_state;
+    // The messages of an act live on the arena that doesn't hold the current state, which is reset first. So the state
+    // stays valid while the next act is in flight, and each act reuses the memory of an earlier one.
+    std::array<google::protobuf::Arena, 2> m_arenas;
+    std::size_t m_free_arena = 0;
+    const Swoq::Interface::State* m_state;
+    std::optional<std::future<std::expected<void, std::string>>> m_pending_act;
+    // Written by the act coroutine, read after it has finished
+    std::optional<ActRoundTrip> m_last_round_trip;
   };
 
 } // namespace Swoq
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace Swoq
+{
+  template <typename T>
+  class Task;
+
+  namespace Detail
+  {
+    struct FinalAwaiter
+    {
+      bool await_ready() noexcept { return false; }
+
+      template <typename Promise>
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+      {
+        auto continuation = handle.promise().continuation;
+        return continuation ? continuation : std::noop_coroutine();
+      }
+
+      void await_resume() noexcept {}
+    };
+
+    template <typename T>
+    struct TaskPromise
+    {
+      std::optional<T> value;
+      std::exception_ptr exception;
+      std::coroutine_handle<> continuation;
+
+      Task<T> get_return_object();
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      FinalAwaiter final_suspend() noexcept { return {}; }
+      void return_value(T result) { value.emplace(std::move(result)); }
+      void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    struct DetachedTask
+    {
+      struct promise_type
+      {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+      };
+    };
+
+    template <typename T>
+    DetachedTask run_into(Task<T> task, std::promise<T> promise)
+    {
+      std::optional<T> result;
+      try
+      {
+        result.emplace(co_await std::move(task));
+      }
+      catch(...)
+      {
+        promise.set_exception(std::current_exception());
+        co_return;
+      }
+      promise.set_value(std::move(*result));
+    }
+  } // namespace Detail
+
+  // Lazy coroutine: it starts when awaited and resumes the awaiter when it is done, on whichever thread finished it
+  template <typename T>
+  class [[nodiscard]] Task
+  {
+    static_assert(!std::is_void_v<T>, "Task<void> is not supported");
+
+  public:
+    using promise_type = Detail::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle)
+      : m_handle(handle)
+    {
+    }
+
+    Task(Task&& other) noexcept
+      : m_handle(std::exchange(other.m_handle, {}))
+    {
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+      if(this != &other)
+      {
+        if(m_handle)
+          m_handle.destroy();
+        m_handle = std::exchange(other.m_handle, {});
+      }
+      return *this;
+    }
+
+    ~Task()
+    {
+      if(m_handle)
+        m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+    {
+      m_handle.promise().continuation = continuation;
+      return m_handle;
+    }
+
+    T await_resume()
+    {
+      auto& promise = m_handle.promise();
+      if(promise.exception)
+        std::rethrow_exception(promise.exception);
+      return std::move(*promise.value);
+    }
+
+  private:
+    std::coroutine_handle<promise_type> m_handle;
+  };
+
+  template <typename T>
+  Task<T> Detail::TaskPromise<T>::get_return_object()
+  {
+    return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+  }
+
+  // Starts task on the calling thread. The future becomes ready when the task completes.
+  template <typename T>
+  std::future<T> launch(Task<T> task)
+  {
+    std::promise<T> promise;
+    auto future = promise.get_future();
+    Detail::run_into(std::move(task), std::move(promise));
+    return future;
+  }
+
+  // Runs task to completion, blocking the calling thread while it is suspended
+  template <typename T>
+  T sync_wait(Task<T> task)
+  {
+    return launch(std::move(task)).get();
+  }
+
+} // namespace Swoq
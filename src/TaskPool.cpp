@@ -0,0 +1,120 @@
+#include "TaskPool.h"
+
+#include <algorithm>
+
+namespace Bot
+{
+  namespace
+  {
+    thread_local const TaskPool* currentPool = nullptr;
+    thread_local std::size_t currentWorker = 0;
+  } // namespace
+
+  TaskPool::TaskPool(std::size_t workerCount)
+  {
+    workerCount = std::max<std::size_t>(workerCount, 1);
+    for(std::size_t i = 0; i < workerCount; ++i)
+    {
+      m_queues.push_back(std::make_unique<Queue>());
+    }
+    for(std::size_t i = 0; i < workerCount; ++i)
+    {
+      m_workers.emplace_back([this, i](std::stop_token stopToken) { WorkerLoop(stopToken, i); });
+    }
+  }
+
+  std::size_t TaskPool::DefaultWorkerCount()
+  {
+    // The thread that submits work helps out while it waits
+    const std::size_t hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+  }
+
+  std::shared_ptr<TaskPool> TaskPool::Shared()
+  {
+    static const auto pool = std::make_shared<TaskPool>();
+    return pool;
+  }
+
+  void TaskPool::Push(Job job)
+  {
+    const std::size_t index =
+      currentPool == this ? currentWorker : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+    {
+      auto& queue = *m_queues[index];
+      std::lock_guard lock(queue.mutex);
+      queue.jobs.push_back(std::move(job));
+    }
+
+    {
+      std::lock_guard lock(m_sleepMutex);
+      m_pending.fetch_add(1, std::memory_order_release);
+    }
+    m_wakeUp.notify_one();
+  }
+
+  std::optional<TaskPool::Job> TaskPool::Take(std::size_t preferred)
+  {
+    {
+      auto& own = *m_queues[preferred];
+      std::lock_guard lock(own.mutex);
+      if(!own.jobs.empty())
+      {
+        Job job = std::move(own.jobs.back());
+        own.jobs.pop_back();
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+      }
+    }
+
+    for(std::size_t i = 1; i < m_queues.size(); ++i)
+    {
+      auto& victim = *m_queues[(preferred + i) % m_queues.size()];
+      std::lock_guard lock(victim.mutex);
+      if(!victim.jobs.empty())
+      {
+        Job job = std::move(victim.jobs.front());
+        victim.jobs.pop_front();
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  bool TaskPool::RunPendingTask()
+  {
+    if(m_pending.load(std::memory_order_acquire) == 0)
+    {
+      return false;
+    }
+
+    auto job = Take(currentPool == this ? currentWorker : 0);
+    if(!job)
+    {
+      return false;
+    }
+    (*job)();
+    return true;
+  }
+
+  void TaskPool::WorkerLoop(std::stop_token stopToken, std::size_t index)
+  {
+    currentPool = this;
+    currentWorker = index;
+
+    while(!stopToken.stop_requested())
+    {
+      if(auto job = Take(index))
+      {
+        (*job)();
+        continue;
+      }
+
+      std::unique_lock lock(m_sleepMutex);
+      m_wakeUp.wait(lock, stopToken, [&] { return m_pending.load(std::memory_order_acquire) > 0; });
+    }
+  }
+
+} // namespace Bot
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <stop_token>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "Allocations.h"
+#include "Logging.h"
+
+namespace Bot
+{
+  class TaskPool;
+
+  namespace Detail
+  {
+    template <typename T>
+    struct TaskState
+    {
+      using Value = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+      std::mutex mutex;
+      std::condition_variable done;
+      std::atomic<bool> ready = false;
+      std::optional<Value> value;
+      std::exception_ptr exception;
+
+      template <typename Callable>
+      void Run(Callable& callable)
+      {
+        try
+        {
+          if constexpr(std::is_void_v<T>)
+          {
+            std::invoke(callable);
+            value.emplace();
+          }
+          else
+          {
+            value.emplace(std::invoke(callable));
+          }
+        }
+        catch(...)
+        {
+          exception = std::current_exception();
+        }
+
+        {
+          std::lock_guard lock(mutex);
+          ready.store(true, std::memory_order_release);
+        }
+        done.notify_all();
+      }
+    };
+  } // namespace Detail
+
+  template <typename T>
+  class TaskHandle
+  {
+  public:
+    TaskHandle(TaskPool& pool, std::shared_ptr<Detail::TaskState<T>> state)
+      : m_pool(&pool)
+      , m_state(std::move(state))
+    {
+    }
+
+    [[nodiscard]] bool Ready() const { return m_state->ready.load(std::memory_order_acquire); }
+
+    // Runs other pending tasks while waiting, so a task can fan out and join without starving the pool.
+    // Those tasks run on the calling thread; they must not depend on its thread_local state.
+    void Wait();
+    T Get();
+
+  private:
+    TaskPool* m_pool;
+    std::shared_ptr<Detail::TaskState<T>> m_state;
+  };
+
+  // Each worker owns a deque. Workers and waiters take their own newest task first and steal the oldest
+  // task of another worker when they run out.
+  class TaskPool
+  {
+  public:
+    explicit TaskPool(std::size_t workerCount = DefaultWorkerCount());
+    ~TaskPool() = default;
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    template <typename Callable>
+    auto Submit(Callable&& callable) -> TaskHandle<std::invoke_result_t<std::decay_t<Callable>&>>
+    {
+      using T = std::invoke_result_t<std::decay_t<Callable>&>;
+      auto state = std::make_shared<Detail::TaskState<T>>();
+      Push(
+        [state, callable = std::forward<Callable>(callable), game = Log::CurrentGame(), phase = Allocations::Current()]() mutable
+        {
+          Log::GameScope scope(game);
+          Allocations::Scope phaseScope(phase);
+          state->Run(callable);
+        });
+      return TaskHandle<T>(*this, std::move(state));
+    }
+
+    // Returns false when there was nothing to run
+    bool RunPendingTask();
+
+    [[nodiscard]] std::size_t WorkerCount() const { return m_queues.size(); }
+    [[nodiscard]] static std::size_t DefaultWorkerCount();
+    // One pool for the whole process, created on first use, so concurrent games don't each start a pool per core
+    [[nodiscard]] static std::shared_ptr<TaskPool> Shared();
+
+  private:
+    using Job = std::move_only_function<void()>;
+
+    struct Queue
+    {
+      std::mutex mutex;
+      std::deque<Job> jobs;
+    };
+
+    void Push(Job job);
+    std::optional<Job> Take(std::size_t preferred);
+    void WorkerLoop(std::stop_token stopToken, std::size_t index);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::atomic<std::size_t> m_nextQueue = 0;
+    std::atomic<std::size_t> m_pending = 0;
+    std::mutex m_sleepMutex;
+    std::condition_variable_any m_wakeUp;
+    std::vector<std::jthread> m_workers;
+  };
+
+  template <typename T>
+  void TaskHandle<T>::Wait()
+  {
+    using namespace std::chrono_literals;
+    while(!Ready())
+    {
+      if(!m_pool->RunPendingTask())
+      {
+        std::unique_lock lock(m_state->mutex);
+        m_state->done.wait_for(lock, 100us, [&] { return Ready(); });
+      }
+    }
+  }
+
+  template <typename T>
+  T TaskHandle<T>::Get()
+  {
+    Wait();
+    if(m_state->exception)
+    {
+      std::rethrow_exception(m_state->exception);
+    }
+    if constexpr(!std::is_void_v<T>)
+    {
+      return std::move(*m_state->value);
+    }
+  }
+
+  // Runs first on the calling thread and the others in the pool. Returns a tuple with all results.
+  template <typename Callable, typename... Callables>
+  auto ParallelInvoke(TaskPool& pool, Callable&& first, Callables&&... others)
+  {
+    auto handles = std::make_tuple(pool.Submit(std::forward<Callables>(others))...);
+
+    std::optional<std::invoke_result_t<Callable>> firstResult;
+    std::exception_ptr exception;
+    try
+    {
+      firstResult.emplace(std::invoke(std::forward<Callable>(first)));
+    }
+    catch(...)
+    {
+      exception = std::current_exception();
+    }
+
+    // The other callables may refer to the caller's stack, so they have to finish before we unwind
+    std::apply([](auto&... handle) { (handle.Wait(), ...); }, handles);
+    if(exception)
+    {
+      std::rethrow_exception(exception);
+    }
+    return std::apply([&](auto&... handle) { return std::tuple(std::move(*firstResult), handle.Get()...); }, handles);
+  }
+
+  // Applies callable to every element in the pool. Results are in the order of range.
+  template <std::ranges::input_range Range, typename Callable>
+  auto ParallelTransform(TaskPool& pool, Range&& range, Callable&& callable)
+  {
+    using Element = std::ranges::range_value_t<Range>;
+    using Result = std::invoke_result_t<Callable&, const Element&>;
+
+    std::vector<TaskHandle<Result>> handles;
+    for(auto&& element: range)
+    {
+      handles.push_back(pool.Submit([&callable, element = Element(element)] { return std::invoke(callable, element); }));
+    }
+
+    for(auto& handle: handles)
+    {
+      handle.Wait();
+    }
+
+    std::vector<Result> results;
+    results.reserve(handles.size());
+    for(auto& handle: handles)
+    {
+      results.push_back(handle.Get());
+    }
+    return results;
+  }
+
+} // namespace Bot
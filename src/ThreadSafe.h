@@ -3,6 +3,7 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <type_traits>
 
 #include "TypeTraits.h"
@@ -13,6 +14,12 @@ namespace Bot
   template <typename T>
   class ThreadSafeProxy;
 
+  template <typename T>
+  class ThreadSafeReadProxy;
+
+  template <typename T>
+  class ThreadSafeWriteProxy;
+
   template <typename T>
   class ThreadSafe
   {
@@ -136,4 +143,152 @@ namespace Bot
     std::unique_lock<std::mutex> m_lock;
   };
 
+  // Like ThreadSafe, but readers share the lock and waiters are only woken after a writer actually touched the
+  // value. Lock() is a write lock, so code using ThreadSafe can switch over without changes.
+  template <typename T>
+  class SharedThreadSafe
+  {
+  public:
+    SharedThreadSafe(T initial = T())
+      : m_value(initial)
+    {
+    }
+
+    T Get() const
+    {
+      std::shared_lock lock(m_mutex);
+      return m_value;
+    }
+
+    ThreadSafeReadProxy<T> Read() const { return ThreadSafeReadProxy<T>(this); }
+    ThreadSafeWriteProxy<T> Write() { return ThreadSafeWriteProxy<T>(this); }
+    ThreadSafeWriteProxy<T> Lock() { return Write(); }
+
+  private:
+    mutable std::shared_mutex m_mutex;
+    mutable std::condition_variable_any m_condition;
+    T m_value;
+
+    friend class ThreadSafeReadProxy<T>;
+    friend class ThreadSafeWriteProxy<T>;
+  };
+
+  namespace Detail
+  {
+    template <typename T>
+    decltype(auto) Dereference(T& value)
+    {
+      if constexpr(has_dereference_v<T>)
+      {
+        return (*value);
+      }
+      else
+      {
+        return (value);
+      }
+    }
+
+    template <typename T>
+    decltype(auto) Arrow(T& value)
+    {
+      if constexpr(std::is_pointer_v<std::remove_const_t<T>>)
+      {
+        return (value);
+      }
+      else if constexpr(has_arrow_v<T>)
+      {
+        return value.operator->();
+      }
+      else
+      {
+        return std::addressof(value);
+      }
+    }
+  } // namespace Detail
+
+  template <typename T>
+  class ThreadSafeReadProxy
+  {
+  public:
+    ThreadSafeReadProxy(const SharedThreadSafe<T>* me)
+      : m_me(me)
+      , m_lock(m_me->m_mutex)
+    {
+    }
+
+    ThreadSafeReadProxy(const ThreadSafeReadProxy&) = delete;
+    ThreadSafeReadProxy& operator=(const ThreadSafeReadProxy&) = delete;
+
+    const T& Get() const { return m_me->m_value; }
+    decltype(auto) operator*() const { return Detail::Dereference(Get()); }
+    decltype(auto) operator->() const { return Detail::Arrow(Get()); }
+
+    template <typename Predicate>
+    bool WaitUntil(std::chrono::steady_clock::time_point timePoint, Predicate&& predicate)
+    {
+      return m_me->m_condition.wait_until(m_lock, timePoint, std::forward<Predicate>(predicate));
+    }
+
+  private:
+    const SharedThreadSafe<T>* m_me;
+    std::shared_lock<std::shared_mutex> m_lock;
+  };
+
+  // Any non-const access counts as a change. Waiters are notified when the proxy goes out of scope.
+  template <typename T>
+  class ThreadSafeWriteProxy
+  {
+  public:
+    ThreadSafeWriteProxy(SharedThreadSafe<T>* me)
+      : m_me(me)
+      , m_lock(m_me->m_mutex)
+    {
+    }
+
+    ThreadSafeWriteProxy(const ThreadSafeWriteProxy&) = delete;
+    ThreadSafeWriteProxy& operator=(const ThreadSafeWriteProxy&) = delete;
+
+    ~ThreadSafeWriteProxy()
+    {
+      m_lock.unlock();
+      if(m_changed)
+      {
+        m_me->m_condition.notify_all();
+      }
+    }
+
+    T& operator=(T&& other)
+      requires(std::is_move_constructible_v<T>)
+    {
+      return Get() = std::move(other);
+    }
+
+    T& operator=(const T& other) { return Get() = other; }
+
+    T& Get()
+    {
+      m_changed = true;
+      return m_me->m_value;
+    }
+    const T& Get() const { return m_me->m_value; }
+
+    decltype(auto) operator*() { return Detail::Dereference(Get()); }
+    decltype(auto) operator*() const { return Detail::Dereference(Get()); }
+    decltype(auto) operator->() { return Detail::Arrow(Get()); }
+    decltype(auto) operator->() const { return Detail::Arrow(Get()); }
+
+    [[nodiscard]] bool Changed() const { return m_changed; }
+
+    template <typename Predicate>
+    bool WaitUntil(std::chrono::steady_clock::time_point timePoint, Predicate&& predicate)
+    {
+      return m_me->m_condition.wait_until(m_lock, timePoint, std::forward<Predicate>(predicate));
+    }
+
+  private:
+    SharedThreadSafe<T>* m_me;
+    std::unique_lock<std::shared_mutex> m_lock;
+    bool m_changed = false;
+  };
+
 } // namespace Bot
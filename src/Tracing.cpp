@@ -0,0 +1,115 @@
+#include "Tracing.h"
+
+#include <format>
+
+namespace Bot::Tracing
+{
+  namespace
+  {
+    struct TrackId
+    {
+      int pid;
+      int tid;
+    };
+
+    constexpr std::array<TrackId, TrackCount> TrackIds{{{1, 1}, {1, 2}, {2, 1}, {2, 2}, {2, 3}, {3, 1}, {3, 2}, {3, 3}}};
+
+    TrackId IdOf(Track track) { return TrackIds[static_cast<std::size_t>(track)]; }
+
+    std::string Escape(std::string_view text)
+    {
+      std::string result;
+      result.reserve(text.size());
+      for(const char c: text)
+      {
+        if(c == '"' || c == '\\')
+          result += '\\';
+        if(static_cast<unsigned char>(c) < 0x20)
+          result += std::format("\\u{:04x}", static_cast<int>(c));
+        else
+          result += c;
+      }
+      return result;
+    }
+  } // namespace
+
+  std::expected<std::unique_ptr<TraceFile>, std::string> TraceFile::Open(const std::filesystem::path& path, std::string_view gameId)
+  {
+    if(path.has_parent_path())
+    {
+      std::error_code error;
+      std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    std::unique_ptr<TraceFile> file(new TraceFile(path));
+    if(!file->m_stream)
+    {
+      return std::unexpected(std::format("Failed to open {}", path.string()));
+    }
+
+    const std::array processNames{std::format("Game {}", gameId), std::string("Player 0"), std::string("Player 1")};
+    for(std::size_t pid = 0; pid < processNames.size(); ++pid)
+    {
+      file->Write(std::format(
+        R"({{"name":"process_name","ph":"M","pid":{},"args":{{"name":"{}"}}}})", pid + 1, Escape(processNames[pid])));
+      file->Write(std::format(R"({{"name":"process_sort_index","ph":"M","pid":{},"args":{{"sort_index":{}}}}})", pid + 1, pid));
+    }
+    for(std::size_t track = 0; track < TrackCount; ++track)
+    {
+      const auto id = TrackIds[track];
+      file->Write(std::format(
+        R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":"{}"}}}})", id.pid, id.tid, TrackNames[track]));
+      file->Write(std::format(
+        R"({{"name":"thread_sort_index","ph":"M","pid":{},"tid":{},"args":{{"sort_index":{}}}}})", id.pid, id.tid, id.tid));
+    }
+    return file;
+  }
+
+  TraceFile::TraceFile(const std::filesystem::path& path)
+    : m_stream(path)
+  {
+    m_stream << R"({"displayTimeUnit":"ms","traceEvents":[)" << '\n';
+  }
+
+  TraceFile::~TraceFile() { m_stream << "\n]}\n"; }
+
+  void TraceFile::Complete(Track track, std::string_view name, Clock::time_point start, Clock::time_point end, std::string_view args)
+  {
+    const auto id = IdOf(track);
+    Write(std::format(
+      R"({{"name":"{}","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":{},"tid":{},"args":{}}})",
+      Escape(name),
+      Microseconds(start),
+      Microseconds(end) - Microseconds(start),
+      id.pid,
+      id.tid,
+      args.empty() ? "{}" : args));
+  }
+
+  void TraceFile::Instant(Track track, std::string_view name, std::string_view args)
+  {
+    const auto id = IdOf(track);
+    Write(std::format(
+      R"({{"name":"{}","ph":"i","s":"t","ts":{:.3f},"pid":{},"tid":{},"args":{}}})",
+      Escape(name),
+      Microseconds(Clock::now()),
+      id.pid,
+      id.tid,
+      args.empty() ? "{}" : args));
+  }
+
+  void TraceFile::Write(std::string_view event)
+  {
+    std::lock_guard lock(m_mutex);
+    if(!m_first)
+      m_stream << ",\n";
+    m_first = false;
+    m_stream << event;
+  }
+
+  double TraceFile::Microseconds(Clock::time_point time) const
+  {
+    return std::chrono::duration<double, std::micro>(time - m_start).count();
+  }
+
+} // namespace Bot::Tracing
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Chrome trace events, for chrome://tracing or ui.perfetto.dev. The game loop and the gRPC calls share the game's
+// process; each player gets a process of its own with tracks for planning, commands and Game::PlayerState.
+namespace Bot::Tracing
+{
+  using Clock = std::chrono::steady_clock;
+
+  enum class Track : std::uint8_t
+  {
+    GameLoop,
+    Grpc,
+    Player0Plan,
+    Player0Commands,
+    Player0State,
+    Player1Plan,
+    Player1Commands,
+    Player1State,
+  };
+
+  constexpr std::array TrackNames{"Game loop", "gRPC", "Plan", "Commands", "State", "Plan", "Commands", "State"};
+  constexpr std::size_t TrackCount = TrackNames.size();
+
+  constexpr Track PlanTrack(std::size_t playerId) { return playerId == 0 ? Track::Player0Plan : Track::Player1Plan; }
+  constexpr Track CommandTrack(std::size_t playerId) { return playerId == 0 ? Track::Player0Commands : Track::Player1Commands; }
+  constexpr Track StateTrack(std::size_t playerId) { return playerId == 0 ? Track::Player0State : Track::Player1State; }
+
+  // Writes the events of one game. Any thread may add events.
+  class TraceFile
+  {
+  public:
+    static std::expected<std::unique_ptr<TraceFile>, std::string> Open(const std::filesystem::path& path, std::string_view gameId);
+    ~TraceFile();
+
+    TraceFile(const TraceFile&) = delete;
+    TraceFile& operator=(const TraceFile&) = delete;
+
+    // args is a JSON object, or empty
+    void Complete(Track track, std::string_view name, Clock::time_point start, Clock::time_point end, std::string_view args = {});
+    void Instant(Track track, std::string_view name, std::string_view args = {});
+
+  private:
+    explicit TraceFile(const std::filesystem::path& path);
+
+    void Write(std::string_view event);
+    double Microseconds(Clock::time_point time) const;
+
+    std::mutex m_mutex;
+    std::ofstream m_stream;
+    Clock::time_point m_start = Clock::now();
+    bool m_first = true;
+  };
+
+  // Adds a complete event for the rest of the scope. Without a file, it does nothing.
+  class ScopedSpan
+  {
+  public:
+    ScopedSpan(TraceFile* file, Track track, std::string_view name)
+      : m_file(file)
+      , m_track(track)
+      , m_name(name)
+    {
+      if(m_file)
+        m_start = Clock::now();
+    }
+
+    ~ScopedSpan()
+    {
+      if(m_file)
+        m_file->Complete(m_track, m_name, m_start, Clock::now(), m_args);
+    }
+
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+    bool Enabled() const { return m_file != nullptr; }
+    void SetArgs(std::string args) { m_args = std::move(args); }
+
+  private:
+    TraceFile* m_file;
+    Track m_track;
+    std::string_view m_name;
+    Clock::time_point m_start;
+    std::string m_args;
+  };
+
+} // namespace Bot::Tracing
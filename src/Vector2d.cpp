@@ -1,56 +1,70 @@
 #include "Vector2d.h"
 
-#include <print>
+#include <format>
+#include <iterator>
+#include <string>
 
+#include "Logging.h"
 #include "Swoq.hpp"
 
+namespace
+{
+  constexpr Bot::Log::Logger<Bot::Log::Category::Map> logger;
+} // namespace
+
 void Print(const Vector2d<char>& chars)
 {
-  std::print("+");
-  for(int x = 0; x < chars.Width(); ++x)
-  {
-    std::print("-");
-  }
-  std::print("+\n");
+  if(!logger.IsEnabled(Bot::Log::Level::Info))
+    return;
 
+  const auto border = std::format("+{}+", std::string(static_cast<std::size_t>(chars.Width()), '-'));
+  std::string text = border;
   for(int y = 0; y < chars.Height(); ++y)
   {
-    std::print("|");
+    text += "\n|";
     for(int x = 0; x < chars.Width(); ++x)
     {
-      std::print("{}", chars[Offset(x, y)]);
+      text += chars[Offset(x, y)];
     }
-    std::print("|\n");
-  }
-
-  std::print("+");
-  for(int x = 0; x < chars.Width(); ++x)
-  {
-    std::print("-");
+    text += '|';
   }
-  std::print("+\n");
+  text += '\n';
+  text += border;
+  logger.Info("{}", std::move(text));
 }
 
 void Print(const Vector2d<int>& ints)
 {
+  if(!logger.IsEnabled(Bot::Log::Level::Info))
+    return;
+
+  std::string text;
   for(int y = 0; y < ints.Height(); ++y)
   {
+    if(y > 0)
+      text += '\n';
     for(int x = 0; x < ints.Width(); ++x)
     {
-      std::print("{}, ", ints[Offset(x, y)]);
+      std::format_to(std::back_inserter(text), "{}, ", ints[Offset(x, y)]);
     }
-    std::print("\n");
   }
+  logger.Info("{}", std::move(text));
 }
 
 void PrintEnum(const Vector2d<Swoq::Interface::Tile>& tiles)
 {
+  if(!logger.IsEnabled(Bot::Log::Level::Info))
+    return;
+
+  std::string text;
   for(int y = 0; y < tiles.Height(); ++y)
   {
+    if(y > 0)
+      text += '\n';
     for(int x = 0; x < tiles.Width(); ++x)
     {
-      std::print("{}, ", tiles[Offset(x, y)]);
+      std::format_to(std::back_inserter(text), "{}, ", tiles[Offset(x, y)]);
     }
-    std::print("\n");
   }
-}
\ No newline at end of file
+  logger.Info("{}", std::move(text));
+}
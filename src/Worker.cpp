@@ -0,0 +1,433 @@
+#include "Worker.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <deque>
+#include <format>
+#include <ranges>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Logging.h"
+
+namespace Bot
+{
+  namespace
+  {
+    constexpr Log::Logger<Log::Category::Runner> logger;
+
+    constexpr char Separator = '\t';
+    constexpr std::string_view None = "-";
+
+    std::vector<std::string_view> Split(std::string_view line)
+    {
+      return line | std::views::split(Separator)
+           | std::views::transform([](auto field) { return std::string_view(field.begin(), field.end()); })
+           | std::ranges::to<std::vector>();
+    }
+
+    template <typename T>
+    std::expected<T, std::string> Parse(std::string_view field)
+    {
+      T value{};
+      auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+      if(error != std::errc{} || end != field.data() + field.size())
+      {
+        return std::unexpected(std::format("Invalid number '{}'", field));
+      }
+      return value;
+    }
+
+    std::expected<std::optional<int>, std::string> ParseOptional(std::string_view field)
+    {
+      if(field == None)
+        return std::nullopt;
+      return Parse<int>(field);
+    }
+
+    std::string FormatOptional(std::optional<int> value) { return value ? std::to_string(*value) : std::string(None); }
+
+    // Keeps a free-form field on a single line and in a single column
+    std::string Sanitize(std::string_view text)
+    {
+      std::string result(text);
+      std::ranges::replace_if(result, [](char c) { return c == Separator || c == '\n' || c == '\r'; }, ' ');
+      return result;
+    }
+
+    struct WorkerProcess
+    {
+      pid_t pid = -1;
+      int fd = -1;
+      LineReader reader{-1};
+      std::optional<WorkItem> current;
+    };
+
+    std::optional<WorkerProcess>
+      Spawn(const std::filesystem::path& bot, std::size_t slot, const std::optional<std::filesystem::path>& logFolder)
+    {
+      int fds[2];
+      if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+      {
+        return std::nullopt;
+      }
+
+      pid_t pid = fork();
+      if(pid < 0)
+      {
+        close(fds[0]);
+        close(fds[1]);
+        return std::nullopt;
+      }
+
+      if(pid == 0)
+      {
+        // dup clears close-on-exec, so only this end survives exec
+        int fd = dup(fds[1]);
+        setenv("SWOQ_WORKER_FD", std::to_string(fd).c_str(), 1);
+
+        int out = logFolder ? open((*logFolder / std::format("worker-{}.log", slot)).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644)
+                            : open("/dev/null", O_WRONLY);
+        if(out >= 0)
+        {
+          dup2(out, STDOUT_FILENO);
+          dup2(out, STDERR_FILENO);
+        }
+
+        execl(bot.c_str(), bot.c_str(), nullptr);
+        _exit(127);
+      }
+
+      close(fds[1]);
+      WorkerProcess worker;
+      worker.pid = pid;
+      worker.fd = fds[0];
+      worker.reader = LineReader(fds[0]);
+      return worker;
+    }
+
+    std::string DescribeExit(int status)
+    {
+      if(WIFSIGNALED(status))
+        return std::format("worker killed by signal {}", WTERMSIG(status));
+      if(WIFEXITED(status))
+        return std::format("worker exited with status {}", WEXITSTATUS(status));
+      return "worker stopped";
+    }
+  } // namespace
+
+  std::string ToLine(const WorkItem& item)
+  {
+    return std::format("{}{}{}{}{}", item.index, Separator, FormatOptional(item.level), Separator, FormatOptional(item.seed));
+  }
+
+  std::expected<WorkItem, std::string> ParseWorkItem(std::string_view line)
+  {
+    auto fields = Split(line);
+    if(fields.size() != 3)
+    {
+      return std::unexpected(std::format("Expected 3 fields in work item '{}'", line));
+    }
+
+    WorkItem item;
+    auto index = Parse<std::size_t>(fields[0]);
+    auto level = ParseOptional(fields[1]);
+    auto seed = ParseOptional(fields[2]);
+    if(!index)
+      return std::unexpected(index.error());
+    if(!level)
+      return std::unexpected(level.error());
+    if(!seed)
+      return std::unexpected(seed.error());
+
+    item.index = *index;
+    item.level = *level;
+    item.seed = *seed;
+    return item;
+  }
+
+  std::string ToRecord(const GameResult& result)
+  {
+    return std::format(
+      "{1}{0}{2}{0}{3}{0}{4}{0}{5}{0}{6}{0}{7}",
+      Separator,
+      result.index,
+      result.gameId.empty() ? std::string(None) : Sanitize(result.gameId),
+      result.seed,
+      result.level,
+      result.success ? 1 : 0,
+      result.duration.count(),
+      Sanitize(result.error));
+  }
+
+  std::expected<GameResult, std::string> ParseRecord(std::string_view line)
+  {
+    auto fields = Split(line);
+    if(fields.size() != 7)
+    {
+      return std::unexpected(std::format("Expected 7 fields in record '{}'", line));
+    }
+
+    auto index = Parse<std::size_t>(fields[0]);
+    auto seed = Parse<int>(fields[2]);
+    auto level = Parse<int>(fields[3]);
+    auto success = Parse<int>(fields[4]);
+    auto duration = Parse<std::chrono::milliseconds::rep>(fields[5]);
+    if(!index)
+      return std::unexpected(index.error());
+    if(!seed)
+      return std::unexpected(seed.error());
+    if(!level)
+      return std::unexpected(level.error());
+    if(!success)
+      return std::unexpected(success.error());
+    if(!duration)
+      return std::unexpected(duration.error());
+
+    GameResult result;
+    result.index = *index;
+    result.gameId = fields[1] == None ? std::string() : std::string(fields[1]);
+    result.seed = *seed;
+    result.level = *level;
+    result.success = *success != 0;
+    result.duration = std::chrono::milliseconds(*duration);
+    result.error = std::string(fields[6]);
+    return result;
+  }
+
+  bool LineReader::Fill()
+  {
+    char buffer[4096];
+    ssize_t count = 0;
+    do
+    {
+      count = read(m_fd, buffer, sizeof(buffer));
+    } while(count < 0 && errno == EINTR);
+
+    if(count <= 0)
+      return false;
+
+    m_buffer.append(buffer, static_cast<std::size_t>(count));
+    return true;
+  }
+
+  std::optional<std::string> LineReader::Pop()
+  {
+    auto end = m_buffer.find('\n');
+    if(end == std::string::npos)
+      return std::nullopt;
+
+    std::string line = m_buffer.substr(0, end);
+    m_buffer.erase(0, end + 1);
+    return line;
+  }
+
+  bool WriteLine(int fd, std::string_view line)
+  {
+    std::string data = std::format("{}\n", line);
+    std::string_view remaining = data;
+    while(!remaining.empty())
+    {
+      auto written = write(fd, remaining.data(), remaining.size());
+      if(written < 0 && errno == EINTR)
+        continue;
+      if(written <= 0)
+        return false;
+      remaining.remove_prefix(static_cast<std::size_t>(written));
+    }
+    return true;
+  }
+
+  std::vector<GameResult> Supervise(const std::vector<WorkItem>& items, const SupervisorOptions& options)
+  {
+    std::deque<WorkItem> pending(items.begin(), items.end());
+    std::vector<GameResult> results;
+    const std::size_t workerCount = std::min(std::max<std::size_t>(options.workers, 1), std::max<std::size_t>(items.size(), 1));
+    std::vector<WorkerProcess> workers(workerCount);
+    std::size_t failedStarts = 0;
+    const std::size_t maxFailedStarts = 3 * workers.size();
+
+    auto assign = [&](WorkerProcess& worker)
+    {
+      if(pending.empty())
+      {
+        // The worker exits when it sees the end of its input
+        close(worker.fd);
+        worker.fd = -1;
+        return;
+      }
+
+      worker.current = pending.front();
+      pending.pop_front();
+      if(!WriteLine(worker.fd, ToLine(*worker.current)))
+      {
+        pending.push_front(*worker.current);
+        worker.current.reset();
+      }
+    };
+
+    auto spawn = [&](std::size_t slot)
+    {
+      auto worker = Spawn(options.bot, slot, options.logFolder);
+      if(!worker)
+      {
+        logger.Error("Supervisor: Failed to start worker {}", slot);
+        ++failedStarts;
+        return;
+      }
+      workers[slot] = std::move(*worker);
+      assign(workers[slot]);
+    };
+
+    for(std::size_t slot = 0; slot < workers.size(); ++slot)
+    {
+      spawn(slot);
+    }
+
+    while(failedStarts <= maxFailedStarts)
+    {
+      std::vector<pollfd> fds;
+      std::vector<std::size_t> slots;
+      for(std::size_t slot = 0; slot < workers.size(); ++slot)
+      {
+        if(workers[slot].fd >= 0)
+        {
+          fds.push_back({workers[slot].fd, POLLIN, 0});
+          slots.push_back(slot);
+        }
+      }
+      if(fds.empty())
+      {
+        break;
+      }
+
+      if(poll(fds.data(), fds.size(), -1) < 0)
+      {
+        continue;
+      }
+
+      for(std::size_t i = 0; i < fds.size(); ++i)
+      {
+        if(fds[i].revents == 0)
+          continue;
+
+        const std::size_t slot = slots[i];
+        auto& worker = workers[slot];
+        if(!worker.reader.Fill())
+        {
+          int status = 0;
+          close(worker.fd);
+          worker.fd = -1;
+          waitpid(worker.pid, &status, 0);
+          worker.pid = -1;
+
+          if(worker.current)
+          {
+            GameResult crashed;
+            crashed.index = worker.current->index;
+            crashed.seed = worker.current->seed.value_or(0);
+            crashed.error = DescribeExit(status);
+            logger.Error("Supervisor: Game {} failed: {}", crashed.index, crashed.error);
+            results.push_back(std::move(crashed));
+            worker.current.reset();
+          }
+          else
+          {
+            logger.Error("Supervisor: Worker {} stopped without work: {}", slot, DescribeExit(status));
+            ++failedStarts;
+          }
+
+          if(!pending.empty())
+          {
+            spawn(slot);
+          }
+          continue;
+        }
+
+        while(auto line = worker.reader.Pop())
+        {
+          auto record = ParseRecord(*line);
+          if(!record)
+          {
+            logger.Warning("Supervisor: Ignoring record from worker {}: {}", slot, record.error());
+            continue;
+          }
+
+          logger.Info(
+            "Supervisor: Game {} ({}) {} at level {} after {} [{}/{}]",
+            record->index,
+            record->gameId,
+            record->success ? "succeeded" : "failed",
+            record->level,
+            record->duration,
+            results.size() + 1,
+            items.size());
+          results.push_back(std::move(*record));
+          worker.current.reset();
+        }
+
+        if(!worker.current && worker.fd >= 0)
+        {
+          assign(worker);
+        }
+      }
+    }
+
+    for(auto& worker: workers)
+    {
+      if(worker.fd >= 0)
+      {
+        close(worker.fd);
+      }
+      if(worker.pid > 0)
+      {
+        waitpid(worker.pid, nullptr, 0);
+      }
+    }
+
+    if(failedStarts > maxFailedStarts)
+    {
+      logger.Error("Supervisor: Giving up, workers keep failing to start ({})", options.bot.string());
+    }
+
+    std::ranges::sort(results, {}, &GameResult::index);
+    return results;
+  }
+
+  std::expected<void, std::string>
+    ServeWorkItems(int fd, const Swoq::GameConnection& connection, std::optional<int> expectedLevel, const Options& options)
+  {
+    LineReader reader(fd);
+    while(true)
+    {
+      auto line = reader.Pop();
+      if(!line)
+      {
+        if(!reader.Fill())
+          return {};
+        continue;
+      }
+
+      auto item = ParseWorkItem(*line);
+      if(!item)
+      {
+        return std::unexpected(item.error());
+      }
+
+      GameResult result = PlayGame(connection, item->level, item->seed, expectedLevel, options);
+      result.index = item->index;
+      if(!WriteLine(fd, ToRecord(result)))
+      {
+        return std::unexpected("Failed to write result record");
+      }
+    }
+  }
+
+} // namespace Bot
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Options.h"
+#include "Runner.h"
+#include "Swoq.hpp"
+
+namespace Bot
+{
+  // Protocol between the supervisor and its bot workers. Both directions are newline-terminated text lines:
+  // the supervisor sends work items, the worker answers every item with a result record.
+  struct WorkItem
+  {
+    std::size_t index = 0;
+    std::optional<int> level;
+    std::optional<int> seed;
+  };
+
+  std::string ToLine(const WorkItem& item);
+  std::expected<WorkItem, std::string> ParseWorkItem(std::string_view line);
+
+  // The names of the fields of a record, for the header of a results file
+  inline constexpr std::string_view RecordColumns = "index\tgame_id\tseed\tlevel\tsuccess\tduration_ms\terror";
+  std::string ToRecord(const GameResult& result);
+  std::expected<GameResult, std::string> ParseRecord(std::string_view line);
+
+  class LineReader
+  {
+  public:
+    explicit LineReader(int fd)
+      : m_fd(fd)
+    {
+    }
+
+    // Reads whatever is available. Returns false on end of file or error.
+    bool Fill();
+    std::optional<std::string> Pop();
+
+  private:
+    int m_fd;
+    std::string m_buffer;
+  };
+
+  bool WriteLine(int fd, std::string_view line);
+
+  struct SupervisorOptions
+  {
+    std::filesystem::path bot;
+    std::size_t workers = 1;
+    // Each worker writes its output to worker-<slot>.log in this folder, or to /dev/null
+    std::optional<std::filesystem::path> logFolder;
+  };
+
+  // Supervisor side: plays the items on worker processes running options.bot, and returns their results sorted by index.
+  // A worker that dies is replaced, and the game it was playing is recorded as failed. Gives up when workers keep dying
+  // before they play a game; the items left are then missing from the results. Writing to a dead worker raises SIGPIPE,
+  // so ignore that signal first.
+  std::vector<GameResult> Supervise(const std::vector<WorkItem>& items, const SupervisorOptions& options);
+
+  // Worker side: plays every work item read from fd until the supervisor closes it
+  std::expected<void, std::string>
+    ServeWorkItems(int fd, const Swoq::GameConnection& connection, std::optional<int> expectedLevel, const Options& options);
+
+} // namespace Bot
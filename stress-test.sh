@@ -5,6 +5,9 @@ export PATH=~/opt/grpc/bin:$PATH
 [ -d build ] || cmake -S . -B build -G Ninja  -DCMAKE_BUILD_TYPE=Debug -DCMAKE_C_COMPILER=gcc-14 -DCMAKE_CXX_COMPILER=g++-14
 cmake --build build
 
+# Play batches of concurrent games in one process until a game fails
+export SWOQ_RUNNER_GAMES=${SWOQ_RUNNER_GAMES:-100}
+
 while build/src/bot
 do
     true
@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdlib>
+#include <expected>
+#include <format>
+#include <new>
+#include <print>
+#include <ranges>
+#include <string_view>
+
+#include "Allocations.h"
+#include "Dotenv.hpp"
+#include "Game.h"
+#include "GameState.h"
+#include "Logging.h"
+
+// Plays a game against the rules of the local server, in process, and counts the allocations of every tick per
+// Allocations::Phase. Ticks at the start of a level are skipped, the rest should allocate little. Fails when the mean of
+// a phase exceeds its budget in SWOQ_ALLOCATION_BUDGET, e.g. "dijkstra=40,total=200".
+//
+// SWOQ_LEVEL and SWOQ_SEED choose the game, SWOQ_ALLOCATION_TICKS how many ticks to play.
+
+namespace
+{
+  using namespace Bot;
+  using Allocations::PhaseCount;
+
+  constexpr int WarmupTicks = 20;
+  constexpr int DefaultTicks = 400;
+  constexpr int DefaultLevel = 8;
+  constexpr int DefaultSeed = 1;
+
+  using Counts = std::array<std::uint64_t, PhaseCount>;
+
+  std::atomic<bool> counting = false;
+  std::array<std::atomic<std::uint64_t>, PhaseCount> allocations{};
+  // Work done on behalf of the game server is not the bot's
+  thread_local bool ignored = false;
+
+  void Count()
+  {
+    if(counting.load(std::memory_order_relaxed) && !ignored)
+      allocations[static_cast<std::size_t>(Allocations::Current())].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void* Allocate(std::size_t size)
+  {
+    Count();
+    if(void* p = std::malloc(std::max<std::size_t>(size, 1)))
+      return p;
+    throw std::bad_alloc();
+  }
+
+  void* Allocate(std::size_t size, std::align_val_t alignment)
+  {
+    Count();
+    const auto align = static_cast<std::size_t>(alignment);
+    if(void* p = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align))
+      return p;
+    throw std::bad_alloc();
+  }
+
+  Counts Snapshot()
+  {
+    Counts counts{};
+    for(std::size_t phase = 0; phase < PhaseCount; ++phase)
+      counts[phase] = allocations[phase].load(std::memory_order_relaxed);
+    return counts;
+  }
+
+  class Ignored
+  {
+  public:
+    Ignored() { ignored = true; }
+    ~Ignored() { ignored = false; }
+    Ignored(const Ignored&) = delete;
+    Ignored& operator=(const Ignored&) = delete;
+  };
+
+  // Allocations per tick of the steady state
+  class TickLog
+  {
+  public:
+    void Tick(int level)
+    {
+      const auto now = Snapshot();
+      m_ticksInLevel = level == m_level ? m_ticksInLevel + 1 : 0;
+      m_level = level;
+      if(m_ticksInLevel > WarmupTicks)
+      {
+        ++m_ticks;
+        for(std::size_t phase = 0; phase < PhaseCount; ++phase)
+        {
+          const auto count = now[phase] - m_previous[phase];
+          m_total[phase] += count;
+          m_max[phase] = std::max(m_max[phase], count);
+        }
+      }
+      m_previous = now;
+    }
+
+    std::uint64_t Ticks() const { return m_ticks; }
+    double Mean(std::size_t phase) const
+    {
+      return m_ticks ? static_cast<double>(m_total[phase]) / static_cast<double>(m_ticks) : 0.0;
+    }
+    std::uint64_t Max(std::size_t phase) const { return m_max[phase]; }
+
+  private:
+    int m_level = -1;
+    int m_ticksInLevel = 0;
+    std::uint64_t m_ticks = 0;
+    Counts m_previous{};
+    Counts m_total{};
+    Counts m_max{};
+  };
+
+  // Server::Quest behind the Swoq::Game interface. The state message is reused, like the arenas of RemoteGame.
+  class LocalGame final : public Swoq::Game
+  {
+  public:
+    LocalGame(int level, int seed, int ticks, TickLog& log)
+      : m_gameId(std::format("allocations-{}-{}", level, seed))
+      , m_seed(seed)
+      , m_quest(level, static_cast<std::uint32_t>(seed), m_options.mapSize, m_options.visibility)
+      , m_ticksLeft(ticks)
+      , m_log(log)
+    {
+      m_quest.Fill(m_state);
+    }
+
+    const std::string& game_id() const override { return m_gameId; }
+    int map_width() const override { return m_options.mapSize.x; }
+    int map_height() const override { return m_options.mapSize.y; }
+    int visibility_range() const override { return m_options.visibility; }
+    int seed() const override { return m_seed; }
+    const Swoq::Interface::State& state() const override { return m_state; }
+
+    std::expected<void, std::string>
+      act(std::optional<Swoq::Interface::DirectedAction> action0, std::optional<Swoq::Interface::DirectedAction> action1) override
+    {
+      m_log.Tick(m_state.level());
+
+      Swoq::Interface::ActResult result;
+      {
+        Ignored ignore;
+        result = m_quest.Act(action0, action1);
+      }
+      if(result != Swoq::Interface::ActResult::ACT_RESULT_OK)
+        return std::unexpected(std::format("Act failed (result {})", static_cast<int>(result)));
+
+      m_state.Clear();
+      m_quest.Fill(m_state);
+      if(--m_ticksLeft <= 0 && m_state.status() == Swoq::Interface::GameStatus::GAME_STATUS_ACTIVE)
+        m_state.set_status(Swoq::Interface::GameStatus::GAME_STATUS_FINISHED_TIMEOUT);
+      return {};
+    }
+
+    std::expected<void, std::string> act_start(
+      std::optional<Swoq::Interface::DirectedAction> action0, std::optional<Swoq::Interface::DirectedAction> action1) override
+    {
+      if(m_pendingAct)
+        return std::unexpected("Act already in flight");
+      m_pendingAct.emplace(action0, action1);
+      return {};
+    }
+
+    std::expected<void, std::string> act_finish() override
+    {
+      if(!m_pendingAct)
+        return std::unexpected("No act in flight");
+      auto [action0, action1] = *std::exchange(m_pendingAct, std::nullopt);
+      return act(action0, action1);
+    }
+
+    bool act_in_flight() const override { return m_pendingAct.has_value(); }
+
+  private:
+    Server::ServerOptions m_options;
+    std::string m_gameId;
+    int m_seed;
+    Server::Quest m_quest;
+    Swoq::Interface::State m_state;
+    int m_ticksLeft;
+    TickLog& m_log;
+    std::optional<std::pair<std::optional<Swoq::Interface::DirectedAction>, std::optional<Swoq::Interface::DirectedAction>>>
+      m_pendingAct;
+  };
+
+  // "phase=count,..." with the names of Allocations::PhaseNames, or total
+  std::expected<std::array<std::optional<double>, PhaseCount + 1>, std::string> ParseBudget(std::string_view spec)
+  {
+    std::array<std::optional<double>, PhaseCount + 1> budget;
+    for(auto part: spec | std::views::split(','))
+    {
+      const std::string_view entry(part.begin(), part.end());
+      if(entry.empty())
+        continue;
+
+      const auto equals = entry.find('=');
+      if(equals == std::string_view::npos)
+        return std::unexpected(std::format("Expected phase=count, not '{}'", entry));
+
+      const auto name = entry.substr(0, equals);
+      auto index = PhaseCount;
+      if(name != "total")
+      {
+        const auto found = std::ranges::find(Allocations::PhaseNames, name);
+        if(found == Allocations::PhaseNames.end())
+          return std::unexpected(std::format("Unknown phase '{}'", name));
+        index = static_cast<std::size_t>(found - Allocations::PhaseNames.begin());
+      }
+
+      const auto value = entry.substr(equals + 1);
+      double limit = 0;
+      if(auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), limit);
+         error != std::errc() || end != value.data() + value.size())
+        return std::unexpected(std::format("Invalid budget '{}'", value));
+      budget[index] = limit;
+    }
+    return budget;
+  }
+} // namespace
+
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new[](std::size_t size) { return Allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return Allocate(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return Allocate(size, alignment); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  Count();
+  return std::malloc(std::max<std::size_t>(size, 1));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+int main(int /*argc*/, char** /*argv*/)
+{
+  auto budget = ParseBudget(get_env_str("SWOQ_ALLOCATION_BUDGET").value_or(""));
+  if(!budget)
+  {
+    std::println("SWOQ_ALLOCATION_BUDGET: {}", budget.error());
+    return -1;
+  }
+
+  const int level = get_env_int("SWOQ_LEVEL").value_or(DefaultLevel);
+  const int seed = get_env_int("SWOQ_SEED").value_or(DefaultSeed);
+  const int ticks = get_env_int("SWOQ_ALLOCATION_TICKS").value_or(DefaultTicks);
+  (void)Log::Configure("warning");
+
+  TickLog log;
+  std::expected<void, std::string> result;
+  {
+    Bot::Game game(std::make_unique<LocalGame>(level, seed, ticks, log), std::nullopt);
+    counting = true;
+    result = game.Run();
+    counting = false;
+  }
+  Log::Flush();
+
+  std::println(
+    "Level {}, seed {}: {} steady ticks, game ended with {}", level, seed, log.Ticks(), result ? "success" : result.error());
+  std::println("{:<10} {:>12} {:>8} {:>8}", "phase", "mean / tick", "max", "budget");
+
+  double total = 0;
+  for(std::size_t phase = 0; phase < PhaseCount; ++phase)
+    total += log.Mean(phase);
+
+  bool withinBudget = log.Ticks() > 0;
+  for(std::size_t phase = 0; phase <= PhaseCount; ++phase)
+  {
+    const bool isTotal = phase == PhaseCount;
+    const double mean = isTotal ? total : log.Mean(phase);
+
+    const auto& limit = (*budget)[phase];
+    const bool exceeded = limit && mean > *limit;
+    withinBudget = withinBudget && !exceeded;
+    std::println(
+      "{:<10} {:>12.2f} {:>8} {:>8}{}",
+      isTotal ? "total" : Allocations::PhaseNames[phase],
+      mean,
+      isTotal ? std::string("") : std::to_string(log.Max(phase)),
+      limit ? std::format("{:.1f}", *limit) : std::string("-"),
+      exceeded ? "  EXCEEDED" : "");
+  }
+
+  return withinBudget ? 0 : -1;
+}
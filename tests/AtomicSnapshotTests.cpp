@@ -0,0 +1,70 @@
+#include "AtomicSnapshot.h"
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using Bot::AtomicSnapshot;
+
+TEST(AtomicSnapshot, GetReturnsPublishedValue)
+{
+  AtomicSnapshot<int> snapshot(std::make_shared<const int>(1));
+  EXPECT_EQ(*snapshot.Get(), 1);
+
+  snapshot = std::make_shared<const int>(2);
+  EXPECT_EQ(*snapshot.Get(), 2);
+}
+
+TEST(AtomicSnapshot, ReadersKeepTheirVersion)
+{
+  AtomicSnapshot<int> snapshot(std::make_shared<const int>(1));
+  auto old = snapshot.Get();
+
+  snapshot.Set(std::make_shared<const int>(2));
+  EXPECT_EQ(*old, 1);
+  EXPECT_EQ(*snapshot.Get(), 2);
+}
+
+TEST(AtomicSnapshot, CompareAndSwapFailsOnStaleExpectation)
+{
+  AtomicSnapshot<int> snapshot(std::make_shared<const int>(1));
+  auto stale = snapshot.Get();
+  snapshot.Set(std::make_shared<const int>(2));
+
+  EXPECT_FALSE(snapshot.CompareAndSwap(stale, std::make_shared<const int>(3)));
+  EXPECT_EQ(*stale, 2);
+  EXPECT_TRUE(snapshot.CompareAndSwap(stale, std::make_shared<const int>(3)));
+  EXPECT_EQ(*snapshot.Get(), 3);
+}
+
+TEST(AtomicSnapshot, UpdateKeepsUnchangedVersion)
+{
+  AtomicSnapshot<int> snapshot(std::make_shared<const int>(1));
+  auto before = snapshot.Get();
+  auto after = snapshot.Update([](const auto& current) { return current; });
+  EXPECT_EQ(before, after);
+}
+
+TEST(AtomicSnapshot, ConcurrentUpdatesAreNotLost)
+{
+  constexpr int Threads = 4;
+  constexpr int Increments = 1000;
+  AtomicSnapshot<int> snapshot(std::make_shared<const int>(0));
+
+  std::vector<std::jthread> threads;
+  for(int t = 0; t < Threads; ++t)
+  {
+    threads.emplace_back(
+      [&]
+      {
+        for(int i = 0; i < Increments; ++i)
+        {
+          snapshot.Update([](const auto& current) { return std::make_shared<const int>(*current + 1); });
+        }
+      });
+  }
+  threads.clear();
+
+  EXPECT_EQ(*snapshot.Get(), Threads * Increments);
+}
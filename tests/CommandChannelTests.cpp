@@ -0,0 +1,84 @@
+#include "CommandChannel.h"
+
+#include <gtest/gtest.h>
+
+using Bot::CommandChannel;
+using Bot::Commands;
+
+namespace
+{
+  Commands MakeCommands(std::initializer_list<Offset> positions)
+  {
+    Commands commands;
+    for(auto position: positions)
+      commands.emplace(Bot::Visit(position));
+    return commands;
+  }
+
+  Offset FrontPosition(const Commands& commands) { return std::get<Bot::Visit>(commands.front()).position; }
+} // namespace
+
+TEST(CommandChannel, DrainWithoutMessagesKeepsQueue)
+{
+  CommandChannel channel;
+  Commands commands = MakeCommands({{1, 1}});
+  EXPECT_FALSE(channel.Drain(commands));
+  EXPECT_EQ(commands.size(), 1u);
+}
+
+TEST(CommandChannel, ReplaceDropsCurrentCommands)
+{
+  CommandChannel channel;
+  Commands commands = MakeCommands({{1, 1}, {2, 2}});
+  channel.Replace(MakeCommands({{3, 3}}));
+  EXPECT_TRUE(channel.HasPending());
+  EXPECT_TRUE(channel.Drain(commands));
+  ASSERT_EQ(commands.size(), 1u);
+  EXPECT_EQ(FrontPosition(commands), Offset(3, 3));
+  EXPECT_FALSE(channel.HasPending());
+}
+
+TEST(CommandChannel, PrependRunsBeforeCurrentCommands)
+{
+  CommandChannel channel;
+  Commands commands = MakeCommands({{1, 1}});
+  channel.Prepend(MakeCommands({{2, 2}}));
+  channel.Drain(commands);
+  ASSERT_EQ(commands.size(), 2u);
+  EXPECT_EQ(FrontPosition(commands), Offset(2, 2));
+  commands.pop();
+  EXPECT_EQ(FrontPosition(commands), Offset(1, 1));
+}
+
+TEST(CommandChannel, MessagesApplyInOrder)
+{
+  CommandChannel channel;
+  Commands commands;
+  channel.Prepend(MakeCommands({{1, 1}}));
+  channel.Replace(MakeCommands({{2, 2}}));
+  channel.Prepend(MakeCommands({{3, 3}}));
+  channel.Drain(commands);
+  ASSERT_EQ(commands.size(), 2u);
+  EXPECT_EQ(FrontPosition(commands), Offset(3, 3));
+  EXPECT_EQ(channel.Sequence(), 3u);
+}
+
+TEST(CommandChannel, PostingMoreThanCapacityDoesNotBlock)
+{
+  CommandChannel channel;
+  constexpr int Messages = 3 * static_cast<int>(CommandChannel::Capacity) + 1;
+  for(int i = 0; i < Messages; ++i)
+    channel.Prepend(MakeCommands({{i, i}}));
+  EXPECT_EQ(channel.Sequence(), static_cast<std::uint64_t>(Messages));
+
+  Commands commands;
+  EXPECT_TRUE(channel.Drain(commands));
+  ASSERT_EQ(commands.size(), static_cast<std::size_t>(Messages));
+  EXPECT_EQ(FrontPosition(commands), Offset(Messages - 1, Messages - 1));
+  EXPECT_FALSE(channel.HasPending());
+
+  // Back to the ring once the overflow is drained
+  channel.Replace(MakeCommands({{0, 0}}));
+  EXPECT_TRUE(channel.Drain(commands));
+  ASSERT_EQ(commands.size(), 1u);
+}
@@ -0,0 +1,176 @@
+#include "DungeonGenerator.h"
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <format>
+
+namespace
+{
+  using Bot::DungeonStyle;
+  using Swoq::Interface::Tile;
+
+  constexpr Offset MapSize{41, 31};
+  constexpr int Visibility = 4;
+  constexpr std::array Styles{
+    DungeonStyle::OpenRooms,
+    DungeonStyle::PerfectMaze,
+    DungeonStyle::BraidedMaze,
+    DungeonStyle::DoorChain,
+    DungeonStyle::BoulderField,
+    DungeonStyle::Enemies};
+
+  std::size_t Count(const Vector2d<Tile>& tiles, Tile tile) { return static_cast<std::size_t>(std::ranges::count(tiles.Data(), tile)); }
+
+  Offset Find(const Vector2d<Tile>& tiles, Tile tile)
+  {
+    auto it = std::ranges::find(tiles.Data(), tile);
+    return tiles.ToOffset(static_cast<std::size_t>(it - tiles.Data().begin()));
+  }
+
+  // Boulders and enemies are in the way, doors only when closed
+  bool IsReachable(const Vector2d<Tile>& tiles, Offset from, Offset to, const std::vector<Tile>& openDoors)
+  {
+    auto passable = [&](Offset p)
+    {
+      const Tile tile = tiles[p];
+      const bool isDoor = tile == Tile::TILE_DOOR_RED || tile == Tile::TILE_DOOR_GREEN || tile == Tile::TILE_DOOR_BLUE;
+      return tile != Tile::TILE_WALL && tile != Tile::TILE_ENEMY && (!isDoor || std::ranges::contains(openDoors, tile));
+    };
+
+    Vector2d<int> visited(tiles.Width(), tiles.Height(), 0);
+    std::deque<Offset> queue{from};
+    visited[from] = 1;
+    while(!queue.empty())
+    {
+      const Offset current = queue.front();
+      queue.pop_front();
+      if(current == to)
+        return true;
+      for(auto direction: Directions)
+      {
+        const Offset next = current + direction;
+        if(tiles.IsInRange(next) && visited[next] == 0 && passable(next))
+        {
+          visited[next] = 1;
+          queue.push_back(next);
+        }
+      }
+    }
+    return false;
+  }
+} // namespace
+
+TEST(DungeonGenerator, IsDeterministicPerSeed)
+{
+  for(auto style: Styles)
+  {
+    const auto first = Bot::GenerateDungeon(style, MapSize, 42);
+    const auto second = Bot::GenerateDungeon(style, MapSize, 42);
+
+    EXPECT_EQ(first.tiles.Data(), second.tiles.Data()) << Bot::DungeonStyleNames[static_cast<std::size_t>(style)];
+    EXPECT_EQ(first.start, second.start);
+    EXPECT_NE(first.tiles.Data(), Bot::GenerateDungeon(style, MapSize, 43).tiles.Data());
+  }
+}
+
+TEST(DungeonGenerator, ExitIsReachableInEveryStyle)
+{
+  const std::vector allDoors{Tile::TILE_DOOR_RED, Tile::TILE_DOOR_GREEN, Tile::TILE_DOOR_BLUE};
+  for(auto style: Styles)
+  {
+    const auto dungeon = Bot::GenerateDungeon(style, MapSize, 7);
+    const auto name = Bot::DungeonStyleNames[static_cast<std::size_t>(style)];
+
+    EXPECT_EQ(dungeon.tiles.Size(), MapSize);
+    EXPECT_EQ(dungeon.tiles[dungeon.start], Tile::TILE_EMPTY) << name;
+    EXPECT_EQ(Count(dungeon.tiles, Tile::TILE_EXIT), 1u) << name;
+    EXPECT_EQ(dungeon.tiles[dungeon.exit], Tile::TILE_EXIT) << name;
+    EXPECT_TRUE(IsReachable(dungeon.tiles, dungeon.start, dungeon.exit, allDoors)) << name;
+  }
+}
+
+TEST(DungeonGenerator, EveryKeyOfTheChainLiesBehindThePreviousDoor)
+{
+  const auto dungeon = Bot::GenerateDungeon(DungeonStyle::DoorChain, MapSize, 3);
+  const auto& tiles = dungeon.tiles;
+  ASSERT_EQ(Count(tiles, Tile::TILE_DOOR_BLUE), 1u);
+  ASSERT_EQ(Count(tiles, Tile::TILE_KEY_BLUE), 1u);
+
+  EXPECT_FALSE(IsReachable(tiles, dungeon.start, dungeon.exit, {Tile::TILE_DOOR_RED, Tile::TILE_DOOR_GREEN}));
+  EXPECT_TRUE(IsReachable(tiles, dungeon.start, Find(tiles, Tile::TILE_KEY_RED), {}));
+  EXPECT_FALSE(IsReachable(tiles, dungeon.start, Find(tiles, Tile::TILE_KEY_GREEN), {}));
+  EXPECT_TRUE(IsReachable(tiles, dungeon.start, Find(tiles, Tile::TILE_KEY_GREEN), {Tile::TILE_DOOR_RED}));
+  EXPECT_TRUE(IsReachable(tiles, dungeon.start, Find(tiles, Tile::TILE_KEY_BLUE), {Tile::TILE_DOOR_RED, Tile::TILE_DOOR_GREEN}));
+}
+
+TEST(DungeonGenerator, PlacesBouldersPlatesAndEnemies)
+{
+  const auto field = Bot::GenerateDungeon(DungeonStyle::BoulderField, MapSize, 5);
+  EXPECT_EQ(Count(field.tiles, Tile::TILE_PRESSURE_PLATE_RED), 1u);
+  EXPECT_EQ(Count(field.tiles, Tile::TILE_DOOR_RED), 1u);
+  EXPECT_GT(Count(field.tiles, Tile::TILE_BOULDER), 0u);
+  EXPECT_TRUE(IsReachable(field.tiles, field.start, Find(field.tiles, Tile::TILE_PRESSURE_PLATE_RED), {}));
+
+  const auto enemies = Bot::GenerateDungeon(DungeonStyle::Enemies, MapSize, 5);
+  EXPECT_GT(Count(enemies.tiles, Tile::TILE_ENEMY), 0u);
+}
+
+TEST(DungeonGenerator, BoulderFieldHasABoulderInFrontOfTheDoor)
+{
+  for(Offset size: {Offset{7, 7}, Offset{11, 9}, MapSize})
+  {
+    for(std::uint64_t seed = 0; seed < 50; ++seed)
+    {
+      const auto dungeon = Bot::GenerateDungeon(DungeonStyle::BoulderField, size, seed);
+      const auto& tiles = dungeon.tiles;
+      if(Count(tiles, Tile::TILE_DOOR_RED) == 0)
+        continue;
+
+      const auto where = std::format("{}x{}, seed {}", size.x, size.y, seed);
+      bool boulderInFront = false;
+      for(std::size_t i = 0; i < tiles.Data().size(); ++i)
+      {
+        boulderInFront |= tiles[i] == Tile::TILE_BOULDER && IsReachable(tiles, dungeon.start, tiles.ToOffset(i), {});
+      }
+      EXPECT_TRUE(boulderInFront) << where;
+      EXPECT_TRUE(IsReachable(tiles, dungeon.start, Find(tiles, Tile::TILE_PRESSURE_PLATE_RED), {})) << where;
+      EXPECT_TRUE(IsReachable(tiles, dungeon.start, dungeon.exit, {Tile::TILE_DOOR_RED})) << where;
+    }
+  }
+}
+
+TEST(DungeonGenerator, GeneratesLargeMaps)
+{
+  const auto dungeon = Bot::GenerateDungeon(DungeonStyle::BraidedMaze, {501, 501}, 1);
+  EXPECT_TRUE(IsReachable(dungeon.tiles, dungeon.start, dungeon.exit, {}));
+}
+
+TEST(DungeonGenerator, WalkShowsWhatIsInSight)
+{
+  const auto dungeon = Bot::GenerateDungeon(DungeonStyle::OpenRooms, MapSize, 11);
+  const auto walk = Bot::GenerateWalk(dungeon, Visibility, 200, 1);
+  ASSERT_EQ(walk.size(), 200u);
+  EXPECT_EQ(walk.front().position, dungeon.start);
+
+  for(std::size_t i = 0; i < walk.size(); ++i)
+  {
+    const auto& [position, view] = walk[i];
+    if(i > 0)
+    {
+      const Offset step = position - walk[i - 1].position;
+      EXPECT_EQ(std::abs(step.x) + std::abs(step.y), 1) << "step " << i;
+    }
+
+    ASSERT_EQ(view.Size(), (Offset{2 * Visibility + 1, 2 * Visibility + 1}));
+    EXPECT_EQ((view[Offset{Visibility, Visibility}]), Tile::TILE_PLAYER);
+    for(std::size_t cell = 0; cell < view.Data().size(); ++cell)
+    {
+      const Offset mapPosition = position + view.ToOffset(cell) - Offset{Visibility, Visibility};
+      if(view[cell] != Tile::TILE_UNKNOWN && view[cell] != Tile::TILE_PLAYER)
+      {
+        EXPECT_EQ(view[cell], dungeon.tiles[mapPosition]);
+      }
+    }
+  }
+}
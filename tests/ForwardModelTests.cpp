@@ -0,0 +1,232 @@
+#include "ForwardModel.h"
+#include "GameState.h"
+
+#include <gtest/gtest.h>
+
+#include <string_view>
+
+namespace
+{
+  using Bot::ForwardModel;
+  using Swoq::Interface::ActResult;
+  using Swoq::Interface::DirectedAction;
+  using Swoq::Interface::GameStatus;
+  using Swoq::Interface::Inventory;
+  using Swoq::Interface::Tile;
+
+  constexpr int Visibility = 5;
+
+  Tile TileFromChar(char c)
+  {
+    switch(c)
+    {
+    case '#':
+      return Tile::TILE_WALL;
+    case 'X':
+      return Tile::TILE_EXIT;
+    case 'D':
+      return Tile::TILE_DOOR_RED;
+    case 'k':
+      return Tile::TILE_KEY_RED;
+    case 'P':
+      return Tile::TILE_PRESSURE_PLATE_RED;
+    case 'b':
+      return Tile::TILE_BOULDER;
+    case 'e':
+      return Tile::TILE_ENEMY;
+    case 's':
+      return Tile::TILE_SWORD;
+    case 'h':
+      return Tile::TILE_HEALTH;
+    default:
+      return Tile::TILE_EMPTY;
+    }
+  }
+
+  Vector2d<Tile> MapFromRows(std::initializer_list<std::string_view> rows)
+  {
+    const int width = static_cast<int>(rows.begin()->size());
+    Vector2d<Tile> map(width, static_cast<int>(rows.size()));
+    int y = 0;
+    for(auto row: rows)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        map[Offset{x, y}] = TileFromChar(row[static_cast<std::size_t>(x)]);
+      }
+      ++y;
+    }
+    return map;
+  }
+
+  // The same level for the server; the enemies move from the tiles to the spawn list
+  Server::GameState ServerFor(std::initializer_list<std::string_view> rows, Offset start)
+  {
+    Server::Level level;
+    level.tiles = MapFromRows(rows);
+    level.players.push_back(start);
+    for(std::size_t i = 0; i < level.tiles.Data().size(); ++i)
+    {
+      if(level.tiles[i] == Tile::TILE_ENEMY)
+      {
+        level.tiles[i] = Tile::TILE_EMPTY;
+        level.enemies.push_back({level.tiles.ToOffset(i), std::nullopt});
+      }
+    }
+    return Server::GameState(std::move(level), Visibility);
+  }
+
+  ForwardModel ModelFor(std::initializer_list<std::string_view> rows, Offset start)
+  {
+    const std::array players{ForwardModel::PlayerStart{start}};
+    return ForwardModel::Create(MapFromRows(rows), players, Visibility).value();
+  }
+} // namespace
+
+TEST(ForwardModel, WallsBlockMoves)
+{
+  auto model = ModelFor({"#####", "#...#", "#####"}, {1, 1});
+  auto state = model.Initial();
+
+  EXPECT_EQ(model.Step(state, DirectedAction::DIRECTED_ACTION_MOVE_NORTH), ActResult::ACT_RESULT_MOVE_NOT_ALLOWED);
+  EXPECT_EQ(state.tick, 0);
+  EXPECT_EQ(model.Step(state, DirectedAction::DIRECTED_ACTION_MOVE_EAST), ActResult::ACT_RESULT_OK);
+  EXPECT_EQ(state.players[0].position, (Offset{2, 1}));
+  EXPECT_EQ(state.tick, 1);
+}
+
+TEST(ForwardModel, CloneIsIndependent)
+{
+  auto model = ModelFor({"#####", "#...#", "#####"}, {1, 1});
+  const auto original = model.Initial();
+
+  auto clone = original.Clone();
+  model.Step(clone, DirectedAction::DIRECTED_ACTION_MOVE_EAST);
+
+  EXPECT_EQ(original.players[0].position, (Offset{1, 1}));
+  EXPECT_EQ(clone.players[0].position, (Offset{2, 1}));
+}
+
+TEST(ForwardModel, KeyOpensDoorToExit)
+{
+  auto model = ModelFor({"######", "#.kDX#", "######"}, {1, 1});
+  auto state = model.Initial();
+
+  EXPECT_EQ(model.Step(state, DirectedAction::DIRECTED_ACTION_MOVE_EAST), ActResult::ACT_RESULT_OK);
+  EXPECT_EQ(state.players[0].inventory, Inventory::INVENTORY_KEY_RED);
+  EXPECT_EQ(model.Step(state, DirectedAction::DIRECTED_ACTION_MOVE_EAST), ActResult::ACT_RESULT_MOVE_NOT_ALLOWED);
+  EXPECT_EQ(model.Step(state, DirectedAction::DIRECTED_ACTION_USE_EAST), ActResult::ACT_RESULT_OK);
+  EXPECT_EQ(model.TileAt(state, {3, 1}), Tile::TILE_EMPTY);
+  EXPECT_EQ(model.Step(state, DirectedAction::DIRECTED_ACTION_MOVE_EAST), ActResult::ACT_RESULT_OK);
+  EXPECT_EQ(model.Step(state, DirectedAction::DIRECTED_ACTION_MOVE_EAST), ActResult::ACT_RESULT_OK);
+  EXPECT_EQ(state.status, GameStatus::GAME_STATUS_FINISHED_SUCCESS);
+}
+
+TEST(ForwardModel, BoulderOnPressurePlateKeepsDoorOpen)
+{
+  auto model = ModelFor({"#######", "#b.P#D#", "#######"}, {2, 1});
+  auto state = model.Initial();
+
+  EXPECT_EQ(model.Step(state, DirectedAction::DIRECTED_ACTION_USE_WEST), ActResult::ACT_RESULT_OK);
+  EXPECT_EQ(state.players[0].inventory, Inventory::INVENTORY_BOULDER);
+  EXPECT_EQ(model.TileAt(state, {5, 1}), Tile::TILE_DOOR_RED);
+
+  EXPECT_EQ(model.Step(state, DirectedAction::DIRECTED_ACTION_USE_EAST), ActResult::ACT_RESULT_OK);
+  EXPECT_EQ(state.players[0].inventory, Inventory::INVENTORY_NONE);
+  EXPECT_EQ(model.TileAt(state, {3, 1}), Tile::TILE_BOULDER);
+  EXPECT_EQ(model.TileAt(state, {5, 1}), Tile::TILE_EMPTY);
+}
+
+TEST(ForwardModel, EnemyAttacksEveryOtherTick)
+{
+  auto model = ModelFor({"#####", "#..e#", "#####"}, {2, 1});
+  auto state = model.Initial();
+
+  model.Step(state, DirectedAction::DIRECTED_ACTION_NONE);
+  EXPECT_EQ(state.players[0].health, ForwardModel::DefaultHealth);
+  model.Step(state, DirectedAction::DIRECTED_ACTION_NONE);
+  EXPECT_EQ(state.players[0].health, ForwardModel::DefaultHealth - 1);
+}
+
+TEST(ForwardModel, EnemyChasesVisiblePlayer)
+{
+  auto model = ModelFor({"#######", "#....e#", "#######"}, {1, 1});
+  auto state = model.Initial();
+
+  model.Step(state, DirectedAction::DIRECTED_ACTION_NONE);
+  model.Step(state, DirectedAction::DIRECTED_ACTION_NONE);
+
+  EXPECT_EQ(state.enemies[0].position, (Offset{4, 1}));
+}
+
+TEST(ForwardModel, SwordIsNeededToKillEnemy)
+{
+  auto model = ModelFor({"######", "#.s.e#", "######"}, {1, 1});
+  auto state = model.Initial();
+
+  model.Step(state, DirectedAction::DIRECTED_ACTION_MOVE_EAST);
+  EXPECT_TRUE(state.players[0].hasSword);
+  model.Step(state, DirectedAction::DIRECTED_ACTION_NONE);
+  ASSERT_EQ(state.enemies[0].position, (Offset{3, 1}));
+
+  EXPECT_EQ(model.Step(state, DirectedAction::DIRECTED_ACTION_USE_EAST), ActResult::ACT_RESULT_OK);
+  EXPECT_FALSE(state.enemies[0].alive);
+  EXPECT_EQ(model.TileAt(state, {3, 1}), Tile::TILE_EMPTY);
+}
+
+TEST(ForwardModel, RejectedSecondActionLeavesStateUnchanged)
+{
+  const std::array players{ForwardModel::PlayerStart{{1, 1}}, ForwardModel::PlayerStart{{3, 1}}};
+  auto model = ForwardModel::Create(MapFromRows({"#####", "#...#", "#####"}), players, Visibility).value();
+  auto state = model.Initial();
+
+  EXPECT_EQ(
+    model.Step(state, DirectedAction::DIRECTED_ACTION_MOVE_EAST, DirectedAction::DIRECTED_ACTION_MOVE_NORTH),
+    ActResult::ACT_RESULT_MOVE_NOT_ALLOWED);
+  EXPECT_EQ(state.players[0].position, (Offset{1, 1}));
+  EXPECT_EQ(state.tick, 0);
+}
+
+TEST(ForwardModel, TooManyEnemiesIsAnError)
+{
+  const std::array players{ForwardModel::PlayerStart{{1, 1}}};
+
+  auto model = ForwardModel::Create(MapFromRows({"########", "#.eeeee#", "########"}), players, Visibility);
+
+  ASSERT_FALSE(model);
+  EXPECT_EQ(model.error(), "More than 4 enemies");
+}
+
+TEST(ForwardModel, EnemiesMoveLikeOnTheServerInAnOpenRoom)
+{
+  // In line with the player, so there is a single shortest path
+  const std::initializer_list<std::string_view> rows{"########", "#.....e#", "#......#", "########"};
+  auto model = ModelFor(rows, {1, 1});
+  auto server = ServerFor(rows, {1, 1});
+  auto state = model.Initial();
+
+  for(int tick = 0; tick < 6; ++tick)
+  {
+    ASSERT_EQ(model.Step(state, DirectedAction::DIRECTED_ACTION_NONE), ActResult::ACT_RESULT_OK);
+    ASSERT_EQ(server.Act(std::nullopt, std::nullopt), ActResult::ACT_RESULT_OK);
+    ASSERT_EQ(server.TileAt(state.enemies[0].position), Tile::TILE_ENEMY) << "tick " << tick;
+  }
+}
+
+// The documented difference: a greedy enemy waits behind a boulder, the server's enemy walks around it
+TEST(ForwardModel, EnemyWaitsBehindABoulderWhereTheServerWalksAround)
+{
+  const std::initializer_list<std::string_view> rows{"#######", "#..b.e#", "#.....#", "#######"};
+  auto model = ModelFor(rows, {1, 1});
+  auto server = ServerFor(rows, {1, 1});
+  auto state = model.Initial();
+
+  for(int tick = 0; tick < 4; ++tick)
+  {
+    model.Step(state, DirectedAction::DIRECTED_ACTION_NONE);
+    server.Act(std::nullopt, std::nullopt);
+  }
+
+  EXPECT_EQ(state.enemies[0].position, (Offset{4, 1}));
+  EXPECT_NE(server.TileAt({4, 1}), Tile::TILE_ENEMY);
+}
@@ -0,0 +1,189 @@
+#include "Logging.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  using namespace Bot;
+
+  constexpr Log::Logger<Log::Category::Game> gameLogger;
+  constexpr Log::Logger<Log::Category::Path> pathLogger;
+
+  class LoggingTest : public testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      Log::Flush();
+      Log::SetSink(
+        [this](std::string_view line)
+        {
+          std::lock_guard lock(m_mutex);
+          m_lines.emplace_back(line);
+        });
+      ASSERT_TRUE(Log::Configure("info"));
+    }
+
+    void TearDown() override
+    {
+      Log::Flush();
+      Log::SetSink({});
+      ASSERT_TRUE(Log::Configure("info"));
+    }
+
+    std::vector<std::string> Lines()
+    {
+      Log::Flush();
+      std::lock_guard lock(m_mutex);
+      return m_lines;
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::vector<std::string> m_lines;
+  };
+} // namespace
+
+TEST_F(LoggingTest, FormatsInOrder)
+{
+  for(int i = 0; i < 1000; ++i)
+  {
+    gameLogger.Info("message {} of {}", i, 1000);
+  }
+
+  const auto lines = Lines();
+  ASSERT_EQ(lines.size(), 1000u);
+  for(int i = 0; i < 1000; ++i)
+  {
+    EXPECT_EQ(lines[static_cast<std::size_t>(i)], std::format("message {} of {}", i, 1000));
+  }
+}
+
+TEST_F(LoggingTest, CopiesArgumentsThatDoNotFitOrOutliveTheCall)
+{
+  {
+    std::string temporary = "gone by now";
+    const std::vector<int> large(100, 7);
+    gameLogger.Warning("{} {} {}", temporary.c_str(), std::string_view(temporary), large.size());
+    temporary.assign(temporary.size(), 'x');
+  }
+  gameLogger.Error("{}", std::string(200, 'y'));
+
+  const auto lines = Lines();
+  ASSERT_EQ(lines.size(), 2u);
+  EXPECT_EQ(lines[0], "Warning: gone by now gone by now 100");
+  EXPECT_EQ(lines[1], "Error: " + std::string(200, 'y'));
+}
+
+TEST_F(LoggingTest, LevelsArePerCategory)
+{
+  ASSERT_TRUE(Log::Configure("warning,path=debug"));
+  EXPECT_EQ(Log::GetLevel(Log::Category::Game), Log::Level::Warning);
+  EXPECT_EQ(Log::GetLevel(Log::Category::Path), Log::Level::Debug);
+
+  gameLogger.Info("hidden");
+  gameLogger.Warning("shown");
+  pathLogger.Debug("path {}", 1);
+  pathLogger.Trace("compiled out");
+
+  EXPECT_EQ(Lines(), (std::vector<std::string>{"Warning: shown", "path 1"}));
+}
+
+TEST_F(LoggingTest, RejectsUnknownNames)
+{
+  EXPECT_FALSE(Log::Configure("loud"));
+  EXPECT_FALSE(Log::Configure("info,dungeon=debug"));
+}
+
+TEST_F(LoggingTest, ThreadsLogConcurrently)
+{
+  std::vector<std::jthread> threads;
+  for(int thread = 0; thread < 4; ++thread)
+  {
+    threads.emplace_back(
+      [thread]
+      {
+        for(int i = 0; i < 1000; ++i)
+        {
+          gameLogger.Info("{} {}", thread, i);
+        }
+      });
+  }
+  threads.clear();
+
+  const auto lines = Lines();
+  ASSERT_EQ(lines.size(), 4000u);
+  std::vector<int> next(4, 0);
+  for(const auto& line: lines)
+  {
+    const auto thread = static_cast<std::size_t>(line[0] - '0');
+    EXPECT_EQ(line, std::format("{} {}", thread, next[thread]++));
+  }
+}
+
+TEST_F(LoggingTest, AFullRingDoesNotBlockTheLogger)
+{
+  std::promise<void> printing;
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::vector<std::string> lines;
+  Log::SetSink(
+    [&, first = true](std::string_view line) mutable
+    {
+      if(std::exchange(first, false))
+      {
+        printing.set_value();
+        released.wait();
+      }
+      lines.emplace_back(line);
+    });
+
+  gameLogger.Info("first");
+  printing.get_future().wait();
+  // The backend is stuck printing, so most of these don't fit in the ring
+  auto logging = std::async(
+    std::launch::async,
+    []
+    {
+      for(int i = 0; i < 2000; ++i)
+      {
+        gameLogger.Info("{}", i);
+      }
+    });
+  const auto status = logging.wait_for(std::chrono::seconds(10));
+  release.set_value();
+  EXPECT_EQ(status, std::future_status::ready);
+  logging.wait();
+  Log::Flush();
+
+  ASSERT_EQ(lines.size(), 2001u);
+  EXPECT_EQ(lines[0], "first");
+  for(std::size_t i = 0; i < 2000; ++i)
+  {
+    EXPECT_EQ(lines[i + 1], std::to_string(i));
+  }
+}
+
+TEST_F(LoggingTest, LinesOfAGameArePrefixedWithItsIndex)
+{
+  gameLogger.Info("before");
+  {
+    const Log::GameScope game(3);
+    gameLogger.Warning("inside");
+    {
+      const Log::GameScope other(std::nullopt);
+      gameLogger.Info("nested");
+    }
+    EXPECT_EQ(Log::CurrentGame(), 3u);
+  }
+  gameLogger.Info("after");
+
+  EXPECT_EQ(Lines(), (std::vector<std::string>{"before", "[game 3] Warning: inside", "nested", "after"}));
+}
@@ -0,0 +1,92 @@
+#include "Metrics.h"
+
+#include <gtest/gtest.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "TestFolder.h"
+
+namespace
+{
+  using namespace Bot;
+
+  std::string Get(const std::string& socketPath, std::string_view request)
+  {
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::ranges::copy(socketPath, address.sun_path);
+    if(connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+      close(fd);
+      return {};
+    }
+
+    send(fd, request.data(), request.size(), 0);
+    std::string response;
+    std::array<char, 4096> buffer{};
+    for(ssize_t received; (received = recv(fd, buffer.data(), buffer.size(), 0)) > 0;)
+      response.append(buffer.data(), static_cast<std::size_t>(received));
+    close(fd);
+    return response;
+  }
+} // namespace
+
+TEST(Metrics, HistogramIsCumulative)
+{
+  Metrics::Histogram histogram;
+  histogram.Record(std::chrono::microseconds(50));
+  histogram.Record(std::chrono::milliseconds(3));
+  histogram.Record(std::chrono::seconds(20));
+
+  std::string out;
+  histogram.Write(out, "h", R"(player="1",)");
+  EXPECT_NE(out.find("h_bucket{player=\"1\",le=\"0.0001\"} 1\n"), std::string::npos) << out;
+  EXPECT_NE(out.find("h_bucket{player=\"1\",le=\"0.0025\"} 1\n"), std::string::npos);
+  EXPECT_NE(out.find("h_bucket{player=\"1\",le=\"0.005\"} 2\n"), std::string::npos);
+  EXPECT_NE(out.find("h_bucket{player=\"1\",le=\"10\"} 2\n"), std::string::npos);
+  EXPECT_NE(out.find("h_bucket{player=\"1\",le=\"+Inf\"} 3\n"), std::string::npos);
+  EXPECT_NE(out.find("h_sum{player=\"1\"} 20.00305\n"), std::string::npos);
+  EXPECT_NE(out.find("h_count{player=\"1\"} 3\n"), std::string::npos);
+}
+
+TEST(Metrics, ServesCountersOverUnixSocket)
+{
+  const TestFolder folder;
+  const auto path = (folder / "metrics.sock").string();
+  auto server = Metrics::Server::Start("unix:" + path);
+  ASSERT_TRUE(server) << server.error();
+
+  Metrics::CountTick();
+  Metrics::SetLevel("game-1", 4);
+  Metrics::CountMapSnapshot(Metrics::MapKind::Dungeon);
+  Metrics::CountDistanceMap();
+  {
+    Metrics::ScopedLatency latency(Metrics::Latency::Act);
+  }
+
+  const auto response = Get(path, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  EXPECT_TRUE(response.starts_with("HTTP/1.0 200 OK\r\n")) << response;
+  EXPECT_NE(response.find("\nswoq_ticks_total 1\n"), std::string::npos) << response;
+  EXPECT_NE(response.find("\nswoq_game_level{game=\"game-1\"} 4\n"), std::string::npos);
+  EXPECT_NE(response.find("\nswoq_map_snapshots_total{map=\"dungeon\"} 1\n"), std::string::npos);
+  EXPECT_NE(response.find("\nswoq_distance_map_calls_total 1\n"), std::string::npos);
+  EXPECT_NE(response.find("\nswoq_act_seconds_count 1\n"), std::string::npos);
+  // Scraping doesn't change what the next scraper sees
+  EXPECT_EQ(Get(path, "GET /metrics HTTP/1.1\r\n\r\n"), response);
+
+  Metrics::RemoveGame("game-1");
+  EXPECT_EQ(Get(path, "GET /metrics HTTP/1.1\r\n\r\n").find("game-1"), std::string::npos);
+  EXPECT_TRUE(Get(path, "GET /other HTTP/1.1\r\n\r\n").starts_with("HTTP/1.0 404"));
+}
+
+TEST(Metrics, RejectsInvalidAddresses)
+{
+  EXPECT_FALSE(Metrics::Server::Start("no-port"));
+  EXPECT_FALSE(Metrics::Server::Start("localhost:9100"));
+  EXPECT_FALSE(Metrics::Server::Start(":99999"));
+  EXPECT_FALSE(Metrics::Server::Start("unix:"));
+}
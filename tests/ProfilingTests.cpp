@@ -0,0 +1,76 @@
+#include "Profiling.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+
+using Bot::Profiling::Histogram;
+using namespace std::chrono_literals;
+
+TEST(Histogram, EmptyHistogramReportsZero)
+{
+  Histogram histogram;
+  EXPECT_EQ(histogram.Count(), 0u);
+  EXPECT_EQ(histogram.Percentile(50), 0ns);
+  EXPECT_EQ(histogram.Max(), 0ns);
+}
+
+TEST(Histogram, SmallValuesAreExact)
+{
+  Histogram histogram;
+  for(int i = 1; i <= 50; ++i)
+  {
+    histogram.Record(std::chrono::nanoseconds(i));
+  }
+  EXPECT_EQ(histogram.Count(), 50u);
+  EXPECT_EQ(histogram.Percentile(50), 25ns);
+  EXPECT_EQ(histogram.Percentile(90), 45ns);
+  EXPECT_EQ(histogram.Percentile(100), 50ns);
+  EXPECT_EQ(histogram.Max(), 50ns);
+}
+
+TEST(Histogram, BucketsAreContiguous)
+{
+  for(std::size_t index = 0; index + 1 < Histogram::BucketCount; ++index)
+  {
+    const auto upper = Histogram::BucketUpperBound(index);
+    ASSERT_EQ(Histogram::BucketIndex(upper), index);
+    ASSERT_EQ(Histogram::BucketIndex(upper + 1), index + 1);
+  }
+  EXPECT_EQ(Histogram::BucketUpperBound(Histogram::BucketCount - 1), std::numeric_limits<std::uint64_t>::max());
+}
+
+TEST(Histogram, PercentilesAreAccurate)
+{
+  Histogram histogram;
+  for(int i = 1; i <= 1000; ++i)
+  {
+    histogram.Record(std::chrono::microseconds(i));
+  }
+
+  for(double percentile: {50.0, 90.0, 99.0})
+  {
+    const auto expected = std::chrono::duration<double, std::micro>(percentile * 10);
+    const auto actual = std::chrono::duration<double, std::micro>(histogram.Percentile(percentile));
+    EXPECT_GE(actual, expected);
+    EXPECT_LE(actual, expected * (1.0 + 1.0 / Histogram::SubBuckets)) << percentile;
+  }
+  EXPECT_EQ(histogram.Max(), 1000us);
+}
+
+TEST(Histogram, MergeAddsCounts)
+{
+  Histogram first;
+  Histogram second;
+  first.Record(10ns);
+  second.Record(20ns);
+  second.Record(30ns);
+
+  first.Merge(second);
+  EXPECT_EQ(first.Count(), 3u);
+  EXPECT_EQ(first.Percentile(50), 20ns);
+  EXPECT_EQ(first.Max(), 30ns);
+
+  first.Reset();
+  EXPECT_EQ(first.Count(), 0u);
+}
@@ -0,0 +1,365 @@
+#include "Replay.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "TestFolder.h"
+
+namespace
+{
+  using namespace Swoq::Interface;
+  namespace fs = std::filesystem;
+
+  constexpr int Acts = 3;
+
+  ActRequest Request(DirectedAction action)
+  {
+    ActRequest request;
+    request.set_gameid("replay");
+    request.set_action(action);
+    return request;
+  }
+
+  ActResponse Response(int tick, ActResult result = ActResult::ACT_RESULT_OK)
+  {
+    ActResponse response;
+    response.set_result(result);
+    response.mutable_state()->set_tick(tick);
+    return response;
+  }
+
+  // The folder also holds the index
+  fs::path ReplayIn(const fs::path& folder)
+  {
+    for(const auto& entry: fs::directory_iterator(folder))
+    {
+      if(entry.path().extension() == ".swoq")
+        return entry.path();
+    }
+    return {};
+  }
+
+  std::expected<std::unique_ptr<Swoq::ReplayFile>, std::string> CreateReplay(const fs::path& folder)
+  {
+    StartRequest request;
+    request.set_username("tester");
+    StartResponse response;
+    response.set_gameid("replay");
+    response.set_mapwidth(9);
+    response.set_mapheight(7);
+    response.set_seed(42);
+    return Swoq::ReplayFile::create(folder.string(), request, response);
+  }
+
+  // Records a game of moves east and returns the path of the replay
+  fs::path WriteReplay(const fs::path& folder, int acts = Acts)
+  {
+    {
+      auto replay = CreateReplay(folder);
+      EXPECT_TRUE(replay);
+      for(int tick = 1; tick <= acts; ++tick)
+      {
+        EXPECT_TRUE((*replay)->append(Request(DirectedAction::DIRECTED_ACTION_MOVE_EAST), Response(tick)));
+      }
+    }
+
+    return ReplayIn(folder);
+  }
+
+  // A player walking through a striped world, so consecutive views overlap like in a real game
+  fs::path WriteWalkingReplay(const fs::path& folder, int acts)
+  {
+    constexpr int Visibility = 4;
+    constexpr int Dimension = 2 * Visibility + 1;
+    const auto fill_state = [](State& state, int tick)
+    {
+      state.set_tick(tick);
+      state.set_level(tick < 50 ? 1 : 2);
+      auto& player = *state.mutable_playerstate();
+      const int x = 10 + tick % 40;
+      const int y = 10 + (tick / 40) % 3;
+      player.mutable_position()->set_x(x);
+      player.mutable_position()->set_y(y);
+      player.clear_surroundings();
+      for(int dy = -Visibility; dy <= Visibility; ++dy)
+      {
+        for(int dx = -Visibility; dx <= Visibility; ++dx)
+        {
+          const int wx = x + dx;
+          const int wy = y + dy;
+          player.add_surroundings((wx * 7 + wy * 3) % 5 == 0 ? Tile::TILE_WALL : Tile::TILE_EMPTY);
+        }
+      }
+      EXPECT_EQ(player.surroundings_size(), Dimension * Dimension);
+    };
+
+    StartRequest request;
+    request.set_username("walker");
+    StartResponse response;
+    response.set_gameid("walk");
+    response.set_visibilityrange(Visibility);
+    fill_state(*response.mutable_state(), 0);
+
+    {
+      auto replay = Swoq::ReplayFile::create(folder.string(), request, response);
+      EXPECT_TRUE(replay);
+      for(int tick = 1; tick <= acts; ++tick)
+      {
+        ActResponse act_response;
+        fill_state(*act_response.mutable_state(), tick);
+        EXPECT_TRUE((*replay)->append(Request(DirectedAction::DIRECTED_ACTION_MOVE_EAST), std::move(act_response)));
+      }
+    }
+
+    return ReplayIn(folder);
+  }
+
+  std::string ReadFile(const fs::path& path)
+  {
+    std::ifstream stream(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+  }
+
+  class Replay : public testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      fs::create_directories(m_folder);
+      fs::create_directories(m_converted);
+    }
+
+    TestFolder m_test;
+    // The recorder writes one replay into m_folder, conversions go elsewhere
+    fs::path m_folder = m_test / "replays";
+    fs::path m_converted = m_test / "converted";
+  };
+} // namespace
+
+TEST_F(Replay, ReaderReturnsRecordsInOrder)
+{
+  auto reader = Swoq::ReplayReader::open(WriteReplay(m_folder));
+  ASSERT_TRUE(reader);
+  EXPECT_EQ((*reader)->start_request().username(), "tester");
+  EXPECT_EQ((*reader)->start_response().seed(), 42);
+
+  ActRequest request;
+  ActResponse response;
+  for(int tick = 1; tick <= Acts; ++tick)
+  {
+    auto next = (*reader)->next(request, response);
+    ASSERT_TRUE(next && *next);
+    EXPECT_EQ(request.action(), DirectedAction::DIRECTED_ACTION_MOVE_EAST);
+    EXPECT_EQ(response.state().tick(), tick);
+  }
+
+  auto end = (*reader)->next(request, response);
+  ASSERT_TRUE(end);
+  EXPECT_FALSE(*end);
+  EXPECT_FALSE((*reader)->truncated());
+}
+
+TEST_F(Replay, RecordsAreWrittenInBatches)
+{
+  auto replay = CreateReplay(m_folder);
+  ASSERT_TRUE(replay);
+  const auto index = Swoq::replay_index_path(ReplayIn(m_folder));
+  // The magic is buffered until the first batch
+  const auto entries = [&]
+  {
+    const auto size = std::max<std::uintmax_t>(fs::file_size(index), Swoq::ReplayIndexMagic.size());
+    return (size - Swoq::ReplayIndexMagic.size()) / sizeof(Swoq::ReplayIndexEntry);
+  };
+
+  // With the start, one act short of a batch. Well within FlushInterval, so nothing is written yet.
+  const int acts = static_cast<int>(Swoq::ReplayFile::BatchSize) - 1;
+  for(int tick = 1; tick < acts; ++tick)
+  {
+    ASSERT_TRUE((*replay)->append(Request(DirectedAction::DIRECTED_ACTION_MOVE_EAST), Response(tick)));
+  }
+  std::this_thread::sleep_for(Swoq::ReplayFile::FlushInterval / 10);
+  EXPECT_EQ(entries(), 0u);
+
+  ASSERT_TRUE((*replay)->append(Request(DirectedAction::DIRECTED_ACTION_MOVE_EAST), Response(acts)));
+  const auto deadline = std::chrono::steady_clock::now() + Swoq::ReplayFile::FlushInterval / 2;
+  while(entries() == 0 && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(entries(), static_cast<std::size_t>(acts));
+}
+
+TEST_F(Replay, LongRecordingRoundTrips)
+{
+  const int acts = 3 * static_cast<int>(Swoq::ReplayFile::BatchSize) + 5;
+  auto reader = Swoq::ReplayReader::open(WriteReplay(m_folder, acts));
+  ASSERT_TRUE(reader);
+
+  ActRequest request;
+  ActResponse response;
+  int tick = 0;
+  while((*reader)->next(request, response).value_or(false))
+  {
+    EXPECT_EQ(response.state().tick(), ++tick);
+  }
+  EXPECT_EQ(tick, acts);
+}
+
+TEST_F(Replay, TruncatedRecordEndsReplay)
+{
+  auto path = WriteReplay(m_folder);
+  fs::resize_file(path, fs::file_size(path) - 1);
+
+  auto reader = Swoq::ReplayReader::open(path);
+  ASSERT_TRUE(reader);
+
+  ActRequest request;
+  ActResponse response;
+  int acts = 0;
+  while((*reader)->next(request, response).value_or(false))
+  {
+    ++acts;
+  }
+  EXPECT_EQ(acts, Acts - 1);
+  EXPECT_TRUE((*reader)->truncated());
+}
+
+TEST_F(Replay, MissingFileIsAnError) { EXPECT_FALSE(Swoq::ReplayReader::open(m_folder / "missing.swoq")); }
+
+TEST_F(Replay, GameFollowsRecording)
+{
+  auto game = Swoq::ReplayGame::open(WriteReplay(m_folder));
+  ASSERT_TRUE(game);
+  EXPECT_EQ((*game)->map_width(), 9);
+  EXPECT_EQ((*game)->map_height(), 7);
+
+  EXPECT_TRUE((*game)->act(DirectedAction::DIRECTED_ACTION_MOVE_EAST, std::nullopt));
+  EXPECT_EQ((*game)->state().tick(), 1);
+  EXPECT_TRUE((*game)->act_start(DirectedAction::DIRECTED_ACTION_MOVE_WEST, std::nullopt));
+  EXPECT_TRUE((*game)->act_in_flight());
+  EXPECT_TRUE((*game)->act_finish());
+  EXPECT_EQ((*game)->state().tick(), 2);
+  EXPECT_TRUE((*game)->act(DirectedAction::DIRECTED_ACTION_MOVE_EAST, std::nullopt));
+
+  EXPECT_FALSE((*game)->act(DirectedAction::DIRECTED_ACTION_MOVE_EAST, std::nullopt));
+  EXPECT_EQ((*game)->ticks(), Acts);
+  EXPECT_EQ((*game)->divergences(), 1);
+}
+
+TEST_F(Replay, CompactFormatReproducesResponses)
+{
+  constexpr int Acts = 120;
+  const auto original = WriteWalkingReplay(m_folder, Acts);
+  const auto compact = m_converted / "walk.swoq2";
+  ASSERT_TRUE(Swoq::convert_replay(original, compact, Swoq::ReplayFormat::V2, 30));
+  EXPECT_LT(fs::file_size(compact) * 2, fs::file_size(original));
+
+  auto expected = Swoq::ReplayReader::open(original);
+  auto actual = Swoq::ReplayReader::open(compact);
+  ASSERT_TRUE(expected && actual);
+  EXPECT_EQ((*actual)->format(), Swoq::ReplayFormat::V2);
+
+  ActRequest expected_request, actual_request;
+  ActResponse expected_response, actual_response;
+  int acts = 0;
+  while((*expected)->next(expected_request, expected_response).value_or(false))
+  {
+    auto next = (*actual)->next(actual_request, actual_response);
+    ASSERT_TRUE(next && *next);
+    EXPECT_EQ(actual_request.SerializeAsString(), expected_request.SerializeAsString());
+    EXPECT_EQ(actual_response.SerializeAsString(), expected_response.SerializeAsString()) << "act " << acts;
+    ++acts;
+  }
+  EXPECT_EQ(acts, Acts);
+  EXPECT_FALSE((*actual)->next(actual_request, actual_response).value_or(true));
+}
+
+TEST_F(Replay, ConvertingBackRestoresOriginal)
+{
+  const auto original = WriteWalkingReplay(m_folder, 80);
+  const auto compact = m_converted / "walk.swoq2";
+  const auto restored = m_converted / "walk.swoq";
+  ASSERT_TRUE(Swoq::convert_replay(original, compact, Swoq::ReplayFormat::V2));
+  ASSERT_TRUE(Swoq::convert_replay(compact, restored, Swoq::ReplayFormat::V1));
+
+  EXPECT_EQ(ReadFile(restored), ReadFile(original));
+}
+
+TEST_F(Replay, IndexHasEveryAct)
+{
+  const int acts = 2 * static_cast<int>(Swoq::ReplayFile::BatchSize) + 3;
+  auto reader = Swoq::ReplayReader::open(WriteWalkingReplay(m_folder, acts));
+  ASSERT_TRUE(reader);
+
+  const auto index = (*reader)->index();
+  ASSERT_EQ(index.size(), static_cast<std::size_t>(acts));
+  for(std::size_t i = 0; i < index.size(); ++i)
+  {
+    EXPECT_EQ(index[i].tick, static_cast<int>(i) + 1);
+    EXPECT_EQ(index[i].level, index[i].tick < 50 ? 1 : 2);
+  }
+}
+
+TEST_F(Replay, SeeksToTickAndLevel)
+{
+  auto reader = Swoq::ReplayReader::open(WriteWalkingReplay(m_folder, 80));
+  ASSERT_TRUE(reader);
+
+  ActRequest request;
+  ActResponse response;
+  ASSERT_TRUE((*reader)->seek_tick(70));
+  ASSERT_TRUE((*reader)->next(request, response).value_or(false));
+  EXPECT_EQ(response.state().tick(), 70);
+
+  ASSERT_TRUE((*reader)->seek_level(2));
+  ASSERT_TRUE((*reader)->next(request, response).value_or(false));
+  EXPECT_EQ(response.state().tick(), 50);
+  EXPECT_EQ(response.state().level(), 2);
+
+  EXPECT_FALSE((*reader)->seek_tick(81));
+}
+
+TEST_F(Replay, SeeksInCompactFormat)
+{
+  const auto original = WriteWalkingReplay(m_folder, 120);
+  const auto compact = m_converted / "walk.swoq2";
+  ASSERT_TRUE(Swoq::convert_replay(original, compact, Swoq::ReplayFormat::V2, 30));
+
+  auto expected = Swoq::ReplayReader::open(original);
+  auto actual = Swoq::ReplayReader::open(compact);
+  ASSERT_TRUE(expected && actual);
+  ASSERT_EQ((*actual)->index().size(), 120u);
+
+  ActRequest expected_request, actual_request;
+  ActResponse expected_response, actual_response;
+  for(int tick: {100, 45, 51, 1, 120})
+  {
+    ASSERT_TRUE((*expected)->seek_tick(tick));
+    ASSERT_TRUE((*actual)->seek_tick(tick));
+    ASSERT_TRUE((*expected)->next(expected_request, expected_response).value_or(false));
+    ASSERT_TRUE((*actual)->next(actual_request, actual_response).value_or(false));
+    EXPECT_EQ(actual_response.SerializeAsString(), expected_response.SerializeAsString()) << "tick " << tick;
+  }
+}
+
+TEST_F(Replay, TruncatedIndexIsIgnoredPastTheEnd)
+{
+  auto path = WriteReplay(m_folder, 10);
+  std::uint64_t ninth = 0;
+  {
+    auto reader = Swoq::ReplayReader::open(path);
+    ASSERT_TRUE(reader);
+    ninth = (*reader)->index()[8].offset;
+  }
+  const auto index = Swoq::replay_index_path(path);
+  fs::resize_file(index, fs::file_size(index) - 1);
+  fs::resize_file(path, ninth);
+
+  auto reader = Swoq::ReplayReader::open(path);
+  ASSERT_TRUE(reader);
+  EXPECT_EQ((*reader)->index().size(), 8u);
+}
@@ -0,0 +1,44 @@
+#include "Runner.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+using Bot::GameResult;
+
+namespace
+{
+  GameResult Result(int level, bool success, std::chrono::milliseconds duration)
+  {
+    GameResult result;
+    result.level = level;
+    result.success = success;
+    result.duration = duration;
+    return result;
+  }
+} // namespace
+
+TEST(Runner, SummarizeEmpty)
+{
+  auto summary = Bot::Summarize({}, 0ms);
+  EXPECT_EQ(summary.games, 0u);
+  EXPECT_EQ(summary.successes, 0u);
+  EXPECT_TRUE(summary.levelsReached.empty());
+}
+
+TEST(Runner, SummarizeAggregatesResults)
+{
+  const std::vector results{Result(3, true, 100ms), Result(5, false, 300ms), Result(3, true, 200ms)};
+
+  auto summary = Bot::Summarize(results, 1h);
+
+  EXPECT_EQ(summary.games, 3u);
+  EXPECT_EQ(summary.successes, 2u);
+  EXPECT_EQ(summary.levelsReached.at(3), 2u);
+  EXPECT_EQ(summary.levelsReached.at(5), 1u);
+  EXPECT_EQ(summary.fastest, 100ms);
+  EXPECT_EQ(summary.slowest, 300ms);
+  EXPECT_EQ(summary.mean, 200ms);
+  EXPECT_DOUBLE_EQ(summary.gamesPerHour, 3.0);
+}
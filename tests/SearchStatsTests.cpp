@@ -0,0 +1,103 @@
+#include "SearchStats.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "Dijkstra.h"
+#include "TestFolder.h"
+
+using namespace Bot;
+
+TEST(SearchStats, RecordAddsUpPerCaller)
+{
+  SearchStats::Stats stats;
+  stats.Record(
+    "Explore",
+    {.popped = 10, .relaxations = 12, .queueHighWater = 4, .exit = SearchStats::Exit::Destination, .expanded = {}},
+    {5, 5});
+  stats.Record(
+    "Explore",
+    {.popped = 25, .relaxations = 30, .queueHighWater = 3, .exit = SearchStats::Exit::Exhausted, .expanded = {}},
+    {5, 5});
+
+  const auto totals = stats.Totals();
+  ASSERT_EQ(totals.size(), 1u);
+  const auto& counts = totals.at("Explore");
+  EXPECT_EQ(counts.calls, 2u);
+  EXPECT_EQ(counts.exits[static_cast<std::size_t>(SearchStats::Exit::Destination)], 1u);
+  EXPECT_EQ(counts.exits[static_cast<std::size_t>(SearchStats::Exit::Exhausted)], 1u);
+  EXPECT_EQ(counts.popped, 35u);
+  EXPECT_EQ(counts.relaxations, 42u);
+  EXPECT_EQ(counts.maxPopped, 25u);
+  EXPECT_EQ(counts.maxQueue, 4u);
+
+  stats.Reset();
+  EXPECT_TRUE(stats.Totals().empty());
+}
+
+TEST(SearchStats, GamesCountSeparately)
+{
+  SearchStats::Stats first;
+  SearchStats::Stats second;
+  first.Record("Explore", {}, {5, 5});
+  second.Record("Attack", {}, {5, 5});
+
+  first.Reset();
+
+  EXPECT_TRUE(first.Totals().empty());
+  ASSERT_EQ(second.Totals().size(), 1u);
+  EXPECT_EQ(second.Totals().at("Attack").calls, 1u);
+}
+
+TEST(SearchStats, HeatmapCountsExpandedCells)
+{
+  SearchStats::Stats stats(true);
+  stats.Record("Explore", {.expanded = {{0, 0}, {2, 1}}}, {3, 2});
+  stats.Record("Explore", {.expanded = {{2, 1}}}, {3, 2});
+
+  const TestFolder folder;
+  const auto path = folder / "heatmap.csv";
+  ASSERT_TRUE(stats.WriteHeatmap(path));
+  std::ifstream stream(path);
+  const std::string contents{std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+  EXPECT_EQ(contents, "1,0,0\n0,0,2\n");
+}
+
+TEST(SearchStats, OutermostScopeNamesTheSearches)
+{
+  if constexpr(!Profiling::Enabled)
+    GTEST_SKIP() << "Scopes only name searches with BOT_PROFILING";
+
+  std::array<std::string_view, 2> slots{};
+  {
+    SearchStats::Scope hunt(slots[0], "HuntEnemies");
+    {
+      SearchStats::Scope visit(slots[0], "Visit");
+      SearchStats::Scope explore(slots[1], "Explore");
+      EXPECT_EQ(slots[0], "HuntEnemies");
+      EXPECT_EQ(slots[1], "Explore");
+    }
+    EXPECT_EQ(slots[0], "HuntEnemies");
+    EXPECT_TRUE(slots[1].empty());
+  }
+  EXPECT_TRUE(slots[0].empty());
+}
+
+TEST(SearchStats, DistanceMapCountsForItsCaller)
+{
+  if constexpr(!Profiling::Enabled)
+    GTEST_SKIP() << "Searches are only counted with BOT_PROFILING";
+
+  SearchStats::Stats stats(true);
+  const Vector2d<int> weights(3, 1, 1);
+  DistanceMap(weights, {0, 0}, [](Offset p) { return p == Offset(2, 0); }, {&stats, "Explore"});
+  DistanceMap(weights, {0, 0}, [](Offset) { return false; });
+
+  const auto totals = stats.Totals();
+  ASSERT_EQ(totals.size(), 1u);
+  const auto& counts = totals.at("Explore");
+  EXPECT_EQ(counts.calls, 1u);
+  EXPECT_EQ(counts.exits[static_cast<std::size_t>(SearchStats::Exit::Destination)], 1u);
+  EXPECT_EQ(counts.popped, 3u);
+}
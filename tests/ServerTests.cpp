@@ -0,0 +1,218 @@
+#include "GameService.h"
+#include "GameState.h"
+#include "LevelGenerator.h"
+
+#include <gtest/gtest.h>
+
+#include <deque>
+
+namespace
+{
+  using Swoq::Interface::ActResult;
+  using Swoq::Interface::DirectedAction;
+  using Swoq::Interface::GameStatus;
+  using Swoq::Interface::Tile;
+
+  constexpr Offset MapSize{31, 31};
+  constexpr int Visibility = 4;
+
+  Offset Find(const Vector2d<Tile>& tiles, Tile tile)
+  {
+    auto it = std::ranges::find(tiles.Data(), tile);
+    return tiles.ToOffset(static_cast<std::size_t>(it - tiles.Data().begin()));
+  }
+
+  bool IsReachable(const Vector2d<Tile>& tiles, Offset from, Offset to, bool doorsAreOpen)
+  {
+    auto passable = [&](Offset p)
+    {
+      const Tile tile = tiles[p];
+      const bool isDoor = tile == Tile::TILE_DOOR_RED || tile == Tile::TILE_DOOR_GREEN || tile == Tile::TILE_DOOR_BLUE;
+      return tile != Tile::TILE_WALL && (doorsAreOpen || !isDoor);
+    };
+
+    Vector2d<int> visited(tiles.Width(), tiles.Height(), 0);
+    std::deque<Offset> queue{from};
+    visited[from] = 1;
+    while(!queue.empty())
+    {
+      const Offset current = queue.front();
+      queue.pop_front();
+      if(current == to)
+        return true;
+      for(auto direction: Directions)
+      {
+        const Offset next = current + direction;
+        if(tiles.IsInRange(next) && visited[next] == 0 && passable(next))
+        {
+          visited[next] = 1;
+          queue.push_back(next);
+        }
+      }
+    }
+    return false;
+  }
+
+  // The single room of level 0 has nothing in the way
+  DirectedAction StepTowards(Offset position, Offset destination)
+  {
+    return position.x < destination.x ? DirectedAction::DIRECTED_ACTION_MOVE_EAST
+         : position.x > destination.x ? DirectedAction::DIRECTED_ACTION_MOVE_WEST
+         : position.y < destination.y ? DirectedAction::DIRECTED_ACTION_MOVE_SOUTH
+                                      : DirectedAction::DIRECTED_ACTION_MOVE_NORTH;
+  }
+
+  void WalkToExit(Server::Quest& quest, std::uint32_t seed)
+  {
+    const Offset exit = Find(Server::GenerateLevel(0, seed, MapSize).tiles, Tile::TILE_EXIT);
+    while(auto position = quest.State().PlayerPosition(0))
+    {
+      ASSERT_EQ(quest.Act(StepTowards(*position, exit), std::nullopt), ActResult::ACT_RESULT_OK);
+      if(quest.LevelNumber() != 0)
+        return;
+    }
+  }
+} // namespace
+
+TEST(Server, LevelsAreDeterministicPerSeed)
+{
+  for(int level = 0; level <= Server::MaxLevel; ++level)
+  {
+    auto first = Server::GenerateLevel(level, 42, MapSize);
+    auto second = Server::GenerateLevel(level, 42, MapSize);
+
+    EXPECT_EQ(first.tiles.Data(), second.tiles.Data()) << "level " << level;
+    EXPECT_EQ(first.players, second.players) << "level " << level;
+    EXPECT_EQ(first.enemies.size(), second.enemies.size()) << "level " << level;
+  }
+}
+
+TEST(Server, DifferentSeedsGiveDifferentMazes)
+{
+  EXPECT_NE(Server::GenerateLevel(1, 1, MapSize).tiles.Data(), Server::GenerateLevel(1, 2, MapSize).tiles.Data());
+}
+
+TEST(Server, ExitIsReachableOnEveryLevel)
+{
+  for(int level = 0; level <= Server::MaxLevel; ++level)
+  {
+    auto generated = Server::GenerateLevel(level, 7, MapSize);
+    const Offset exit = Find(generated.tiles, Tile::TILE_EXIT);
+
+    ASSERT_FALSE(generated.players.empty());
+    EXPECT_TRUE(IsReachable(generated.tiles, generated.players.front(), exit, true)) << "level " << level;
+  }
+  EXPECT_EQ(Server::GenerateLevel(12, 7, MapSize).players.size(), 2u);
+}
+
+TEST(Server, DoorGuardsTheExit)
+{
+  auto generated = Server::GenerateLevel(2, 3, MapSize);
+  const Offset start = generated.players.front();
+
+  EXPECT_FALSE(IsReachable(generated.tiles, start, Find(generated.tiles, Tile::TILE_EXIT), false));
+  EXPECT_TRUE(IsReachable(generated.tiles, start, Find(generated.tiles, Tile::TILE_KEY_RED), false));
+}
+
+TEST(Server, ViewIsCenteredOnPlayer)
+{
+  Server::Quest quest(0, 5, MapSize, Visibility);
+  Swoq::Interface::State state;
+
+  quest.Fill(state);
+
+  ASSERT_TRUE(state.has_playerstate());
+  const auto& playerState = state.playerstate();
+  const int dimension = 2 * Visibility + 1;
+  ASSERT_EQ(playerState.surroundings_size(), dimension * dimension);
+  EXPECT_EQ(playerState.surroundings(dimension * Visibility + Visibility), Tile::TILE_PLAYER);
+  EXPECT_EQ(Offset(playerState.position()), *quest.State().PlayerPosition(0));
+  EXPECT_FALSE(state.has_player2state());
+}
+
+TEST(Server, WallsBlockMoves)
+{
+  Server::Quest quest(0, 5, MapSize, Visibility);
+
+  ActResult result = ActResult::ACT_RESULT_OK;
+  for(int i = 0; i < MapSize.y && result == ActResult::ACT_RESULT_OK; ++i)
+  {
+    result = quest.Act(DirectedAction::DIRECTED_ACTION_MOVE_NORTH, std::nullopt);
+  }
+
+  EXPECT_EQ(result, ActResult::ACT_RESULT_MOVE_NOT_ALLOWED);
+  EXPECT_EQ(quest.State().PlayerPosition(0)->y, 1);
+}
+
+TEST(Server, TrainingEndsAtTheExit)
+{
+  Server::Quest quest(0, 11, MapSize, Visibility);
+
+  WalkToExit(quest, 11);
+
+  EXPECT_EQ(quest.Status(), GameStatus::GAME_STATUS_FINISHED_SUCCESS);
+  EXPECT_EQ(quest.Act(DirectedAction::DIRECTED_ACTION_MOVE_NORTH, std::nullopt), ActResult::ACT_RESULT_GAME_FINISHED);
+}
+
+TEST(Server, QuestContinuesWithTheNextLevel)
+{
+  Server::Quest quest(std::nullopt, 11, MapSize, Visibility);
+
+  WalkToExit(quest, 11);
+
+  EXPECT_EQ(quest.Status(), GameStatus::GAME_STATUS_ACTIVE);
+  EXPECT_EQ(quest.LevelNumber(), 1);
+}
+
+TEST(Server, SecondPlayerIsNotPresentBeforeLevel12)
+{
+  Server::Quest quest(0, 5, MapSize, Visibility);
+
+  EXPECT_EQ(
+    quest.Act(std::nullopt, DirectedAction::DIRECTED_ACTION_MOVE_NORTH), ActResult::ACT_RESULT_PLAYER2_NOT_PRESENT);
+}
+
+TEST(Server, ActAfterTheGameFinishedReportsGameFinished)
+{
+  Server::GameService service(Server::ServerOptions{MapSize, Visibility});
+  Swoq::Interface::StartRequest start;
+  start.set_level(0);
+  start.set_seed(11);
+  Swoq::Interface::StartResponse started;
+  ASSERT_TRUE(service.Start(nullptr, &start, &started).ok());
+
+  // Mirrors the game in a local quest to know where the player is
+  const Offset exit = Find(Server::GenerateLevel(0, 11, MapSize).tiles, Tile::TILE_EXIT);
+  Server::Quest quest(0, 11, MapSize, Visibility);
+  Swoq::Interface::ActRequest act;
+  act.set_gameid(started.gameid());
+  Swoq::Interface::ActResponse acted;
+  while(auto position = quest.State().PlayerPosition(0))
+  {
+    act.set_action(StepTowards(*position, exit));
+    quest.Act(act.action(), std::nullopt);
+    ASSERT_TRUE(service.Act(nullptr, &act, &acted).ok());
+    ASSERT_EQ(acted.result(), ActResult::ACT_RESULT_OK);
+  }
+  ASSERT_EQ(acted.state().status(), GameStatus::GAME_STATUS_FINISHED_SUCCESS);
+
+  ASSERT_TRUE(service.Act(nullptr, &act, &acted).ok());
+  EXPECT_EQ(acted.result(), ActResult::ACT_RESULT_GAME_FINISHED);
+
+  act.set_gameid("no-such-game");
+  ASSERT_TRUE(service.Act(nullptr, &act, &acted).ok());
+  EXPECT_EQ(acted.result(), ActResult::ACT_RESULT_UNKNOWN_GAME_ID);
+}
+
+TEST(Server, NegativeSeedsAreReportedBackUnchanged)
+{
+  Server::GameService service(Server::ServerOptions{MapSize, Visibility});
+  Swoq::Interface::StartRequest start;
+  start.set_seed(-5);
+  Swoq::Interface::StartResponse started;
+
+  ASSERT_TRUE(service.Start(nullptr, &start, &started).ok());
+
+  EXPECT_EQ(started.result(), Swoq::Interface::StartResult::START_RESULT_OK);
+  EXPECT_EQ(started.seed(), -5);
+}
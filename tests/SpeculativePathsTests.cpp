@@ -0,0 +1,74 @@
+#include "SpeculativePaths.h"
+
+#include <gtest/gtest.h>
+
+#include "PlayerMap.h"
+
+using Bot::PlayerMap;
+using Bot::SpeculativePaths;
+
+namespace
+{
+  const std::vector<Offset> ReversedPath{{3, 1}, {2, 1}};
+  constexpr Offset Start{1, 1};
+  constexpr std::uint64_t Serial = 7;
+} // namespace
+
+TEST(SpeculativePaths, UsesThePathWhenNothingChanged)
+{
+  SpeculativePaths paths;
+  const auto map = std::make_shared<const PlayerMap>(Offset{5, 3});
+  paths.Store(1, map, Start, Serial, ReversedPath);
+
+  EXPECT_EQ(paths.Take(0, map, Start, Serial), std::nullopt);
+  EXPECT_EQ(paths.Take(1, map, Start, Serial), ReversedPath);
+  EXPECT_EQ(paths.Used(), 1u);
+  EXPECT_EQ(paths.Discarded(), 0u);
+
+  // Only once
+  EXPECT_EQ(paths.Take(1, map, Start, Serial), std::nullopt);
+}
+
+TEST(SpeculativePaths, DiscardsThePathWhenThePlayerEndedUpElsewhere)
+{
+  SpeculativePaths paths;
+  const auto map = std::make_shared<const PlayerMap>(Offset{5, 3});
+  paths.Store(0, map, Start, Serial, ReversedPath);
+
+  EXPECT_EQ(paths.Take(0, map, Offset{2, 1}, Serial), std::nullopt);
+  EXPECT_EQ(paths.Discarded(), 1u);
+
+  // Thrown away, so the next tick plans from scratch without counting it again
+  EXPECT_EQ(paths.Take(0, map, Start, Serial), std::nullopt);
+  EXPECT_EQ(paths.Discarded(), 1u);
+  EXPECT_EQ(paths.Used(), 0u);
+}
+
+TEST(SpeculativePaths, DiscardsThePathWhenTheMapOrTheCommandChanged)
+{
+  SpeculativePaths paths;
+  const auto map = std::make_shared<const PlayerMap>(Offset{5, 3});
+  const auto newMap = std::make_shared<const PlayerMap>(Offset{5, 3});
+
+  paths.Store(0, map, Start, Serial, ReversedPath);
+  EXPECT_EQ(paths.Take(0, newMap, Start, Serial), std::nullopt);
+
+  paths.Store(0, map, Start, Serial, ReversedPath);
+  EXPECT_EQ(paths.Take(0, map, Start, Serial + 1), std::nullopt);
+
+  EXPECT_EQ(paths.Discarded(), 2u);
+  EXPECT_EQ(paths.Used(), 0u);
+}
+
+TEST(SpeculativePaths, ClearForgetsAllPaths)
+{
+  SpeculativePaths paths;
+  const auto map = std::make_shared<const PlayerMap>(Offset{5, 3});
+  paths.Store(0, map, Start, Serial, ReversedPath);
+  paths.Store(1, map, Start, Serial, ReversedPath);
+  paths.Clear();
+
+  EXPECT_EQ(paths.Take(0, map, Start, Serial), std::nullopt);
+  EXPECT_EQ(paths.Take(1, map, Start, Serial), std::nullopt);
+  EXPECT_EQ(paths.Discarded(), 0u);
+}
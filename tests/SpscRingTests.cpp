@@ -0,0 +1,74 @@
+#include "SpscRing.h"
+
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using Bot::SpscRing;
+
+TEST(SpscRing, PopsInPushOrder)
+{
+  SpscRing<int, 4> ring;
+  EXPECT_TRUE(ring.Empty());
+  EXPECT_TRUE(ring.TryPush(1));
+  EXPECT_TRUE(ring.TryPush(2));
+  EXPECT_EQ(ring.TryPop(), 1);
+  EXPECT_EQ(ring.TryPop(), 2);
+  EXPECT_EQ(ring.TryPop(), std::nullopt);
+}
+
+TEST(SpscRing, RejectsPushWhenFull)
+{
+  SpscRing<std::unique_ptr<int>, 2> ring;
+  EXPECT_TRUE(ring.TryPush(std::make_unique<int>(1)));
+  EXPECT_TRUE(ring.TryPush(std::make_unique<int>(2)));
+
+  auto value = std::make_unique<int>(3);
+  EXPECT_FALSE(ring.TryPush(std::move(value)));
+  ASSERT_TRUE(value);
+  EXPECT_EQ(*value, 3);
+}
+
+TEST(SpscRing, SequenceNumbersKeepCounting)
+{
+  SpscRing<int, 2> ring;
+  for(int i = 0; i < 5; ++i)
+  {
+    EXPECT_TRUE(ring.TryPush(int{i}));
+    EXPECT_EQ(ring.TryPop(), i);
+  }
+  EXPECT_EQ(ring.Published(), 5u);
+  EXPECT_EQ(ring.Consumed(), 5u);
+}
+
+TEST(SpscRing, TransfersAcrossThreads)
+{
+  constexpr int Count = 10000;
+  SpscRing<int, 8> ring;
+
+  std::jthread producer(
+    [&]
+    {
+      for(int i = 0; i < Count; ++i)
+      {
+        while(!ring.TryPush(int{i}))
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+
+  for(int expected = 0; expected < Count;)
+  {
+    if(auto value = ring.TryPop())
+    {
+      ASSERT_EQ(*value, expected);
+      ++expected;
+    }
+    else
+    {
+      std::this_thread::yield();
+    }
+  }
+}
@@ -0,0 +1,101 @@
+#include "TaskPool.h"
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using Bot::TaskPool;
+
+TEST(TaskPool, SubmitReturnsResult)
+{
+  TaskPool pool(2);
+  auto handle = pool.Submit([] { return 42; });
+  EXPECT_EQ(handle.Get(), 42);
+}
+
+TEST(TaskPool, VoidTasksRun)
+{
+  TaskPool pool(2);
+  std::atomic<int> counter = 0;
+  std::vector<Bot::TaskHandle<void>> handles;
+  for(int i = 0; i < 100; ++i)
+  {
+    handles.push_back(pool.Submit([&] { ++counter; }));
+  }
+  for(auto& handle: handles)
+  {
+    handle.Get();
+  }
+  EXPECT_EQ(counter, 100);
+}
+
+TEST(TaskPool, ExceptionsPropagateToGet)
+{
+  TaskPool pool(1);
+  auto handle = pool.Submit([]() -> int { throw std::runtime_error("failed"); });
+  EXPECT_THROW(handle.Get(), std::runtime_error);
+}
+
+TEST(TaskPool, NestedFanOutDoesNotDeadlockOnSingleWorker)
+{
+  TaskPool pool(1);
+  auto outer = pool.Submit(
+    [&]
+    {
+      auto inner = pool.Submit([] { return 1; });
+      return inner.Get() + 1;
+    });
+  EXPECT_EQ(outer.Get(), 2);
+}
+
+TEST(TaskPool, ParallelInvokeReturnsAllResults)
+{
+  TaskPool pool(2);
+  auto [a, b, c] = Bot::ParallelInvoke(pool, [] { return 1; }, [] { return std::string("two"); }, [] { return 3.0; });
+  EXPECT_EQ(a, 1);
+  EXPECT_EQ(b, "two");
+  EXPECT_EQ(c, 3.0);
+}
+
+TEST(TaskPool, ParallelTransformKeepsOrder)
+{
+  TaskPool pool(3);
+  std::vector<int> input(50);
+  std::iota(input.begin(), input.end(), 0);
+
+  auto result = Bot::ParallelTransform(pool, input, [](int i) { return i * i; });
+
+  ASSERT_EQ(result.size(), input.size());
+  for(std::size_t i = 0; i < input.size(); ++i)
+  {
+    EXPECT_EQ(result[i], input[i] * input[i]);
+  }
+}
+
+TEST(TaskPool, SharedPoolIsCreatedOnce)
+{
+  auto pool = TaskPool::Shared();
+  ASSERT_NE(pool, nullptr);
+  EXPECT_EQ(pool, TaskPool::Shared());
+  EXPECT_EQ(pool->WorkerCount(), TaskPool::DefaultWorkerCount());
+}
+
+TEST(TaskPool, TasksLogForTheGameThatSubmittedThem)
+{
+  TaskPool pool(2);
+  const Bot::Log::GameScope game(5);
+  EXPECT_EQ(pool.Submit([] { return Bot::Log::CurrentGame(); }).Get(), 5u);
+  EXPECT_EQ(Bot::Log::CurrentGame(), 5u);
+}
+
+TEST(TaskPool, TasksCountAllocationsForThePhaseThatSubmittedThem)
+{
+  TaskPool pool(2);
+  const Bot::Allocations::Scope phase(Bot::Allocations::Phase::Dijkstra);
+  EXPECT_EQ(pool.Submit([] { return Bot::Allocations::Current(); }).Get(), Bot::Allocations::Phase::Dijkstra);
+  EXPECT_EQ(Bot::Allocations::Current(), Bot::Allocations::Phase::Dijkstra);
+}
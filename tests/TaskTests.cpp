@@ -0,0 +1,102 @@
+#include "Task.hpp"
+
+#include <chrono>
+#include <coroutine>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <grpcpp/alarm.h>
+#include <gtest/gtest.h>
+
+#include "Swoq.hpp"
+
+using Swoq::Task;
+
+namespace
+{
+  Task<int> Value(int value) { co_return value; }
+
+  Task<int> Sum(int a, int b) { co_return co_await Value(a) + co_await Value(b); }
+
+  Task<int> Throws()
+  {
+    throw std::runtime_error("failed");
+    co_return 0;
+  }
+
+  // Resumes the awaiting coroutine on another thread, like a completion queue would
+  struct ResumeOnOtherThread
+  {
+    std::jthread& thread;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+      // The coroutine may be gone as soon as the thread starts, so don't touch this awaiter afterwards
+      std::jthread& target = thread;
+      target = std::jthread([handle] { handle.resume(); });
+    }
+    void await_resume() const noexcept {}
+  };
+
+  Task<std::string> Hop(std::jthread& thread)
+  {
+    co_await ResumeOnOtherThread{thread};
+    co_return "done";
+  }
+} // namespace
+
+TEST(Task, SyncWaitReturnsValue) { EXPECT_EQ(Swoq::sync_wait(Value(3)), 3); }
+
+TEST(Task, TasksCanAwaitTasks) { EXPECT_EQ(Swoq::sync_wait(Sum(1, 2)), 3); }
+
+TEST(Task, ExceptionsPropagate) { EXPECT_THROW(Swoq::sync_wait(Throws()), std::runtime_error); }
+
+TEST(Task, TaskIsLazy)
+{
+  bool started = false;
+  // The lambda has to outlive the coroutine, since the coroutine refers to its captures
+  auto coroutine = [&]() -> Task<int>
+  {
+    started = true;
+    co_return 1;
+  };
+  auto task = coroutine();
+  EXPECT_FALSE(started);
+  EXPECT_EQ(Swoq::sync_wait(std::move(task)), 1);
+  EXPECT_TRUE(started);
+}
+
+TEST(Task, LaunchCompletesOnResumingThread)
+{
+  std::jthread thread;
+  auto future = Swoq::launch(Hop(thread));
+  EXPECT_EQ(future.get(), "done");
+}
+
+TEST(CompletionQueueDriver, LastOwnerMayLetGoOnTheDriverThread)
+{
+  using namespace std::chrono_literals;
+
+  struct Release final : Swoq::CompletionQueueDriver::Operation
+  {
+    std::shared_ptr<Swoq::CompletionQueueDriver> driver = std::make_shared<Swoq::CompletionQueueDriver>();
+    std::promise<void> released;
+
+    void complete(bool /*ok*/) override
+    {
+      driver.reset();
+      released.set_value();
+    }
+  };
+
+  Release release;
+  auto released = release.released.get_future();
+  grpc::Alarm alarm;
+  auto* operation = static_cast<Swoq::CompletionQueueDriver::Operation*>(&release);
+  alarm.Set(release.driver->queue(), std::chrono::system_clock::now(), operation);
+  EXPECT_EQ(released.wait_for(10s), std::future_status::ready);
+}
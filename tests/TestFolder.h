@@ -0,0 +1,44 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <format>
+#include <string>
+#include <string_view>
+
+#include <unistd.h>
+
+// An empty folder for the files of the current test, removed with everything in it at the end of the scope. The name
+// holds the test and the process, so tests that run at the same time, in one binary or several, don't share files.
+class TestFolder
+{
+public:
+  TestFolder()
+    : m_path(std::filesystem::path(testing::TempDir()) / Name())
+  {
+    std::filesystem::remove_all(m_path);
+    std::filesystem::create_directories(m_path);
+  }
+
+  ~TestFolder()
+  {
+    std::error_code error;
+    std::filesystem::remove_all(m_path, error);
+  }
+
+  TestFolder(const TestFolder&) = delete;
+  TestFolder& operator=(const TestFolder&) = delete;
+
+  [[nodiscard]] const std::filesystem::path& Path() const { return m_path; }
+  std::filesystem::path operator/(std::string_view name) const { return m_path / name; }
+
+private:
+  static std::string Name()
+  {
+    const auto* test = testing::UnitTest::GetInstance()->current_test_info();
+    return std::format("swoq-{}-{}-{}", test ? test->test_suite_name() : "global", test ? test->name() : "", getpid());
+  }
+
+  std::filesystem::path m_path;
+};
@@ -1,8 +1,13 @@
 #include "ThreadSafe.h"
 
+#include <chrono>
+#include <future>
 #include <memory>
+#include <thread>
 #include <type_traits>
 
+#include <gtest/gtest.h>
+
 struct StarTS
 {
   int operator*() const { return 0; }
@@ -36,3 +41,69 @@ static_assert(std::is_same_v<decltype(std::declval<ProxyStar&>().operator->()),
 
 static_assert(std::is_same_v<decltype(*std::declval<ProxyArrow&>()), ArrowTS&>);
 static_assert(std::is_same_v<decltype(std::declval<ProxyArrow&>().operator->()), int*>);
+
+using ReadProxyInt    = Bot::ThreadSafeReadProxy<int>;
+using WriteProxyInt   = Bot::ThreadSafeWriteProxy<int>;
+using ReadProxyUPtr   = Bot::ThreadSafeReadProxy<std::unique_ptr<int>>;
+using WriteProxyArrow = Bot::ThreadSafeWriteProxy<ArrowTS>;
+
+static_assert(std::is_same_v<decltype(*std::declval<ReadProxyInt&>()), const int&>);
+static_assert(std::is_same_v<decltype(std::declval<ReadProxyInt&>().operator->()), const int*>);
+static_assert(std::is_same_v<decltype(*std::declval<WriteProxyInt&>()), int&>);
+static_assert(std::is_same_v<decltype(*std::declval<const WriteProxyInt&>()), const int&>);
+static_assert(std::is_same_v<decltype(*std::declval<ReadProxyUPtr&>()), int&>);
+static_assert(std::is_same_v<decltype(std::declval<WriteProxyArrow&>().operator->()), int*>);
+static_assert(std::is_same_v<decltype(std::declval<const WriteProxyArrow&>().operator->()), const ArrowTS*>);
+
+TEST(SharedThreadSafe, ReadersShareTheLock)
+{
+  using namespace std::chrono_literals;
+  Bot::SharedThreadSafe<int> value(42);
+  std::promise<int> secondRead;
+  auto future = secondRead.get_future();
+
+  // Declared before the first reader, so it is joined after that reader is released
+  std::jthread reader;
+  auto first = value.Read();
+  reader = std::jthread([&] { secondRead.set_value(*value.Read()); });
+
+  ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+  EXPECT_EQ(future.get(), 42);
+  EXPECT_EQ(*first, 42);
+}
+
+TEST(SharedThreadSafe, ConstAccessIsNotAChange)
+{
+  Bot::SharedThreadSafe<int> value(1);
+  auto proxy = value.Write();
+  const auto& constProxy = proxy;
+  EXPECT_EQ(*constProxy, 1);
+  EXPECT_FALSE(proxy.Changed());
+  proxy = 2;
+  EXPECT_TRUE(proxy.Changed());
+}
+
+TEST(SharedThreadSafe, WaiterSeesWrite)
+{
+  using namespace std::chrono_literals;
+  Bot::SharedThreadSafe<int> value(0);
+
+  std::jthread writer(
+    [&]
+    {
+      std::this_thread::sleep_for(10ms);
+      value.Write() = 1;
+    });
+
+  auto proxy = value.Read();
+  EXPECT_TRUE(proxy.WaitUntil(std::chrono::steady_clock::now() + 10s, [&] { return *proxy == 1; }));
+}
+
+TEST(SharedThreadSafe, WaitTimesOutWithoutChange)
+{
+  using namespace std::chrono_literals;
+  Bot::SharedThreadSafe<int> value(0);
+
+  auto proxy = value.Read();
+  EXPECT_FALSE(proxy.WaitUntil(std::chrono::steady_clock::now() + 20ms, [&] { return *proxy == 1; }));
+}
@@ -0,0 +1,67 @@
+#include "Tracing.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "TestFolder.h"
+
+namespace
+{
+  using namespace Bot;
+
+  std::string ReadFile(const std::string& path)
+  {
+    std::ifstream stream(path);
+    return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+  }
+} // namespace
+
+TEST(Tracing, WritesCompleteEventsPerTrack)
+{
+  const TestFolder folder;
+  const auto path = (folder / "trace.json").string();
+  {
+    auto trace = Tracing::TraceFile::Open(path, "game-1");
+    ASSERT_TRUE(trace) << trace.error();
+
+    const auto start = Tracing::Clock::now();
+    (*trace)->Complete(Tracing::PlanTrack(1), "Explore", start, start + std::chrono::microseconds(1500), R"({"done":true})");
+    {
+      Tracing::ScopedSpan span(trace->get(), Tracing::Track::GameLoop, "Tick");
+      span.SetArgs(R"({"tick":3})");
+    }
+    Tracing::ScopedSpan disabled(nullptr, Tracing::Track::GameLoop, "Ignored");
+    EXPECT_FALSE(disabled.Enabled());
+  }
+
+  const auto contents = ReadFile(path);
+  EXPECT_TRUE(contents.starts_with(R"({"displayTimeUnit":"ms","traceEvents":[)"));
+  EXPECT_TRUE(contents.ends_with("\n]}\n"));
+  EXPECT_NE(contents.find(R"("args":{"name":"Game game-1"})"), std::string::npos);
+  EXPECT_NE(contents.find(R"("name":"Explore","ph":"X")"), std::string::npos);
+  EXPECT_NE(contents.find(R"("dur":1500.000,"pid":3,"tid":1,"args":{"done":true})"), std::string::npos) << contents;
+  EXPECT_NE(contents.find(R"("name":"Tick","ph":"X")"), std::string::npos);
+  EXPECT_NE(contents.find(R"("pid":1,"tid":1,"args":{"tick":3})"), std::string::npos);
+  EXPECT_EQ(contents.find("Ignored"), std::string::npos);
+}
+
+TEST(Tracing, EscapesNames)
+{
+  const TestFolder folder;
+  const auto path = (folder / "trace.json").string();
+  {
+    auto trace = Tracing::TraceFile::Open(path, "\"quoted\"");
+    ASSERT_TRUE(trace);
+    (*trace)->Instant(Tracing::Track::Grpc, "back\\slash");
+  }
+
+  const auto contents = ReadFile(path);
+  EXPECT_NE(contents.find(R"("args":{"name":"Game \"quoted\""})"), std::string::npos);
+  EXPECT_NE(contents.find(R"("name":"back\\slash","ph":"i")"), std::string::npos);
+}
+
+TEST(Tracing, ReportsFilesThatCannotBeOpened)
+{
+  EXPECT_FALSE(Tracing::TraceFile::Open("/proc/no-such-folder/trace.json", "game"));
+}
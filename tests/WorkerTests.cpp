@@ -0,0 +1,156 @@
+#include "Worker.h"
+
+#include <gtest/gtest.h>
+
+#include <csignal>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <print>
+
+#include <unistd.h>
+
+#include "TestFolder.h"
+
+using namespace std::chrono_literals;
+
+TEST(Worker, WorkItemRoundTrip)
+{
+  const Bot::WorkItem item{7, 3, std::nullopt};
+
+  auto parsed = Bot::ParseWorkItem(Bot::ToLine(item));
+
+  ASSERT_TRUE(parsed);
+  EXPECT_EQ(parsed->index, 7u);
+  EXPECT_EQ(parsed->level, 3);
+  EXPECT_EQ(parsed->seed, std::nullopt);
+}
+
+TEST(Worker, RecordRoundTrip)
+{
+  Bot::GameResult result;
+  result.index = 4;
+  result.gameId = "abc";
+  result.seed = 42;
+  result.level = 9;
+  result.success = false;
+  result.error = "Act failed\twith\na tab";
+  result.duration = 1234ms;
+
+  auto parsed = Bot::ParseRecord(Bot::ToRecord(result));
+
+  ASSERT_TRUE(parsed);
+  EXPECT_EQ(parsed->index, 4u);
+  EXPECT_EQ(parsed->gameId, "abc");
+  EXPECT_EQ(parsed->seed, 42);
+  EXPECT_EQ(parsed->level, 9);
+  EXPECT_FALSE(parsed->success);
+  EXPECT_EQ(parsed->error, "Act failed with a tab");
+  EXPECT_EQ(parsed->duration, 1234ms);
+}
+
+TEST(Worker, MalformedLinesAreRejected)
+{
+  EXPECT_FALSE(Bot::ParseWorkItem("1\tx\t-"));
+  EXPECT_FALSE(Bot::ParseWorkItem("1\t2"));
+  EXPECT_FALSE(Bot::ParseRecord("1\tabc\t2"));
+}
+
+TEST(Worker, LineReaderSplitsLines)
+{
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  ASSERT_TRUE(Bot::WriteLine(fds[1], "first"));
+  ASSERT_TRUE(Bot::WriteLine(fds[1], "second"));
+  close(fds[1]);
+
+  Bot::LineReader reader(fds[0]);
+  EXPECT_EQ(reader.Pop(), std::nullopt);
+  while(reader.Fill())
+  {
+  }
+  EXPECT_EQ(reader.Pop(), "first");
+  EXPECT_EQ(reader.Pop(), "second");
+  EXPECT_EQ(reader.Pop(), std::nullopt);
+  close(fds[0]);
+}
+
+namespace
+{
+  // A worker that plays every game instantly, except game crashIndex, on which it exits with status 3
+  std::filesystem::path FakeBot(const TestFolder& folder, std::size_t crashIndex)
+  {
+    auto path = folder / "bot.sh";
+    std::ofstream script(path);
+    std::println(script, "#!/bin/sh");
+    std::println(script, "fd=$SWOQ_WORKER_FD");
+    std::println(script, "while read -r index level seed <&$fd; do");
+    std::println(script, "  [ \"$index\" = {} ] && exit 3", crashIndex);
+    std::println(script, "  printf '%s\\tgame-%s\\t%s\\t5\\t1\\t10\\t\\n' \"$index\" \"$index\" \"$seed\" >&$fd");
+    std::println(script, "done");
+    script.close();
+    std::filesystem::permissions(path, std::filesystem::perms::owner_all | std::filesystem::perms::group_read);
+    return path;
+  }
+
+  std::vector<Bot::WorkItem> Items(std::size_t count)
+  {
+    std::vector<Bot::WorkItem> items;
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      items.push_back({i, std::nullopt, static_cast<int>(100 + i)});
+    }
+    return items;
+  }
+} // namespace
+
+TEST(Supervisor, CollectsEveryGameSortedByIndex)
+{
+  std::signal(SIGPIPE, SIG_IGN);
+  const TestFolder folder;
+  const auto bot = FakeBot(folder, 1000);
+
+  auto results = Bot::Supervise(Items(10), {bot, 3, std::nullopt});
+
+  ASSERT_EQ(results.size(), 10u);
+  for(std::size_t i = 0; i < results.size(); ++i)
+  {
+    EXPECT_EQ(results[i].index, i);
+    EXPECT_EQ(results[i].gameId, std::format("game-{}", i));
+    EXPECT_EQ(results[i].seed, static_cast<int>(100 + i));
+    EXPECT_TRUE(results[i].success);
+  }
+}
+
+TEST(Supervisor, RestartsWorkerThatDies)
+{
+  std::signal(SIGPIPE, SIG_IGN);
+  const TestFolder folder;
+  const auto bot = FakeBot(folder, 1);
+
+  auto results = Bot::Supervise(Items(4), {bot, 1, std::nullopt});
+
+  ASSERT_EQ(results.size(), 4u);
+  EXPECT_FALSE(results[1].success);
+  EXPECT_EQ(results[1].seed, 101);
+  EXPECT_EQ(results[1].error, "worker exited with status 3");
+  // The games after the crash are played by the replacement worker
+  EXPECT_TRUE(results[0].success);
+  EXPECT_TRUE(results[2].success);
+  EXPECT_TRUE(results[3].success);
+}
+
+TEST(Supervisor, NoGameSucceedsWhenTheBotCannotBeExecuted)
+{
+  std::signal(SIGPIPE, SIG_IGN);
+
+  auto results = Bot::Supervise(Items(3), {std::filesystem::path(testing::TempDir()) / "no-such-bot", 2, std::nullopt});
+
+  // Depending on when the exec fails, a game is recorded as failed or the supervisor gives up on it
+  EXPECT_LE(results.size(), 3u);
+  for(const auto& result: results)
+  {
+    EXPECT_FALSE(result.success);
+    EXPECT_EQ(result.error, "worker exited with status 127");
+  }
+}